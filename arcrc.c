@@ -0,0 +1,135 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * arcrc.c - AccurateRip v1/v2 and CRC-32 track checksums
+ */
+
+#include "arcrc.h"
+
+/* Samples excluded at the start of the first / end of the last track */
+#define AR_SKIP_SAMPLES (5 * SAMPLES_PER_FRAME)
+
+/* Independent accumulator lanes; wide enough for 4 x 32-bit SIMD lanes */
+#define AR_LANES 4
+
+/* Slicing-by-8 tables for the reflected IEEE polynomial */
+static uint32_t crc_table[8][256];
+static bool crc_table_ready;
+
+static void crc_table_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int j = 0; j < 8; j++)
+            c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+        crc_table[0][i] = c;
+    }
+    for (int t = 1; t < 8; t++) {
+        for (int i = 0; i < 256; i++)
+            crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^
+                              crc_table[0][crc_table[t - 1][i] & 0xFF];
+    }
+    crc_table_ready = true;
+}
+
+static uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * CRC-32 update (state is kept inverted between calls)
+ */
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t len)
+{
+    while (len >= 8) {
+        uint32_t lo = crc ^ load_le32(p);
+        uint32_t hi = load_le32(p + 4);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+              crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^
+              crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+
+    return crc;
+}
+
+/*
+ * AccurateRip kernel over n samples starting at position mult
+ * Lanes carry no dependency on each other, so the compiler maps the
+ * main loop onto SIMD widening multiplies (pmuludq, umull)
+ */
+static void ar_kernel(const uint8_t *pcm, size_t n, uint32_t mult,
+                      uint32_t *v1, uint32_t *v2)
+{
+    uint32_t lo[AR_LANES] = { 0 };
+    uint32_t hi[AR_LANES] = { 0 };
+    size_t i = 0;
+
+    for (; i + AR_LANES <= n; i += AR_LANES) {
+        for (int l = 0; l < AR_LANES; l++) {
+            uint64_t p = (uint64_t)load_le32(pcm + 4 * (i + l)) * (uint32_t)(mult + i + l);
+            lo[l] += (uint32_t)p;
+            hi[l] += (uint32_t)(p >> 32);
+        }
+    }
+    for (; i < n; i++) {
+        uint64_t p = (uint64_t)load_le32(pcm + 4 * i) * (uint32_t)(mult + i);
+        lo[0] += (uint32_t)p;
+        hi[0] += (uint32_t)(p >> 32);
+    }
+
+    uint32_t sum_lo = 0, sum_hi = 0;
+    for (int l = 0; l < AR_LANES; l++) {
+        sum_lo += lo[l];
+        sum_hi += hi[l];
+    }
+    *v1 += sum_lo;
+    *v2 += sum_lo + sum_hi;
+}
+
+void arcrc_init(arcrc_t *c, uint32_t samples, bool first, bool last)
+{
+    if (!crc_table_ready)
+        crc_table_init();
+
+    c->v1 = 0;
+    c->v2 = 0;
+    c->crc32 = 0xFFFFFFFFu;
+    c->mult = 1;
+    c->first = first ? AR_SKIP_SAMPLES : 1;
+    c->last = samples;
+    if (last)
+        c->last = samples > AR_SKIP_SAMPLES ? samples - AR_SKIP_SAMPLES : 0;
+}
+
+void arcrc_update(arcrc_t *c, const uint8_t *pcm, size_t samples)
+{
+    if (samples == 0)
+        return;
+
+    c->crc32 = crc32_update(c->crc32, pcm, samples * 4);
+
+    uint32_t from = c->mult;
+    uint32_t to = c->mult + (uint32_t)samples - 1;
+    uint32_t a = from > c->first ? from : c->first;
+    uint32_t b = to < c->last ? to : c->last;
+    if (a <= b)
+        ar_kernel(pcm + (size_t)(a - from) * 4, b - a + 1, a, &c->v1, &c->v2);
+
+    c->mult += (uint32_t)samples;
+}
+
+void arcrc_finish(const arcrc_t *c, track_crc_t *out)
+{
+    out->valid = true;
+    out->ar_v1 = c->v1;
+    out->ar_v2 = c->v2;
+    out->crc32 = ~c->crc32;
+}
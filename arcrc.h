@@ -0,0 +1,50 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * arcrc.h - AccurateRip v1/v2 and CRC-32 track checksums
+ *
+ * Samples are 32-bit little-endian stereo words (left in the low half).
+ * With m the 1-based sample position within the track:
+ *
+ *   v1 = sum(low32(s * m))
+ *   v2 = sum(low32(s * m) + high32(s * m))
+ *
+ * modulo 2^32. The first 5 frames less one sample of the first audio
+ * track and the last 5 frames of the last audio track are excluded.
+ * CRC-32 (IEEE, as EAC reports it) covers every byte of the track.
+ */
+
+#ifndef MBDISCID_ARCRC_H
+#define MBDISCID_ARCRC_H
+
+#include "types.h"
+#include <stddef.h>
+
+/* Running checksum state for one track */
+typedef struct {
+    uint32_t v1;
+    uint32_t v2;
+    uint32_t crc32;
+    uint32_t mult;          /* Position of the next sample (1-based) */
+    uint32_t first;         /* First position included in v1/v2 */
+    uint32_t last;          /* Last position included in v1/v2 */
+} arcrc_t;
+
+/*
+ * Start a track of the given length in samples
+ * first/last: track is the first/last audio track of the disc
+ */
+void arcrc_init(arcrc_t *c, uint32_t samples, bool first, bool last);
+
+/*
+ * Feed the next samples of the track, in order
+ */
+void arcrc_update(arcrc_t *c, const uint8_t *pcm, size_t samples);
+
+/*
+ * Store the final checksums
+ */
+void arcrc_finish(const arcrc_t *c, track_crc_t *out);
+
+#endif /* MBDISCID_ARCRC_H */
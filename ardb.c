@@ -0,0 +1,162 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * ardb.c - Local AccurateRip database (dBAR file) lookup
+ *
+ * The file is mapped and validated once; entries are then decoded in
+ * place, since every pressing of a disc has the same fixed-size layout.
+ */
+
+#include "ardb.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Pressing header: track count, disc ID 1, disc ID 2, FreeDB ID */
+#define ARDB_HEADER_SIZE 13
+
+/* Per track: confidence, CRC, frame 450 CRC */
+#define ARDB_TRACK_SIZE  9
+
+static uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Map path read-only
+ * Returns 0 on success, errno on failure
+ */
+static int map_file(const char *path, ardb_t *db)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return errno;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+
+    db->size = (size_t)st.st_size;
+    if (db->size > 0) {
+        void *p = mmap(NULL, db->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            int err = errno;
+            close(fd);
+            return err;
+        }
+        db->data = p;
+    }
+
+    close(fd);
+    return 0;
+}
+
+int ardb_open(ardb_t *db, const char *dir, const char *ar_id, int verbosity)
+{
+    memset(db, 0, sizeof(*db));
+
+    int count;
+    uint32_t id1, id2, cddb;
+    if (sscanf(ar_id, "%3d-%8x-%8x-%8x", &count, &id1, &id2, &cddb) != 4) {
+        error("ardb: invalid AccurateRip ID: %s", ar_id);
+        return EX_SOFTWARE;
+    }
+
+    struct stat st;
+    if (stat(dir, &st) < 0 || !S_ISDIR(st.st_mode)) {
+        error("ardb: cannot open %s", dir);
+        return EX_NOINPUT;
+    }
+
+    /* Server layout first, then everything in one directory */
+    size_t len = strlen(dir) + AR_ID_LENGTH + 32;
+    char *path = xmalloc(len);
+    snprintf(path, len, "%s/%x/%x/%x/dBAR-%s.bin", dir,
+             id1 & 0xF, (id1 >> 4) & 0xF, (id1 >> 8) & 0xF, ar_id);
+
+    int err = map_file(path, db);
+    if (err == ENOENT) {
+        snprintf(path, len, "%s/dBAR-%s.bin", dir, ar_id);
+        err = map_file(path, db);
+    }
+
+    if (err == ENOENT) {
+        verbose(1, verbosity, "ardb: no entry for %s", ar_id);
+        free(path);
+        return 0;
+    }
+    if (err != 0) {
+        error("ardb: cannot read %s: %s", path, strerror(err));
+        free(path);
+        return EX_NOINPUT;
+    }
+
+    /* Validate every pressing so entries can be indexed directly */
+    size_t stride = ARDB_HEADER_SIZE + (size_t)count * ARDB_TRACK_SIZE;
+    for (size_t pos = 0; pos < db->size; pos += stride) {
+        const uint8_t *h = db->data + pos;
+
+        if (db->size - pos < stride || h[0] != count ||
+            load_le32(h + 1) != id1 || load_le32(h + 5) != id2 ||
+            load_le32(h + 9) != cddb) {
+            error("ardb: %s: malformed at byte %zu", path, pos);
+            ardb_close(db);
+            free(path);
+            return EX_DATAERR;
+        }
+        db->pressings++;
+    }
+    db->tracks = count;
+
+    verbose(1, verbosity, "ardb: %s: %d pressings", path, db->pressings);
+
+    free(path);
+    return 0;
+}
+
+void ardb_entry(const ardb_t *db, int pressing, int track, ardb_entry_t *entry)
+{
+    size_t stride = ARDB_HEADER_SIZE + (size_t)db->tracks * ARDB_TRACK_SIZE;
+    const uint8_t *t = db->data + (size_t)pressing * stride + ARDB_HEADER_SIZE +
+                       (size_t)track * ARDB_TRACK_SIZE;
+
+    entry->confidence = t[0];
+    entry->crc = load_le32(t + 1);
+    entry->frame450 = load_le32(t + 5);
+}
+
+int ardb_confidence(const ardb_t *db, int track, uint32_t v1, uint32_t v2)
+{
+    int total = 0;
+
+    if (!db->data || track < 0 || track >= db->tracks)
+        return 0;
+
+    for (int p = 0; p < db->pressings; p++) {
+        ardb_entry_t e;
+        ardb_entry(db, p, track, &e);
+        if (e.crc == v1 || e.crc == v2)
+            total += e.confidence;
+    }
+
+    return total;
+}
+
+void ardb_close(ardb_t *db)
+{
+    if (db->data)
+        munmap((void *)db->data, db->size);
+    memset(db, 0, sizeof(*db));
+}
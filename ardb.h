@@ -0,0 +1,63 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * ardb.h - Local AccurateRip database (dBAR file) lookup
+ *
+ * A mirror keeps the layout of the AccurateRip server:
+ *
+ *   DIR/a/b/c/dBAR-NNN-XXXXXXXX-XXXXXXXX-XXXXXXXX.bin
+ *
+ * where a, b and c are the last three hex digits of disc ID 1, lowest
+ * first. A file is a sequence of pressings, each a 13-byte header
+ * (track count, disc ID 1, disc ID 2, FreeDB ID) followed by 9 bytes
+ * per audio track (confidence, CRC, frame 450 CRC), little-endian.
+ */
+
+#ifndef MBDISCID_ARDB_H
+#define MBDISCID_ARDB_H
+
+#include "types.h"
+#include <stddef.h>
+
+/* One track of one pressing */
+typedef struct {
+    int confidence;         /* Number of matching submissions */
+    uint32_t crc;           /* AccurateRip v1 or v2 CRC */
+    uint32_t frame450;      /* CRC of frame 450, used for offset detection */
+} ardb_entry_t;
+
+/* Mapped dBAR file */
+typedef struct {
+    const uint8_t *data;    /* NULL if the disc has no entry */
+    size_t size;
+    int pressings;
+    int tracks;             /* Audio tracks per pressing */
+} ardb_t;
+
+/*
+ * Map the dBAR file for an AccurateRip disc ID from a mirror directory
+ * The plain DIR/dBAR-*.bin layout is accepted as well
+ *
+ * Returns 0 on success (db->data is NULL if the mirror has no entry)
+ * Returns EX_NOINPUT if dir cannot be read, EX_DATAERR if the file is
+ * malformed (reported via error())
+ */
+int ardb_open(ardb_t *db, const char *dir, const char *ar_id, int verbosity);
+
+/*
+ * Decode track (0-based audio track index) of a pressing
+ */
+void ardb_entry(const ardb_t *db, int pressing, int track, ardb_entry_t *entry);
+
+/*
+ * Total confidence of pressings whose CRC for track matches v1 or v2
+ */
+int ardb_confidence(const ardb_t *db, int track, uint32_t v1, uint32_t v2);
+
+/*
+ * Unmap the file
+ */
+void ardb_close(ardb_t *db);
+
+#endif /* MBDISCID_ARDB_H */
@@ -0,0 +1,326 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * audio.c - Streaming CD-DA reads for track checksums
+ */
+
+#include "audio.h"
+#include "arcrc.h"
+#include "scsi.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* Sectors per READ CD transfer to start with (150 KB) */
+#define AUDIO_CHUNK_SECTORS 64
+
+/* Attempts per sector once transfers are down to one sector */
+#define AUDIO_RETRIES       3
+
+/* Buffer in flight between reader and checksum threads */
+typedef struct {
+    uint8_t *data;
+    int32_t lba;            /* First sector held */
+    int count;              /* Sectors held */
+    bool ready;             /* Filled and not yet consumed */
+} audio_buffer_t;
+
+/* Reader thread state for one run of audio tracks */
+typedef struct {
+    scsi_device_t *dev;
+    int32_t first;          /* Sectors to stream: [first, last) */
+    int32_t last;
+    int32_t readable_lo;    /* Sectors that hold this run's audio */
+    int32_t readable_hi;
+    int max_sectors;        /* Current transfer size */
+    audio_buffer_t buf[2];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool failed;            /* Reader gave up at failed_lba */
+    bool stop;              /* Consumer is done; reader should exit */
+    int32_t failed_lba;
+    int verbosity;
+} audio_stream_t;
+
+/*
+ * Read [lba, lba + count) into out, shrinking the transfer size while
+ * the drive refuses it
+ */
+static bool read_sectors(audio_stream_t *s, int32_t lba, int count, uint8_t *out)
+{
+    int retries = 0;
+
+    while (count > 0) {
+        int n = count < s->max_sectors ? count : s->max_sectors;
+        int got = scsi_read_cd_audio(s->dev, lba, n, out);
+
+        if (got <= 0) {
+            if (s->max_sectors > 1) {
+                s->max_sectors /= 2;
+                verbose(2, s->verbosity, "audio: transfer size reduced to %d sectors",
+                        s->max_sectors);
+                continue;
+            }
+            if (++retries >= AUDIO_RETRIES) {
+                s->failed_lba = lba;
+                return false;
+            }
+            continue;
+        }
+
+        retries = 0;
+        lba += got;
+        count -= got;
+        out += (size_t)got * RAW_SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+/*
+ * Fill a buffer with [lba, lba + count); sectors outside the run read
+ * as silence
+ */
+static bool fill_buffer(audio_stream_t *s, audio_buffer_t *b, int32_t lba, int count)
+{
+    b->lba = lba;
+    b->count = count;
+
+    int32_t lo = lba > s->readable_lo ? lba : s->readable_lo;
+    int32_t hi = lba + count < s->readable_hi ? lba + count : s->readable_hi;
+
+    if (lo >= hi) {
+        memset(b->data, 0, (size_t)count * RAW_SECTOR_SIZE);
+        return true;
+    }
+
+    memset(b->data, 0, (size_t)(lo - lba) * RAW_SECTOR_SIZE);
+    memset(b->data + (size_t)(hi - lba) * RAW_SECTOR_SIZE, 0,
+           (size_t)(lba + count - hi) * RAW_SECTOR_SIZE);
+
+    return read_sectors(s, lo, hi - lo, b->data + (size_t)(lo - lba) * RAW_SECTOR_SIZE);
+}
+
+/*
+ * Reader thread: fill buffers alternately, waiting for each to be consumed
+ */
+static void *reader_thread(void *arg)
+{
+    audio_stream_t *s = arg;
+    int slot = 0;
+
+    for (int32_t lba = s->first; lba < s->last; lba += AUDIO_CHUNK_SECTORS) {
+        audio_buffer_t *b = &s->buf[slot];
+        int count = s->last - lba < AUDIO_CHUNK_SECTORS ? s->last - lba : AUDIO_CHUNK_SECTORS;
+
+        pthread_mutex_lock(&s->lock);
+        while (b->ready && !s->stop)
+            pthread_cond_wait(&s->cond, &s->lock);
+        bool stop = s->stop;
+        pthread_mutex_unlock(&s->lock);
+        if (stop)
+            break;
+
+        bool ok = fill_buffer(s, b, lba, count);
+
+        pthread_mutex_lock(&s->lock);
+        if (ok)
+            b->ready = true;
+        else
+            s->failed = true;
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+
+        if (!ok)
+            break;
+        slot ^= 1;
+    }
+
+    return NULL;
+}
+
+/*
+ * End LBA of an audio track: the next track in its session, else the
+ * session's lead-out
+ */
+static int32_t track_end(const toc_t *toc, int i)
+{
+    const track_t *t = &toc->tracks[i];
+
+    if (i + 1 < toc->track_count && toc->tracks[i + 1].session == t->session)
+        return toc->tracks[i + 1].offset;
+    if (t->session < toc->tracks[toc->track_count - 1].session)
+        return toc->audio_leadout;
+    return toc->leadout;
+}
+
+/* Floor division for possibly negative sample positions */
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+/*
+ * Stream tracks [from, to] (consecutive audio tracks of one session)
+ * Returns false on read error
+ */
+static bool stream_run(scsi_device_t *dev, const toc_t *toc, int from, int to,
+                       int first_audio, int last_audio, int read_offset,
+                       track_crc_t *crcs, int verbosity)
+{
+    int32_t run_lo = toc->tracks[from].offset;
+    int32_t run_hi = track_end(toc, to);
+
+    audio_stream_t s;
+    memset(&s, 0, sizeof(s));
+    s.dev = dev;
+    s.readable_lo = run_lo;
+    s.readable_hi = run_hi;
+    s.first = (int32_t)floor_div((int64_t)run_lo * SAMPLES_PER_FRAME + read_offset,
+                                 SAMPLES_PER_FRAME);
+    s.last = (int32_t)floor_div((int64_t)run_hi * SAMPLES_PER_FRAME + read_offset +
+                                SAMPLES_PER_FRAME - 1, SAMPLES_PER_FRAME);
+    s.max_sectors = AUDIO_CHUNK_SECTORS;
+    s.verbosity = verbosity;
+
+    for (int i = 0; i < 2; i++)
+        s.buf[i].data = xmalloc((size_t)AUDIO_CHUNK_SECTORS * RAW_SECTOR_SIZE);
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.cond, NULL);
+
+    verbose(2, verbosity, "audio: tracks %d-%d: sectors %d-%d",
+            toc->tracks[from].number, toc->tracks[to].number, s.first, s.last - 1);
+
+    pthread_t reader;
+    bool started = (pthread_create(&reader, NULL, reader_thread, &s) == 0);
+    bool ok = started;
+    if (!started)
+        s.failed_lba = s.first;
+
+    /* Checksum in logical sample positions (physical minus read offset) */
+    int ti = from;
+    int64_t cursor = (int64_t)run_lo * SAMPLES_PER_FRAME;
+    int64_t end = (int64_t)track_end(toc, ti) * SAMPLES_PER_FRAME;
+    arcrc_t crc;
+    arcrc_init(&crc, (uint32_t)(end - cursor), ti == first_audio, ti == last_audio);
+
+    for (int slot = 0; ok && ti <= to; slot ^= 1) {
+        audio_buffer_t *b = &s.buf[slot];
+
+        pthread_mutex_lock(&s.lock);
+        while (!b->ready && !s.failed)
+            pthread_cond_wait(&s.cond, &s.lock);
+        ok = b->ready;
+        pthread_mutex_unlock(&s.lock);
+        if (!ok)
+            break;
+
+        int64_t pos = (int64_t)b->lba * SAMPLES_PER_FRAME - read_offset;
+        int64_t stop = pos + (int64_t)b->count * SAMPLES_PER_FRAME;
+        if (pos < cursor)
+            pos = cursor;
+
+        while (pos < stop && ti <= to) {
+            int64_t n = (stop < end ? stop : end) - pos;
+            const uint8_t *pcm = b->data +
+                (size_t)(pos - ((int64_t)b->lba * SAMPLES_PER_FRAME - read_offset)) * 4;
+            arcrc_update(&crc, pcm, (size_t)n);
+            pos += n;
+
+            if (pos == end) {
+                arcrc_finish(&crc, &crcs[ti]);
+                if (++ti <= to) {
+                    end = (int64_t)track_end(toc, ti) * SAMPLES_PER_FRAME;
+                    arcrc_init(&crc, (uint32_t)(end - pos), ti == first_audio,
+                               ti == last_audio);
+                }
+            }
+        }
+        cursor = pos;
+
+        pthread_mutex_lock(&s.lock);
+        b->ready = false;
+        pthread_cond_broadcast(&s.cond);
+        pthread_mutex_unlock(&s.lock);
+    }
+
+    if (started) {
+        pthread_mutex_lock(&s.lock);
+        s.stop = true;
+        pthread_cond_broadcast(&s.cond);
+        pthread_mutex_unlock(&s.lock);
+        pthread_join(reader, NULL);
+    }
+
+    if (!ok)
+        error("audio: read error at LBA %d: %s", s.failed_lba, scsi_error(dev));
+
+    pthread_cond_destroy(&s.cond);
+    pthread_mutex_destroy(&s.lock);
+    for (int i = 0; i < 2; i++)
+        free(s.buf[i].data);
+
+    return ok;
+}
+
+int audio_read_crcs(const toc_t *toc, const char *device, int read_offset,
+                    track_crc_t *crcs, int verbosity)
+{
+    memset(crcs, 0, MAX_TRACKS * sizeof(*crcs));
+
+    int first_audio = -1, last_audio = -1;
+    for (int i = 0; i < toc->track_count; i++) {
+        if (toc->tracks[i].type != TRACK_TYPE_AUDIO)
+            continue;
+        if (first_audio < 0)
+            first_audio = i;
+        last_audio = i;
+    }
+    if (first_audio < 0)
+        return 0;
+
+    verbose(1, verbosity, "audio: %d audio tracks, read offset %+d",
+            toc->audio_count, read_offset);
+
+    scsi_device_t *dev = scsi_open(device);
+    if (!dev) {
+        error("audio: cannot open %s", device);
+        return -1;
+    }
+    scsi_set_verbosity(dev, verbosity);
+
+    double start = monotonic_seconds();
+
+    int done = 0;
+    int64_t sectors = 0;
+    for (int i = first_audio; i <= last_audio; i++) {
+        if (toc->tracks[i].type != TRACK_TYPE_AUDIO)
+            continue;
+
+        /* Extend the run over following audio tracks of the same session */
+        int j = i;
+        while (j + 1 <= last_audio && toc->tracks[j + 1].type == TRACK_TYPE_AUDIO &&
+               toc->tracks[j + 1].session == toc->tracks[i].session)
+            j++;
+
+        if (!stream_run(dev, toc, i, j, first_audio, last_audio, read_offset,
+                        crcs, verbosity)) {
+            scsi_close(dev);
+            return -1;
+        }
+
+        done += j - i + 1;
+        sectors += track_end(toc, j) - toc->tracks[i].offset;
+        i = j;
+    }
+
+    double secs = monotonic_seconds() - start;
+    verbose(1, verbosity, "audio: %lld sectors in %.1fs (%.1fx)", (long long)sectors, secs,
+            secs > 0 ? (double)sectors / FRAMES_PER_SECOND / secs : 0.0);
+
+    scsi_close(dev);
+    return done;
+}
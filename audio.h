@@ -0,0 +1,34 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * audio.h - Streaming CD-DA reads for track checksums
+ */
+
+#ifndef MBDISCID_AUDIO_H
+#define MBDISCID_AUDIO_H
+
+#include "types.h"
+
+/*
+ * Read every audio track and compute AccurateRip v1/v2 and CRC-32
+ * checksums (see arcrc.h):
+ * - Consecutive audio tracks are streamed as one run with multi-sector
+ *   READ CD transfers, backed off automatically if the drive rejects
+ *   the transfer size
+ * - A reader thread fills one buffer while the other is checksummed
+ * - read_offset shifts the data by that many samples; samples outside
+ *   the audio session (lead-in, lead-out, data track) read as silence
+ *
+ * toc: TOC read from the same device
+ * device: device path or disc image (will be opened/closed internally)
+ * crcs: output, parallel to toc->tracks; data tracks stay invalid
+ * verbosity: verbosity level for diagnostics
+ *
+ * Returns number of audio tracks checksummed
+ * Returns -1 on device or read error (reported via error())
+ */
+int audio_read_crcs(const toc_t *toc, const char *device, int read_offset,
+                    track_crc_t *crcs, int verbosity);
+
+#endif /* MBDISCID_AUDIO_H */
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 
 /* CD-Text constants */
 #define CDTEXT_PACK_SIZE        18
@@ -40,25 +41,51 @@
 /* Size info block structure (pack type 0x8F) */
 #define SIZE_INFO_PACKS         3       /* 3 packs of size info per block */
 
+/*
+ * Slicing-by-8 tables for CRC-16 CCITT: crc_table[k][b] is the CRC of
+ * byte b followed by k zero bytes. Built once, before any thread reads
+ * them (bulk parsing runs cdtext_parse() concurrently)
+ */
+static uint16_t crc_table[8][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void)
+{
+    for (int b = 0; b < 256; b++) {
+        uint16_t crc = (uint16_t)(b << 8);
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        crc_table[0][b] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int b = 0; b < 256; b++) {
+            uint16_t prev = crc_table[k - 1][b];
+            crc_table[k][b] = (uint16_t)(prev << 8) ^ crc_table[0][prev >> 8];
+        }
+    }
+}
+
 /*
  * CRC-16 CCITT for CD-Text validation
  * Polynomial: x^16 + x^12 + x^5 + 1 (0x1021)
  * Initial value: 0x0000 for CD-Text (NOT 0xFFFF like Q-subchannel)
  * Note: CD-Text CRC is inverted before storage
+ * A pack's 16 covered bytes take two table rounds
  */
-static uint16_t crc16_cdtext(const uint8_t *data, int len)
+static uint16_t crc16_cdtext(const uint8_t *data, size_t len)
 {
     uint16_t crc = 0;
 
-    for (int i = 0; i < len; i++) {
-        crc ^= (uint16_t)data[i] << 8;
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x8000)
-                crc = (crc << 1) ^ 0x1021;
-            else
-                crc <<= 1;
-        }
+    while (len >= 8) {
+        crc = crc_table[7][(crc >> 8) ^ data[0]] ^ crc_table[6][(crc & 0xFF) ^ data[1]] ^
+              crc_table[5][data[2]] ^ crc_table[4][data[3]] ^
+              crc_table[3][data[4]] ^ crc_table[2][data[5]] ^
+              crc_table[1][data[6]] ^ crc_table[0][data[7]];
+        data += 8;
+        len -= 8;
     }
+    while (len--)
+        crc = (uint16_t)(crc << 8) ^ crc_table[0][(crc >> 8) ^ *data++];
 
     return crc;
 }
@@ -69,6 +96,8 @@ static uint16_t crc16_cdtext(const uint8_t *data, int len)
  */
 bool cdtext_pack_crc_valid(const cdtext_pack_t *pack)
 {
+    pthread_once(&crc_table_once, crc_table_init);
+
     uint16_t calc_crc = crc16_cdtext((const uint8_t *)pack, 16);
     calc_crc = ~calc_crc;  /* CD-Text stores inverted CRC */
 
@@ -78,15 +107,68 @@ bool cdtext_pack_crc_valid(const cdtext_pack_t *pack)
 }
 
 /*
- * Convert ISO-8859-1 string to UTF-8
- * Returns allocated string (caller must free)
+ * Validate the CRC of every pack in a blob
+ */
+size_t cdtext_validate_packs(const uint8_t *raw_data, size_t pack_count, bool *valid)
+{
+    size_t count = 0;
+
+    pthread_once(&crc_table_once, crc_table_init);
+
+    for (size_t i = 0; i < pack_count; i++) {
+        const uint8_t *p = raw_data + i * CDTEXT_PACK_SIZE;
+        uint16_t stored = ((uint16_t)p[16] << 8) | p[17];
+        uint16_t calc = (uint16_t)~crc16_cdtext(p, 16);
+
+        valid[i] = (calc == stored);
+        count += valid[i];
+    }
+
+    return count;
+}
+
+/*
+ * Locate the packs in a binary CD-Text blob
+ */
+bool cdtext_locate_packs(size_t size, size_t *start, size_t *len)
+{
+    *start = 0;
+    *len = size;
+
+    /* Terminating NUL written by cdrdao */
+    if (*len % CDTEXT_PACK_SIZE == 1 || *len % CDTEXT_PACK_SIZE == 5)
+        (*len)--;
+
+    /* READ TOC header (data length and two reserved bytes) */
+    if (*len % CDTEXT_PACK_SIZE == 4) {
+        *start = 4;
+        *len -= 4;
+    }
+
+    return *len % CDTEXT_PACK_SIZE == 0;
+}
+
+/*
+ * Check whether parsed CD-Text holds any album or track name
  */
-static char *iso8859_1_to_utf8(const uint8_t *src, size_t len)
+bool cdtext_has_text(const cdtext_t *cdtext)
 {
-    /* Worst case: each byte becomes 2 UTF-8 bytes */
-    char *utf8 = xmalloc(len * 2 + 1);
-    char *dst = utf8;
+    if (cdtext->album.album || cdtext->album.albumartist)
+        return true;
 
+    for (int i = 0; i < cdtext->track_count; i++) {
+        if (cdtext->tracks[i].title || cdtext->tracks[i].artist)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Convert ISO-8859-1 to UTF-8 into dst (room for len * 2 + 1 bytes)
+ */
+static void iso8859_1_to_utf8(char *dst, const uint8_t *src, size_t len)
+{
     for (size_t i = 0; i < len && src[i] != '\0'; i++) {
         uint8_t c = src[i];
 
@@ -101,7 +183,6 @@ static char *iso8859_1_to_utf8(const uint8_t *src, size_t len)
     }
 
     *dst = '\0';
-    return utf8;
 }
 
 /*
@@ -151,6 +232,8 @@ static void normalize_cdtext_string(char *str)
 
 /*
  * Text accumulator for building strings across multiple packs
+ * The first pass only sizes each string (capacity); the second copies
+ * the bytes into a slice of one shared scratch buffer
  */
 typedef struct {
     uint8_t *data;
@@ -158,65 +241,82 @@ typedef struct {
     size_t capacity;
 } text_accum_t;
 
-static void accum_init(text_accum_t *acc)
+static void accum_append(text_accum_t *acc, uint8_t c)
 {
-    acc->data = NULL;
-    acc->len = 0;
-    acc->capacity = 0;
+    if (!acc->data)
+        acc->capacity++;
+    else if (acc->len < acc->capacity)
+        acc->data[acc->len++] = c;
 }
 
-static void accum_free(text_accum_t *acc)
+/*
+ * Finished strings of one disc: the arena that owns them plus a hash
+ * set, so a value repeated across tracks (typically the performer) is
+ * stored once
+ */
+#define INTERN_SLOTS 1024   /* Power of two, above 7 + 6 * 99 strings */
+
+typedef struct {
+    arena_t *arena;
+    char *slots[INTERN_SLOTS];
+} string_table_t;
+
+static uint32_t hash_string(const char *s)
 {
-    free(acc->data);
-    acc->data = NULL;
-    acc->len = 0;
-    acc->capacity = 0;
+    uint32_t h = 2166136261u;   /* FNV-1a */
+    while (*s)
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
 }
 
-static void accum_append(text_accum_t *acc, const uint8_t *data, size_t len)
+/*
+ * Return the stored copy of str, adding it if new
+ * str must be the most recent arena allocation; it is trimmed to fit
+ * or given back if an equal string is already stored
+ */
+static char *intern_string(string_table_t *tab, char *str)
 {
-    if (len == 0)
-        return;
+    uint32_t i = hash_string(str) & (INTERN_SLOTS - 1);
 
-    if (acc->len + len + 1 > acc->capacity) {
-        acc->capacity = (acc->len + len + 1) * 2;
-        if (acc->capacity < 64)
-            acc->capacity = 64;
-        acc->data = xrealloc(acc->data, acc->capacity);
+    while (tab->slots[i]) {
+        if (strcmp(tab->slots[i], str) == 0) {
+            arena_shrink(tab->arena, str, 0);
+            return tab->slots[i];
+        }
+        i = (i + 1) & (INTERN_SLOTS - 1);
     }
 
-    memcpy(acc->data + acc->len, data, len);
-    acc->len += len;
-    acc->data[acc->len] = '\0';
+    arena_shrink(tab->arena, str, strlen(str) + 1);
+    tab->slots[i] = str;
+    return str;
 }
 
-static char *accum_finish(text_accum_t *acc, uint8_t charset)
+static char *accum_finish(string_table_t *tab, const text_accum_t *acc, uint8_t charset)
 {
-    if (!acc->data || acc->len == 0) {
-        accum_free(acc);
+    if (acc->len == 0)
         return NULL;
-    }
 
+    /* Convert straight into the arena, reserving the UTF-8 worst case */
     char *result;
     if (charset == CDTEXT_CHARSET_ISO8859_1) {
-        result = iso8859_1_to_utf8(acc->data, acc->len);
+        result = arena_alloc(tab->arena, acc->len * 2 + 1);
+        iso8859_1_to_utf8(result, acc->data, acc->len);
     } else {
         /* ASCII or fallback: direct copy */
-        result = xmalloc(acc->len + 1);
+        result = arena_alloc(tab->arena, acc->len + 1);
         memcpy(result, acc->data, acc->len);
         result[acc->len] = '\0';
     }
 
-    accum_free(acc);
     normalize_cdtext_string(result);
 
     /* Return NULL if empty after normalization */
     if (!result[0]) {
-        free(result);
+        arena_shrink(tab->arena, result, 0);
         return NULL;
     }
 
-    return result;
+    return intern_string(tab, result);
 }
 
 /*
@@ -249,29 +349,32 @@ static void block_state_init(block_state_t *state)
     state->charset = CDTEXT_CHARSET_ISO8859_1;  /* Default */
     state->first_track = 1;
     state->last_track = 99;
+}
 
-    for (int i = 0; i <= CDTEXT_MAX_TRACKS; i++) {
-        accum_init(&state->tracks[i].title);
-        accum_init(&state->tracks[i].performer);
-        accum_init(&state->tracks[i].songwriter);
-        accum_init(&state->tracks[i].composer);
-        accum_init(&state->tracks[i].arranger);
-        accum_init(&state->tracks[i].message);
-    }
-    accum_init(&state->genre);
+/*
+ * Give an accumulator its slice of scratch; returns the next free byte
+ */
+static uint8_t *accum_place(text_accum_t *acc, uint8_t *scratch)
+{
+    acc->data = scratch;
+    return scratch + acc->capacity;
 }
 
-static void block_state_free(block_state_t *state)
+/*
+ * Point every accumulator at its slice of scratch (sized by the first pass)
+ */
+static void block_state_layout(block_state_t *state, uint8_t *scratch)
 {
     for (int i = 0; i <= CDTEXT_MAX_TRACKS; i++) {
-        accum_free(&state->tracks[i].title);
-        accum_free(&state->tracks[i].performer);
-        accum_free(&state->tracks[i].songwriter);
-        accum_free(&state->tracks[i].composer);
-        accum_free(&state->tracks[i].arranger);
-        accum_free(&state->tracks[i].message);
+        track_accum_t *t = &state->tracks[i];
+        scratch = accum_place(&t->title, scratch);
+        scratch = accum_place(&t->performer, scratch);
+        scratch = accum_place(&t->songwriter, scratch);
+        scratch = accum_place(&t->composer, scratch);
+        scratch = accum_place(&t->arranger, scratch);
+        scratch = accum_place(&t->message, scratch);
     }
-    accum_free(&state->genre);
+    accum_place(&state->genre, scratch);
 }
 
 /*
@@ -309,10 +412,8 @@ static text_accum_t *get_track_accum(block_state_t *state, uint8_t pack_type, in
  * Text is null-terminated; track number advances on each null
  */
 static void process_text_pack(block_state_t *state, const cdtext_pack_t *pack,
-                               int *current_track, int verbosity)
+                               int *current_track)
 {
-    (void)verbosity;  /* Reserved for future diagnostic use */
-
     uint8_t pack_type = pack->pack_type;
     int track = *current_track;
 
@@ -332,19 +433,47 @@ static void process_text_pack(block_state_t *state, const cdtext_pack_t *pack,
         /* Append character to appropriate accumulator */
         text_accum_t *acc = get_track_accum(state, pack_type, track);
         if (acc) {
-            accum_append(acc, &c, 1);
+            accum_append(acc, c);
         }
     }
 
     *current_track = track;
 }
 
+/*
+ * Run every valid text pack through the accumulators
+ */
+static void process_text_packs(block_state_t *state, const uint8_t *raw_data,
+                               size_t pack_count, const bool *valid)
+{
+    /* Track current track number for each pack type */
+    int current_track[16] = {0};  /* Indexed by pack_type & 0x0F */
+
+    for (size_t i = 0; i < pack_count; i++) {
+        if (!valid[i])
+            continue;
+
+        const cdtext_pack_t *pack = (const cdtext_pack_t *)(raw_data + i * CDTEXT_PACK_SIZE);
+
+        /* Get pack type index (0x80-0x87 -> 0-7) */
+        int type_idx = pack->pack_type & 0x0F;
+
+        /* Handle sequence number 0: reset track counter */
+        if (pack->seq_num == 0) {
+            current_track[type_idx] = pack->track_num;
+        }
+
+        /* Process text data */
+        process_text_pack(state, pack, &current_track[type_idx]);
+    }
+}
+
 /*
  * Parse size information block (pack type 0x8F)
  * Contains character set, track range, and pack counts
  */
 static void parse_size_info(block_state_t *state, const uint8_t *raw_data,
-                            size_t pack_count, int verbosity)
+                            size_t pack_count, const bool *crc_valid, int verbosity)
 {
     /* Find size info packs for block 0 */
     for (size_t i = 0; i < pack_count; i++) {
@@ -359,7 +488,7 @@ static void parse_size_info(block_state_t *state, const uint8_t *raw_data,
             continue;
 
         /* Validate CRC */
-        if (!cdtext_pack_crc_valid(pack)) {
+        if (!crc_valid[i]) {
             verbose(2, verbosity, "cdtext: size info pack %zu CRC invalid, skipping", i);
             continue;
         }
@@ -405,26 +534,33 @@ int cdtext_parse(const uint8_t *raw_data, size_t len, cdtext_t *cdtext, int verb
 
     verbose(1, verbosity, "cdtext: parsing %zu packs (%zu bytes)", pack_count, len);
 
+    /*
+     * One scratch allocation holds the pack validity flags and, after
+     * the sizing pass, the raw text of every string back to back
+     */
+    uint8_t *scratch = xmalloc(pack_count * (1 + CDTEXT_TEXT_SIZE));
+    bool *valid = (bool *)scratch;
+
+    /* Check every CRC in one sweep over the blob */
+    cdtext_validate_packs(raw_data, pack_count, valid);
+
     /* Initialize block state */
     block_state_t state;
     block_state_init(&state);
 
     /* First pass: find size info to get charset and track range */
-    parse_size_info(&state, raw_data, pack_count, verbosity);
+    parse_size_info(&state, raw_data, pack_count, valid, verbosity);
 
     /* Check encoding support */
     if (state.charset != CDTEXT_CHARSET_ISO8859_1 &&
         state.charset != CDTEXT_CHARSET_ASCII) {
         verbose(1, verbosity, "cdtext: unsupported charset %d (only ISO-8859-1/ASCII supported)",
                 state.charset);
-        block_state_free(&state);
+        free(scratch);
         return 0;
     }
 
-    /* Track current track number for each pack type */
-    int current_track[16] = {0};  /* Indexed by pack_type & 0x0F */
-
-    /* Second pass: parse text packs */
+    /* Second pass: keep block 0 text packs with a valid CRC */
     int valid_packs = 0;
     int invalid_packs = 0;
 
@@ -433,15 +569,16 @@ int cdtext_parse(const uint8_t *raw_data, size_t len, cdtext_t *cdtext, int verb
 
         /* Only process block 0 */
         int block = (pack->char_pos >> 4) & 0x07;
-        if (block != 0)
-            continue;
 
         /* Skip non-text packs */
-        if (pack->pack_type < CDTEXT_PACK_TITLE || pack->pack_type > CDTEXT_PACK_GENRE)
+        if (block != 0 ||
+            pack->pack_type < CDTEXT_PACK_TITLE || pack->pack_type > CDTEXT_PACK_GENRE) {
+            valid[i] = false;
             continue;
+        }
 
         /* Validate CRC */
-        if (!cdtext_pack_crc_valid(pack)) {
+        if (!valid[i]) {
             invalid_packs++;
             verbose(3, verbosity, "cdtext: pack %zu type 0x%02x CRC invalid",
                     i, pack->pack_type);
@@ -449,46 +586,40 @@ int cdtext_parse(const uint8_t *raw_data, size_t len, cdtext_t *cdtext, int verb
         }
 
         valid_packs++;
-
-        /* Get pack type index (0x80-0x87 -> 0-7) */
-        int type_idx = pack->pack_type & 0x0F;
-
-        /* Handle sequence number 0: reset track counter */
-        if (pack->seq_num == 0) {
-            current_track[type_idx] = pack->track_num;
-        }
-
-        /* Process text data */
-        process_text_pack(&state, pack, &current_track[type_idx], verbosity);
     }
 
     verbose(1, verbosity, "cdtext: %d valid packs, %d invalid", valid_packs, invalid_packs);
 
+    /* Size every string, then copy the text into place */
+    process_text_packs(&state, raw_data, pack_count, valid);
+    block_state_layout(&state, scratch + pack_count);
+    process_text_packs(&state, raw_data, pack_count, valid);
+
     /* Build output structure */
+    string_table_t tab = { .arena = &cdtext->arena };
     cdtext->track_count = state.last_track;
 
     /* Album fields (track 0) */
-    cdtext->album.album = accum_finish(&state.tracks[0].title, state.charset);
-    cdtext->album.albumartist = accum_finish(&state.tracks[0].performer, state.charset);
-    cdtext->album.lyricist = accum_finish(&state.tracks[0].songwriter, state.charset);
-    cdtext->album.composer = accum_finish(&state.tracks[0].composer, state.charset);
-    cdtext->album.arranger = accum_finish(&state.tracks[0].arranger, state.charset);
-    cdtext->album.comment = accum_finish(&state.tracks[0].message, state.charset);
-    cdtext->album.genre = accum_finish(&state.genre, state.charset);
+    cdtext->album.album = accum_finish(&tab, &state.tracks[0].title, state.charset);
+    cdtext->album.albumartist = accum_finish(&tab, &state.tracks[0].performer, state.charset);
+    cdtext->album.lyricist = accum_finish(&tab, &state.tracks[0].songwriter, state.charset);
+    cdtext->album.composer = accum_finish(&tab, &state.tracks[0].composer, state.charset);
+    cdtext->album.arranger = accum_finish(&tab, &state.tracks[0].arranger, state.charset);
+    cdtext->album.comment = accum_finish(&tab, &state.tracks[0].message, state.charset);
+    cdtext->album.genre = accum_finish(&tab, &state.genre, state.charset);
 
     /* Track fields */
     for (int t = 1; t <= state.last_track && t <= MAX_TRACKS; t++) {
         int idx = t - 1;
-        cdtext->tracks[idx].title = accum_finish(&state.tracks[t].title, state.charset);
-        cdtext->tracks[idx].artist = accum_finish(&state.tracks[t].performer, state.charset);
-        cdtext->tracks[idx].lyricist = accum_finish(&state.tracks[t].songwriter, state.charset);
-        cdtext->tracks[idx].composer = accum_finish(&state.tracks[t].composer, state.charset);
-        cdtext->tracks[idx].arranger = accum_finish(&state.tracks[t].arranger, state.charset);
-        cdtext->tracks[idx].comment = accum_finish(&state.tracks[t].message, state.charset);
+        cdtext->tracks[idx].title = accum_finish(&tab, &state.tracks[t].title, state.charset);
+        cdtext->tracks[idx].artist = accum_finish(&tab, &state.tracks[t].performer, state.charset);
+        cdtext->tracks[idx].lyricist = accum_finish(&tab, &state.tracks[t].songwriter, state.charset);
+        cdtext->tracks[idx].composer = accum_finish(&tab, &state.tracks[t].composer, state.charset);
+        cdtext->tracks[idx].arranger = accum_finish(&tab, &state.tracks[t].arranger, state.charset);
+        cdtext->tracks[idx].comment = accum_finish(&tab, &state.tracks[t].message, state.charset);
     }
 
-    /* Clean up any remaining accumulators */
-    block_state_free(&state);
+    free(scratch);
 
     return 0;
 }
@@ -81,7 +81,8 @@ typedef struct {
  *   - Only block 0 (primary language) is parsed
  *   - Only ISO-8859-1 and ASCII encodings are supported
  *   - Invalid CRC packs are skipped
- *   - Text fields are allocated and must be freed with cdtext_free()
+ *   - Text fields live in cdtext->arena and are freed together with
+ *     cdtext_free(); equal values share one string, so never modify them
  */
 int cdtext_parse(const uint8_t *raw_data, size_t len, cdtext_t *cdtext, int verbosity);
 
@@ -94,4 +95,31 @@ int cdtext_parse(const uint8_t *raw_data, size_t len, cdtext_t *cdtext, int verb
  */
 bool cdtext_pack_crc_valid(const cdtext_pack_t *pack);
 
+/*
+ * Validate CRC-16 CCITT of every pack in a blob
+ *
+ * raw_data: pack_count consecutive 18-byte packs
+ * valid: output, one flag per pack
+ *
+ * Returns number of valid packs
+ */
+size_t cdtext_validate_packs(const uint8_t *raw_data, size_t pack_count, bool *valid);
+
+/*
+ * Locate the packs in a binary CD-Text blob: a cdrdao .cdt file or a
+ * READ TOC format 5 response, with or without the 4-byte header and
+ * terminating NUL
+ *
+ * size: blob size in bytes
+ * start, len: output, byte range of the packs within the blob
+ *
+ * Returns false if the blob does not hold a whole number of packs
+ */
+bool cdtext_locate_packs(size_t size, size_t *start, size_t *len);
+
+/*
+ * Check whether parsed CD-Text holds any album or track name
+ */
+bool cdtext_has_text(const cdtext_t *cdtext);
+
 #endif /* MBDISCID_CDTEXT_H */
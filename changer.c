@@ -0,0 +1,299 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * changer.c - Media changer batches (--changer)
+ */
+
+#include "device.h"
+#include "changer_sim.h"
+#include "isrc.h"
+#include "scsi.h"
+#include "subq.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* How long a hardware drive may take to report a freshly loaded disc */
+#define READY_TIMEOUT   60.0
+#define READY_POLL_NS   250000000L
+
+/* The changer's elements that a batch uses */
+typedef struct {
+    int transport;
+    int drive;
+    int slots[MAX_CHANGER_ELEMENTS];    /* Storage element addresses */
+    bool full[MAX_CHANGER_ELEMENTS];
+    int slot_count;
+    int drive_home;         /* Slot for a disc already in the drive, -1 if none */
+} layout_t;
+
+/*
+ * Put one disc back and load the next, on a thread of its own while
+ * the previous disc's output is produced
+ */
+typedef struct {
+    scsi_device_t *changer;
+    const layout_t *layout;
+    const char *drive;      /* Hardware drive to eject first, NULL if simulated */
+    int home;               /* Slot to return the drive's disc to, -1 if none */
+    int next;               /* Slot to load, -1 if none */
+    bool quiet;
+    int verbosity;
+    bool ok;
+    double moves;           /* Seconds spent moving */
+    double end;             /* When the last move finished */
+} move_job_t;
+
+/*
+ * Find the transport, the first drive and the slots, and where a disc
+ * left in the drive belongs
+ * Returns 0 on success, exit code (reported) on error
+ */
+static int read_layout(scsi_device_t *changer, layout_t *layout, bool quiet)
+{
+    changer_element_t *elements = xmalloc(MAX_CHANGER_ELEMENTS * sizeof(*elements));
+    int count = scsi_read_element_status(changer, elements, MAX_CHANGER_ELEMENTS);
+    if (count < 0) {
+        error_quiet(quiet, "changer: cannot read element status: %s", scsi_error(changer));
+        free(elements);
+        return EX_IOERR;
+    }
+
+    memset(layout, 0, sizeof(*layout));
+    layout->transport = -1;
+    layout->drive = -1;
+    layout->drive_home = -1;
+
+    bool drive_full = false;
+    int drive_source = -1;
+    for (int i = 0; i < count; i++) {
+        const changer_element_t *e = &elements[i];
+        if (e->type == CHANGER_TRANSPORT && layout->transport < 0) {
+            layout->transport = e->address;
+        } else if (e->type == CHANGER_DRIVE && layout->drive < 0) {
+            layout->drive = e->address;
+            drive_full = e->full;
+            drive_source = e->source;
+        } else if (e->type == CHANGER_SLOT) {
+            layout->slots[layout->slot_count] = e->address;
+            layout->full[layout->slot_count] = e->full;
+            layout->slot_count++;
+        }
+    }
+    free(elements);
+
+    if (layout->drive < 0 || layout->slot_count == 0) {
+        error_quiet(quiet, "changer: no %s element", layout->drive < 0 ? "drive" : "storage");
+        return EX_IOERR;
+    }
+    if (layout->transport < 0)
+        layout->transport = 0;      /* The changer's default transport */
+
+    /* A disc left in the drive goes back where it came from, or to the
+     * first empty slot */
+    if (drive_full) {
+        for (int i = 0; i < layout->slot_count && layout->drive_home < 0; i++) {
+            if (!layout->full[i] && layout->slots[i] == drive_source)
+                layout->drive_home = layout->slots[i];
+        }
+        for (int i = 0; i < layout->slot_count && layout->drive_home < 0; i++) {
+            if (!layout->full[i])
+                layout->drive_home = layout->slots[i];
+        }
+        if (layout->drive_home < 0) {
+            error_quiet(quiet, "changer: drive is occupied and no slot is free");
+            return EX_IOERR;
+        }
+    }
+    return 0;
+}
+
+static bool move(move_job_t *job, int source, int destination)
+{
+    double start = monotonic_seconds();
+    if (!scsi_move_medium(job->changer, job->layout->transport, source, destination)) {
+        error_quiet(job->quiet, "changer: cannot move 0x%04X to 0x%04X: %s",
+                    source, destination, scsi_error(job->changer));
+        return false;
+    }
+    double seconds = monotonic_seconds() - start;
+    job->moves += seconds;
+    verbose(2, job->verbosity, "changer: moved 0x%04X to 0x%04X in %.2fs",
+            source, destination, seconds);
+    return true;
+}
+
+static void run_moves(move_job_t *job)
+{
+    job->ok = true;
+    if (job->home >= 0) {
+        /* Drives in a changer present the disc to the picker on eject */
+        if (job->drive)
+            device_eject(job->drive, job->verbosity);
+        job->ok = move(job, job->layout->drive, job->home);
+    }
+    if (job->ok && job->next >= 0)
+        job->ok = move(job, job->next, job->layout->drive);
+    job->end = monotonic_seconds();
+}
+
+static void *move_thread(void *arg)
+{
+    run_moves(arg);
+    return NULL;
+}
+
+/*
+ * Wait for a hardware drive to report the disc just loaded into it
+ */
+static bool wait_ready(const char *drive)
+{
+    double start = monotonic_seconds();
+    do {
+        scsi_device_t *dev = scsi_open(drive);
+        if (dev) {
+            bool present = false, tray_open = false;
+            int profile = 0;
+            bool ok = scsi_get_media(dev, &present, &tray_open, &profile);
+            scsi_close(dev);
+            if (ok && present && profile != 0)
+                return true;
+        }
+        struct timespec ts = { 0, READY_POLL_NS };
+        nanosleep(&ts, NULL);
+    } while (monotonic_seconds() - start < READY_TIMEOUT);
+    return false;
+}
+
+int device_read_changer(int flags, const options_t *opts, device_acquire_fn acquire,
+                        device_finish_fn finish, void *ctx)
+{
+    bool simulated = changer_sim_is_path(opts->changer);
+    if (!simulated && !opts->drive) {
+        error_quiet(opts->quiet, "changer: --drive is required for a hardware changer");
+        return EX_USAGE;
+    }
+
+    scsi_device_t *changer = scsi_changer_open(opts->changer);
+    if (!changer) {
+        if (!simulated)
+            error_quiet(opts->quiet, "changer: cannot open %s", opts->changer);
+        return EX_IOERR;
+    }
+    scsi_set_verbosity(changer, opts->verbosity);
+
+    layout_t *layout = xmalloc(sizeof(*layout));
+    int ret = read_layout(changer, layout, opts->quiet);
+    if (ret != 0) {
+        free(layout);
+        scsi_close(changer);
+        return ret;
+    }
+
+    int discs = 0;
+    for (int i = 0; i < layout->slot_count; i++)
+        discs += layout->full[i];
+    verbose(1, opts->verbosity, "changer: %s: %d slots, %d discs, drive 0x%04X%s",
+            opts->changer, layout->slot_count, discs, layout->drive,
+            simulated ? " (simulated)" : "");
+    if (simulated && opts->drive)
+        verbose(1, opts->verbosity, "changer: simulated drive used instead of %s", opts->drive);
+    if (discs == 0) {
+        error_quiet(opts->quiet, "changer: no discs in %s", opts->changer);
+        free(layout);
+        scsi_close(changer);
+        return EX_NOINPUT;
+    }
+
+    char *drive = simulated ? NULL : device_normalize_path(opts->drive);
+    disc_info_t *disc = xmalloc(sizeof(*disc));
+    move_job_t job = { changer, layout, drive, layout->drive_home, -1,
+                       opts->quiet, opts->verbosity, true, 0.0, 0.0 };
+    double batch_start = monotonic_seconds(), overlapped = 0.0, moves = 0.0;
+    int identified = 0, first_ret = 0;
+
+    /* Load the first disc; later loads overlap the previous disc's output */
+    int slot = 0;
+    while (!layout->full[slot])
+        slot++;
+    job.next = layout->slots[slot];
+    run_moves(&job);
+    moves += job.moves;
+
+    while (job.ok) {
+        double start = monotonic_seconds();
+        const char *path = simulated ? scsi_changer_medium(changer, layout->drive) : drive;
+
+        /* Nothing learned from the previous disc applies to this one */
+        subq_session_reset();
+        isrc_session_reset();
+        memset(disc, 0, sizeof(*disc));
+
+        if (!simulated && !wait_ready(drive)) {
+            error_quiet(opts->quiet, "changer: slot %d: drive not ready", slot + 1);
+            ret = EX_IOERR;
+        } else {
+            ret = acquire(path, disc, flags, opts);
+        }
+        disc->slot = slot + 1;
+        double read_end = monotonic_seconds();
+
+        /* Return this disc and load the next while it is processed */
+        int next = slot + 1;
+        while (next < layout->slot_count && !layout->full[next])
+            next++;
+        job = (move_job_t){ changer, layout, drive, layout->slots[slot],
+                            next < layout->slot_count ? layout->slots[next] : -1,
+                            opts->quiet, opts->verbosity, true, 0.0, 0.0 };
+        pthread_t mover;
+        bool started = (pthread_create(&mover, NULL, move_thread, &job) == 0);
+
+        if (ret == 0) {
+            ret = finish(disc, opts, ctx);
+            fflush(stdout);
+        } else {
+            error_quiet(opts->quiet, "changer: slot %d: cannot identify disc", slot + 1);
+            cdtext_free(&disc->cdtext);
+        }
+        identified += ret == 0;
+        if (first_ret == 0)
+            first_ret = ret;
+        double output_end = monotonic_seconds();
+
+        if (started)
+            pthread_join(mover, NULL);
+        else
+            run_moves(&job);
+        moves += job.moves;
+        if (started && job.end > read_end)
+            overlapped += (output_end < job.end ? output_end : job.end) - read_end;
+
+        verbose(1, opts->verbosity,
+                "changer: slot %d: read %.2fs, ids and output %.2fs, changer %.2fs",
+                slot + 1, read_end - start, output_end - read_end, job.moves);
+
+        if (next >= layout->slot_count)
+            break;
+        slot = next;
+    }
+
+    if (!job.ok && first_ret == 0)
+        first_ret = EX_IOERR;
+
+    double seconds = monotonic_seconds() - batch_start;
+    verbose(1, opts->verbosity,
+            "changer: %d of %d discs identified in %.2fs (%.0f discs per hour), "
+            "changer moves %.2fs, %.2fs of it overlapped with output",
+            identified, discs, seconds, seconds > 0 ? identified * 3600.0 / seconds : 0.0,
+            moves, overlapped);
+
+    free(disc);
+    free(drive);
+    free(layout);
+    scsi_close(changer);
+    return first_ret;
+}
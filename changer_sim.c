@@ -0,0 +1,201 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * changer_sim.c - Simulated media changer backend
+ */
+
+#include "changer_sim.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/* Element addresses, laid out as a typical one-drive changer reports them */
+#define SIM_TRANSPORT   0x0000
+#define SIM_DRIVE       0x0001
+#define SIM_FIRST_SLOT  0x0100
+
+/* Elements besides the slots: the transport and the drive */
+#define SIM_MAX_SLOTS   (MAX_CHANGER_ELEMENTS - 2)
+
+struct changer_sim {
+    char **slots;           /* Image in each slot, NULL if empty */
+    int slot_count;
+    char *drive;            /* Image in the drive, NULL if empty */
+    int drive_source;       /* Slot address the drive's disc came from */
+    double move_seconds;    /* Time each MOVE MEDIUM takes */
+};
+
+bool changer_sim_is_path(const char *path)
+{
+    size_t len = path ? strlen(path) : 0;
+    return len > 8 && strcasecmp(path + len - 8, ".changer") == 0;
+}
+
+/*
+ * Resolve an image name relative to the .changer file's directory
+ */
+static char *resolve_path(const char *changer, const char *name)
+{
+    const char *slash = strrchr(changer, '/');
+    if (name[0] == '/' || !slash)
+        return xstrdup(name);
+
+    size_t dir_len = (size_t)(slash - changer);
+    size_t len = dir_len + strlen(name) + 2;
+    char *path = xmalloc(len);
+    snprintf(path, len, "%.*s/%s", (int)dir_len, changer, name);
+    return path;
+}
+
+changer_sim_t *changer_sim_open(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        error("changer: cannot open %s", path);
+        return NULL;
+    }
+
+    changer_sim_t *sim = xcalloc(1, sizeof(*sim));
+    sim->slots = xcalloc(SIM_MAX_SLOTS, sizeof(*sim->slots));
+
+    char *line = NULL;
+    size_t cap = 0;
+    int line_no = 0;
+    bool ok = true;
+    while (ok && getline(&line, &cap, fp) >= 0) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        char *s = trim(line);
+        if (!*s)
+            continue;
+
+        char *arg = s + strcspn(s, " \t");
+        if (*arg)
+            *arg++ = '\0';
+        arg = trim(arg);
+
+        if (strcasecmp(s, "slot") == 0) {
+            if (sim->slot_count == SIM_MAX_SLOTS) {
+                error("changer: %s: line %d: too many slots", path, line_no);
+                ok = false;
+            } else {
+                sim->slots[sim->slot_count++] = *arg ? resolve_path(path, arg) : NULL;
+            }
+        } else if (strcasecmp(s, "move") == 0) {
+            char *end;
+            double seconds = strtod(arg, &end);
+            if (!*arg || *end || seconds < 0 || seconds > 600) {
+                error("changer: %s: line %d: malformed move", path, line_no);
+                ok = false;
+            }
+            sim->move_seconds = seconds;
+        } else {
+            error("changer: %s: line %d: unknown keyword %s", path, line_no, s);
+            ok = false;
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (ok && sim->slot_count == 0) {
+        error("changer: %s: no slots", path);
+        ok = false;
+    }
+    if (!ok) {
+        changer_sim_close(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void changer_sim_close(changer_sim_t *sim)
+{
+    if (!sim)
+        return;
+
+    for (int i = 0; i < sim->slot_count; i++)
+        free(sim->slots[i]);
+    free(sim->slots);
+    free(sim->drive);
+    free(sim);
+}
+
+int changer_sim_read_element_status(changer_sim_t *sim, changer_element_t *elements,
+                                    int max)
+{
+    int n = 0;
+
+    if (n < max)
+        elements[n++] = (changer_element_t){ SIM_TRANSPORT, CHANGER_TRANSPORT, false, -1 };
+    if (n < max)
+        elements[n++] = (changer_element_t){ SIM_DRIVE, CHANGER_DRIVE, sim->drive != NULL,
+                                             sim->drive ? sim->drive_source : -1 };
+    for (int i = 0; i < sim->slot_count && n < max; i++)
+        elements[n++] = (changer_element_t){ SIM_FIRST_SLOT + i, CHANGER_SLOT,
+                                             sim->slots[i] != NULL, -1 };
+    return n;
+}
+
+/*
+ * The storage for the disc at address: a slot or the drive, NULL if the
+ * address is neither
+ */
+static char **element(changer_sim_t *sim, int address)
+{
+    if (address == SIM_DRIVE)
+        return &sim->drive;
+    if (address >= SIM_FIRST_SLOT && address < SIM_FIRST_SLOT + sim->slot_count)
+        return &sim->slots[address - SIM_FIRST_SLOT];
+    return NULL;
+}
+
+bool changer_sim_move_medium(changer_sim_t *sim, int transport, int source,
+                             int destination, char *error, size_t size)
+{
+    char **from = element(sim, source);
+    char **to = element(sim, destination);
+
+    /* Rejected as a changer would reject them: ILLEGAL REQUEST */
+    if (transport != SIM_TRANSPORT || !from || !to) {
+        snprintf(error, size, "MOVE MEDIUM: invalid element address");
+        return false;
+    }
+    if (!*from) {
+        snprintf(error, size, "MOVE MEDIUM: source element 0x%04X is empty", source);
+        return false;
+    }
+    if (*to && from != to) {
+        snprintf(error, size, "MOVE MEDIUM: destination element 0x%04X is full",
+                 destination);
+        return false;
+    }
+
+    /* The picker's travel, load and unload */
+    if (sim->move_seconds > 0) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)sim->move_seconds;
+        ts.tv_nsec = (long)((sim->move_seconds - (double)ts.tv_sec) * 1e9);
+        nanosleep(&ts, NULL);
+    }
+
+    if (from != to) {
+        *to = *from;
+        *from = NULL;
+        if (destination == SIM_DRIVE)
+            sim->drive_source = source;
+    }
+    return true;
+}
+
+const char *changer_sim_medium(changer_sim_t *sim, int address)
+{
+    char **medium = element(sim, address);
+    return medium ? *medium : NULL;
+}
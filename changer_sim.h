@@ -0,0 +1,55 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * changer_sim.h - Simulated media changer backend
+ *
+ * Serves READ ELEMENT STATUS and MOVE MEDIUM through scsi.h the way a
+ * one-drive SCSI media changer would, from a .changer file listing the
+ * disc image in each slot, so batch scheduling and throughput can be
+ * exercised without the hardware:
+ *
+ *   # Seconds each MOVE MEDIUM takes (default 0)
+ *   move 2.5
+ *   # One line per slot, in element order; no image for an empty slot
+ *   slot first.cue
+ *   slot
+ *   slot second.ccd
+ *
+ * Image paths are relative to the .changer file. The drive reads the
+ * image of whichever disc was moved into it.
+ */
+
+#ifndef MBDISCID_CHANGER_SIM_H
+#define MBDISCID_CHANGER_SIM_H
+
+#include "scsi.h"
+#include <stddef.h>
+
+/* Opaque simulator handle */
+typedef struct changer_sim changer_sim_t;
+
+/*
+ * Check whether a changer argument names a simulated changer (by extension)
+ */
+bool changer_sim_is_path(const char *path);
+
+/*
+ * Open and parse a .changer file; every disc starts in its slot
+ * Reports parse errors via error() and returns NULL on failure
+ */
+changer_sim_t *changer_sim_open(const char *path);
+
+void changer_sim_close(changer_sim_t *sim);
+
+/*
+ * Backend counterparts of the scsi.h functions of the same name
+ * Failures describe the rejected command in error
+ */
+int changer_sim_read_element_status(changer_sim_t *sim, changer_element_t *elements,
+                                    int max);
+bool changer_sim_move_medium(changer_sim_t *sim, int transport, int source,
+                             int destination, char *error, size_t size);
+const char *changer_sim_medium(changer_sim_t *sim, int address);
+
+#endif /* MBDISCID_CHANGER_SIM_H */
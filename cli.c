@@ -13,7 +13,7 @@
 #include <string.h>
 #include <getopt.h>
 
-static const char *short_opts = "TXCIRAFMatiuocqLhVv";
+static const char *short_opts = "TXCIGRAFMatiuocqLhVv";
 
 static struct option long_opts[] = {
     /* Modes */
@@ -21,11 +21,15 @@ static struct option long_opts[] = {
     {"text",        no_argument, NULL, 'X'},
     {"catalog",     no_argument, NULL, 'C'},
     {"isrc",        no_argument, NULL, 'I'},
+    {"gaps",        no_argument, NULL, 'G'},
     {"raw",         no_argument, NULL, 'R'},
     {"accuraterip", no_argument, NULL, 'A'},
     {"freedb",      no_argument, NULL, 'F'},
     {"musicbrainz", no_argument, NULL, 'M'},
     {"all",         no_argument, NULL, 'a'},
+    {"cue",         no_argument, NULL, 257},  /* Long-only mode */
+    {"crc",         no_argument, NULL, 258},  /* Long-only mode */
+    {"text-files",  no_argument, NULL, 261},  /* Long-only mode */
 
     /* Actions */
     {"toc",         no_argument, NULL, 't'},
@@ -37,9 +41,22 @@ static struct option long_opts[] = {
     {"calculate",   no_argument, NULL, 'c'},
     {"quiet",       no_argument, NULL, 'q'},
     {"assume-audio", no_argument, NULL, 256},  /* Long-only option */
+    {"read-offset", required_argument, NULL, 259},  /* Long-only option */
+    {"ar-db",       required_argument, NULL, 260},  /* Long-only option */
+    {"exclusive",   no_argument, NULL, 263},  /* Long-only option */
+    {"expect",      required_argument, NULL, 264},  /* Long-only option */
+    {"fail-fast",   no_argument, NULL, 265},  /* Long-only option */
+    {"isrc-profile", required_argument, NULL, 266},  /* Long-only option */
+    {"repeat",      required_argument, NULL, 267},  /* Long-only option */
+    {"output",      required_argument, NULL, 268},  /* Long-only option */
+    {"format",      required_argument, NULL, 269},  /* Long-only option */
+    {"eject-when-done", no_argument, NULL, 270},  /* Long-only option */
+    {"changer",     required_argument, NULL, 271},  /* Long-only option */
+    {"drive",       required_argument, NULL, 272},  /* Long-only option */
 
     /* Standalone */
     {"list-drives", no_argument, NULL, 'L'},
+    {"media",       no_argument, NULL, 262},  /* Long-only option */
     {"help",        no_argument, NULL, 'h'},
     {"version",     no_argument, NULL, 'V'},
 
@@ -59,11 +76,15 @@ static cli_mode_t char_to_mode(int c)
     case 'X': return MODE_TEXT;
     case 'C': return MODE_MCN;
     case 'I': return MODE_ISRC;
+    case 'G': return MODE_GAPS;
     case 'R': return MODE_RAW;
     case 'A': return MODE_ACCURATERIP;
     case 'F': return MODE_FREEDB;
     case 'M': return MODE_MUSICBRAINZ;
     case 'a': return MODE_ALL;
+    case 257: return MODE_CUE;
+    case 258: return MODE_CRC;
+    case 261: return MODE_TEXT_FILES;
     default:  return MODE_NONE;
     }
 }
@@ -88,11 +109,15 @@ int cli_parse(int argc, char **argv, options_t *opts)
         case 'X':
         case 'C':
         case 'I':
+        case 'G':
         case 'R':
         case 'A':
         case 'F':
         case 'M':
         case 'a':
+        case 257:  /* --cue */
+        case 258:  /* --crc */
+        case 261:  /* --text-files */
             if (opts->mode != MODE_NONE) {
                 mode_count++;
             }
@@ -124,11 +149,87 @@ int cli_parse(int argc, char **argv, options_t *opts)
         case 256:  /* --assume-audio */
             opts->assume_audio = true;
             break;
+        case 259: {  /* --read-offset */
+            char *end;
+            long offset = strtol(optarg, &end, 10);
+            if (end == optarg || *end != '\0' ||
+                offset < -MAX_READ_OFFSET || offset > MAX_READ_OFFSET) {
+                error_quiet(opts->quiet, "cli: invalid read offset: %s", optarg);
+                return EX_USAGE;
+            }
+            opts->read_offset = (int)offset;
+            opts->has_read_offset = true;
+            break;
+        }
+        case 260:  /* --ar-db */
+            opts->ar_db = optarg;
+            break;
+        case 263:  /* --exclusive */
+            opts->exclusive = true;
+            break;
+        case 264:  /* --expect */
+            opts->expect = optarg;
+            break;
+        case 265:  /* --fail-fast */
+            opts->fail_fast = true;
+            break;
+        case 266:  /* --isrc-profile */
+            opts->isrc_profile = optarg;
+            break;
+        case 267: {  /* --repeat=N[,seek|,flush] */
+            char *end;
+            long count = strtol(optarg, &end, 10);
+            if (end == optarg || count < 1 || count > MAX_REPEAT ||
+                (*end != '\0' && *end != ',')) {
+                error_quiet(opts->quiet, "cli: invalid repeat count: %s", optarg);
+                return EX_USAGE;
+            }
+            if (*end == '\0') {
+                opts->repeat_reset = REPEAT_RESET_NONE;
+            } else if (strcmp(end, ",seek") == 0) {
+                opts->repeat_reset = REPEAT_RESET_SEEK;
+            } else if (strcmp(end, ",flush") == 0) {
+                opts->repeat_reset = REPEAT_RESET_FLUSH;
+            } else {
+                error_quiet(opts->quiet, "cli: invalid repeat reset: %s (not seek or flush)",
+                            end + 1);
+                return EX_USAGE;
+            }
+            opts->repeat = (int)count;
+            break;
+        }
+        case 268:  /* --output */
+            if (strcmp(optarg, "text") == 0) {
+                opts->output = OUTPUT_TEXT;
+            } else if (strcmp(optarg, "json") == 0) {
+                opts->output = OUTPUT_JSON;
+            } else if (strcmp(optarg, "tsv") == 0) {
+                opts->output = OUTPUT_TSV;
+            } else {
+                error_quiet(opts->quiet, "cli: invalid output format: %s", optarg);
+                return EX_USAGE;
+            }
+            break;
+        case 269:  /* --format */
+            opts->format = optarg;
+            break;
+        case 270:  /* --eject-when-done */
+            opts->eject = true;
+            break;
+        case 271:  /* --changer */
+            opts->changer = optarg;
+            break;
+        case 272:  /* --drive */
+            opts->drive = optarg;
+            break;
 
         /* Standalone */
         case 'L':
             opts->list_drives = true;
             break;
+        case 262:  /* --media */
+            opts->media = true;
+            break;
         case 'h':
             opts->help = true;
             break;
@@ -179,6 +280,10 @@ int cli_parse(int argc, char **argv, options_t *opts)
             }
 
             opts->cdtoc = cdtoc;
+        } else if (opts->mode == MODE_TEXT_FILES) {
+            /* Every argument is a CD-Text file */
+            opts->files = argv + optind;
+            opts->file_count = argc - optind;
         } else {
             /* Single device argument */
             if (argc - optind > 1) {
@@ -197,12 +302,37 @@ int cli_parse(int argc, char **argv, options_t *opts)
  */
 int cli_validate(const options_t *opts)
 {
+    /* --media only modifies the drive listing */
+    if (opts->media && !opts->list_drives) {
+        error_quiet(opts->quiet, "cli: --media requires -L");
+        return EX_USAGE;
+    }
+
     /* Standalone options skip other validation */
     if (opts->help || opts->version || opts->list_drives)
         return 0;
 
-    /* Must have device or -c */
-    if (!opts->calculate && !opts->device) {
+    /* A changer batch reads its own drive, one disc per slot */
+    if (opts->drive && !opts->changer) {
+        error_quiet(opts->quiet, "cli: --drive requires --changer");
+        return EX_USAGE;
+    }
+    if (opts->changer) {
+        const char *other = opts->calculate ? "-c" :
+                            opts->mode == MODE_TEXT_FILES ? "--text-files" :
+                            opts->device ? "a device argument" :
+                            opts->repeat > 0 ? "--repeat" :
+                            opts->eject ? "--eject-when-done" :
+                            (opts->actions & ACTION_OPEN) ? "-o" : NULL;
+        if (other) {
+            error_quiet(opts->quiet, "cli: --changer and %s are mutually exclusive", other);
+            return EX_USAGE;
+        }
+    }
+
+    /* Must have device, changer or -c (CD-Text files default to stdin) */
+    if (!opts->calculate && !opts->device && !opts->changer &&
+        opts->mode != MODE_TEXT_FILES) {
         cli_print_help();
         return EX_USAGE;
     }
@@ -215,20 +345,91 @@ int cli_validate(const options_t *opts)
         }
     }
 
+    /* --read-offset only valid with --crc */
+    if (opts->has_read_offset && opts->mode != MODE_CRC) {
+        error_quiet(opts->quiet, "cli: --read-offset requires --crc");
+        return EX_USAGE;
+    }
+
+    /* --ar-db only valid where there is an AccurateRip ID to look up */
+    if (opts->ar_db && opts->mode != MODE_ACCURATERIP && opts->mode != MODE_CRC) {
+        error_quiet(opts->quiet, "cli: --ar-db requires -A or --crc");
+        return EX_USAGE;
+    }
+
+    /* --expect turns -I into verification */
+    if (opts->expect && opts->mode != MODE_ISRC) {
+        error_quiet(opts->quiet, "cli: --expect requires -I");
+        return EX_USAGE;
+    }
+    if (opts->fail_fast && !opts->expect) {
+        error_quiet(opts->quiet, "cli: --fail-fast requires --expect");
+        return EX_USAGE;
+    }
+
+    /* --isrc-profile only applies where ISRCs are read from a disc
+     * (no mode and no action is -a) */
+    if (opts->isrc_profile) {
+        bool reads_isrc = opts->mode == MODE_ISRC || opts->mode == MODE_ALL ||
+                          opts->mode == MODE_CUE ||
+                          (opts->mode == MODE_NONE && opts->actions == ACTION_NONE);
+        if (!reads_isrc || opts->calculate) {
+            error_quiet(opts->quiet, "cli: --isrc-profile requires -I, -a or --cue");
+            return EX_USAGE;
+        }
+    }
+
+    /* --exclusive only applies when a drive is read */
+    if (opts->exclusive && (opts->calculate || opts->mode == MODE_TEXT_FILES)) {
+        error_quiet(opts->quiet, "cli: --exclusive requires a device");
+        return EX_USAGE;
+    }
+    if (opts->repeat > 0 && (opts->calculate || opts->mode == MODE_TEXT_FILES)) {
+        error_quiet(opts->quiet, "cli: --repeat requires a device");
+        return EX_USAGE;
+    }
+    if (opts->eject && (opts->calculate || opts->mode == MODE_TEXT_FILES)) {
+        error_quiet(opts->quiet, "cli: --eject-when-done requires a device");
+        return EX_USAGE;
+    }
+
+    /* A record or template holds the disc, not browser launches or
+     * database matches */
+    if (opts->format && opts->output != OUTPUT_TEXT) {
+        error_quiet(opts->quiet, "cli: --format and --output are mutually exclusive");
+        return EX_USAGE;
+    }
+    if (opts->output != OUTPUT_TEXT || opts->format) {
+        if (opts->mode == MODE_TEXT_FILES || (opts->actions & ACTION_OPEN) || opts->ar_db) {
+            error_quiet(opts->quiet, "cli: %s and %s are mutually exclusive",
+                        opts->format ? "--format" : "--output",
+                        opts->mode == MODE_TEXT_FILES ? "--text-files" :
+                        (opts->actions & ACTION_OPEN) ? "-o" : "--ar-db");
+            return EX_USAGE;
+        }
+    }
+
     /* -c with disc-required modes */
     if (opts->calculate) {
         if (opts->mode == MODE_TYPE || opts->mode == MODE_TEXT ||
             opts->mode == MODE_MCN || opts->mode == MODE_ISRC ||
+            opts->mode == MODE_GAPS || opts->mode == MODE_CUE ||
+            opts->mode == MODE_CRC || opts->mode == MODE_TEXT_FILES ||
             opts->mode == MODE_RAW || opts->mode == MODE_ALL) {
 
-            if (opts->mode == MODE_RAW || opts->mode == MODE_ALL) {
+            if (opts->mode == MODE_RAW || opts->mode == MODE_ALL ||
+                opts->mode == MODE_TEXT_FILES) {
                 error_quiet(opts->quiet, "cli: -c and %s are mutually exclusive",
-                           opts->mode == MODE_RAW ? "-R" : "-a");
+                           opts->mode == MODE_RAW ? "-R" :
+                           opts->mode == MODE_ALL ? "-a" : "--text-files");
             } else {
                 error_quiet(opts->quiet, "cli: %s requires a disc",
                            opts->mode == MODE_TYPE ? "-T" :
                            opts->mode == MODE_TEXT ? "-X" :
-                           opts->mode == MODE_MCN ? "-C" : "-I");
+                           opts->mode == MODE_MCN ? "-C" :
+                           opts->mode == MODE_GAPS ? "-G" :
+                           opts->mode == MODE_CUE ? "--cue" :
+                           opts->mode == MODE_CRC ? "--crc" : "-I");
             }
             return EX_USAGE;
         }
@@ -305,7 +506,8 @@ void cli_print_help(void)
 {
     printf("Usage: mbdiscid [options] <DEVICE>\n");
     printf("       mbdiscid [options] -c <TOC>\n");
-    printf("       mbdiscid -L\n");
+    printf("       mbdiscid --text-files [<FILE>...]\n");
+    printf("       mbdiscid -L [--media]\n");
     printf("\n");
     printf("Calculate disc IDs and TOC from CD or CDTOC data.\n");
     printf("\n");
@@ -314,11 +516,15 @@ void cli_print_help(void)
     printf("  -X, --text          CD-Text metadata\n");
     printf("  -C, --catalog       Media Catalog Number (MCN/barcode)\n");
     printf("  -I, --isrc          ISRC codes\n");
+    printf("  -G, --gaps          Pregaps, indices and hidden track\n");
     printf("  -R, --raw           Raw TOC\n");
     printf("  -A, --accuraterip   AccurateRip ID and TOC\n");
     printf("  -F, --freedb        FreeDB/CDDB ID and TOC\n");
     printf("  -M, --musicbrainz   MusicBrainz ID and TOC\n");
     printf("  -a, --all           All modes (default)\n");
+    printf("      --cue           CUE sheet (TOC, indices, MCN, ISRC, CD-Text)\n");
+    printf("      --crc           AccurateRip v1/v2 and CRC-32 of each audio track\n");
+    printf("      --text-files    CD-Text (as -X) from .cdt or READ TOC format 5 files\n");
     printf("\n");
     printf("Action options (combinable):\n");
     printf("  -t, --toc           Display TOC\n");
@@ -331,6 +537,25 @@ void cli_print_help(void)
     printf("  -q, --quiet         Suppress error messages\n");
     printf("  -v, --verbose       Increase verbosity (repeat for more)\n");
     printf("      --assume-audio  Allow raw TOC input for AccurateRip (assumes CD-DA)\n");
+    printf("      --read-offset=N Drive read offset in samples for --crc\n");
+    printf("      --ar-db=DIR     Look up -A or --crc in a local AccurateRip mirror\n");
+    printf("      --exclusive     Hold the drive exclusively and pause media polling\n");
+    printf("      --expect=ISRCS  With -I, verify against a file or list of ISRCs\n");
+    printf("      --fail-fast     With --expect, stop at the first mismatch\n");
+    printf("      --isrc-profile=P\n");
+    printf("                      ISRC sampling: fast, balanced or paranoid[,key=N...]\n");
+    printf("      --repeat=N[,seek|,flush]\n");
+    printf("                      Read the disc N times and report consistency and timing\n");
+    printf("      --output=FORMAT Print one record per disc: text (default), json or tsv\n");
+    printf("      --format=TEMPLATE\n");
+    printf("                      Print fields such as {mb_id} or {track.isrc}, per track\n");
+    printf("                      if any track field is used\n");
+    printf("      --eject-when-done\n");
+    printf("                      Eject the disc as soon as it is read\n");
+    printf("      --changer=DEV   Identify every disc in a media changer (/dev/sgN), or\n");
+    printf("                      in a simulated one (.changer file)\n");
+    printf("      --drive=DEV     The changer's drive (/dev/srN)\n");
+    printf("      --media         Add media state and disc profile to -L\n");
     printf("\n");
     printf("Standalone options:\n");
     printf("  -L, --list-drives   List available optical drives\n");
@@ -346,6 +571,8 @@ void cli_print_help(void)
     printf("Raw TOC format is auto-detected and accepted for -Mc and -Fc.\n");
     printf("AccurateRip (-Ac) requires AccurateRip format, or use --assume-audio\n");
     printf("with raw format for standard CD-DA discs.\n");
+    printf("\n");
+    printf("<DEVICE> may also be a disc image (.cue, .ccd or .toc).\n");
 }
 
 /*
@@ -366,6 +593,9 @@ bool cli_mode_requires_disc(cli_mode_t mode)
     case MODE_TEXT:
     case MODE_MCN:
     case MODE_ISRC:
+    case MODE_GAPS:
+    case MODE_CUE:
+    case MODE_CRC:
     case MODE_RAW:
     case MODE_ALL:
         return true;
@@ -388,6 +618,10 @@ bool cli_action_valid_for_mode(action_t action, cli_mode_t mode)
     case MODE_TEXT:
     case MODE_MCN:
     case MODE_ISRC:
+    case MODE_GAPS:
+    case MODE_CUE:
+    case MODE_CRC:
+    case MODE_TEXT_FILES:
         /* These only support ID (value) */
         return action == ACTION_ID;
 
@@ -8,8 +8,11 @@
 #include "device.h"
 #include "toc.h"
 #include "isrc.h"
+#include "indexmap.h"
+#include "audio.h"
 #include "cdtext.h"
 #include "scsi.h"
+#include "image.h"
 #include "util.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,6 +21,13 @@
 #include <fcntl.h>
 #include <discid/discid.h>
 
+#ifndef PLATFORM_MACOS
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#endif
+
 #ifdef PLATFORM_MACOS
 #include <sys/ioctl.h>
 #include <IOKit/storage/IOCDMediaBSDClient.h>
@@ -126,7 +136,7 @@ static bool read_full_toc_ioctl(const char *device, int *first_track,
         /* A2 entry: leadout position for this session */
         else if (point == 0xA2) {
             int32_t leadout_lba = ((int32_t)desc->pmin * 60 + desc->psec) * 75 + desc->pframe - 150;
-            if (sess >= 1 && sess <= 10) {
+            if (sess >= 1 && sess <= MAX_SESSIONS) {
                 session_leadouts[sess - 1] = leadout_lba;
             }
         }
@@ -230,72 +240,97 @@ const char *device_get_default(void)
 
 /*
  * Read TOC from device using libdiscid + SCSI/ioctl for full TOC
+ * Disc images bypass libdiscid and are read entirely via the SCSI layer
  */
 int device_read_toc(const char *device, toc_t *toc, int verbosity)
 {
-    DiscId *disc = discid_new();
-    if (!disc) {
-        return EX_SOFTWARE;
-    }
-
     /* Normalize device path (e.g., /dev/diskN -> /dev/rdiskN on macOS) */
     char *dev_path = device_normalize_path(device);
+    bool is_image = image_is_image_path(dev_path);
+    DiscId *disc = NULL;
+    int libdiscid_first = 0, libdiscid_last = 0;
+    int32_t libdiscid_leadout = 0;
 
     verbose(1, verbosity, "device: opening %s", dev_path);
 
-    /* Read basic TOC - MCN and ISRC will be read separately */
-    int result = discid_read_sparse(disc, dev_path, 0);
-    if (!result) {
-        const char *err = discid_get_error_msg(disc);
-        error("device: cannot read disc: %s", err ? err : "unknown error");
-        discid_free(disc);
-        free(dev_path);
-        return EX_IOERR;
-    }
+    if (!is_image) {
+        disc = discid_new();
+        if (!disc) {
+            free(dev_path);
+            return EX_SOFTWARE;
+        }
 
-    toc_init(toc);
+        /* Read basic TOC - MCN and ISRC will be read separately */
+        int result = discid_read_sparse(disc, dev_path, 0);
+        if (!result) {
+            const char *err = discid_get_error_msg(disc);
+            error("device: cannot read disc: %s", err ? err : "unknown error");
+            discid_free(disc);
+            free(dev_path);
+            return EX_IOERR;
+        }
 
-    /* Get basic TOC info from libdiscid */
-    int libdiscid_first = discid_get_first_track_num(disc);
-    int libdiscid_last = discid_get_last_track_num(disc);
-    int32_t libdiscid_leadout = discid_get_sectors(disc) - PREGAP_FRAMES;
+        /* Get basic TOC info from libdiscid */
+        libdiscid_first = discid_get_first_track_num(disc);
+        libdiscid_last = discid_get_last_track_num(disc);
+        libdiscid_leadout = discid_get_sectors(disc) - PREGAP_FRAMES;
 
-    verbose(2, verbosity, "toc: libdiscid reports tracks %d-%d, leadout %d",
-            libdiscid_first, libdiscid_last, libdiscid_leadout);
+        verbose(2, verbosity, "toc: libdiscid reports tracks %d-%d, leadout %d",
+                libdiscid_first, libdiscid_last, libdiscid_leadout);
+    }
+
+    toc_init(toc);
 
     /* Read Full TOC via SCSI/ioctl for complete track info including multi-session */
     uint8_t track_control[100] = {0};
     uint8_t track_session[100] = {0};
     int32_t track_offsets[100] = {0};
-    int32_t session_leadouts[10] = {0};
+    int32_t session_leadouts[MAX_SESSIONS] = {0};
     int scsi_first = 0, scsi_last = 0;
     int last_session = 1;
     bool have_full_toc = false;
 
 #ifdef PLATFORM_MACOS
-    /* On macOS, use BSD ioctl */
-    have_full_toc = read_full_toc_ioctl(device, &scsi_first, &scsi_last,
-                                         track_control, track_session, track_offsets,
-                                         session_leadouts, &last_session);
-    if (have_full_toc) {
-        verbose(2, verbosity, "toc: full TOC reports tracks %d-%d, %d session(s)",
-                scsi_first, scsi_last, last_session);
-    }
-#else
-    /* On Linux, use SCSI Full TOC (format 2) */
-    scsi_device_t *scsi = scsi_open(device);
-    if (scsi) {
-        have_full_toc = scsi_read_full_toc(scsi, &scsi_first, &scsi_last,
-                                            track_control, track_session, track_offsets,
-                                            session_leadouts, &last_session);
+    /* On macOS, use BSD ioctl for drives */
+    bool use_scsi = is_image;
+    if (!is_image) {
+        have_full_toc = read_full_toc_ioctl(device, &scsi_first, &scsi_last,
+                                             track_control, track_session, track_offsets,
+                                             session_leadouts, &last_session);
         if (have_full_toc) {
             verbose(2, verbosity, "toc: full TOC reports tracks %d-%d, %d session(s)",
                     scsi_first, scsi_last, last_session);
         }
-        scsi_close(scsi);
     }
+#else
+    bool use_scsi = true;
 #endif
 
+    /* On Linux and for disc images, use SCSI Full TOC (format 2) */
+    if (use_scsi) {
+        scsi_device_t *scsi = scsi_open(device);
+        if (scsi) {
+            have_full_toc = scsi_read_full_toc(scsi, &scsi_first, &scsi_last,
+                                                track_control, track_session, track_offsets,
+                                                session_leadouts, &last_session);
+            if (have_full_toc) {
+                verbose(2, verbosity, "toc: full TOC reports tracks %d-%d, %d session(s)",
+                        scsi_first, scsi_last, last_session);
+            }
+            scsi_close(scsi);
+        }
+    }
+
+    /* An image has no other TOC source; image_open() has reported why */
+    if (is_image && !have_full_toc) {
+        free(dev_path);
+        return EX_NOINPUT;
+    }
+    if (is_image) {
+        libdiscid_first = scsi_first;
+        libdiscid_last = scsi_last;
+    }
+
     /* Determine actual track range (use SCSI if available and has more tracks) */
     int actual_first = libdiscid_first;
     int actual_last = (have_full_toc && scsi_last > libdiscid_last) ? scsi_last : libdiscid_last;
@@ -314,7 +349,7 @@ int device_read_toc(const char *device, toc_t *toc, int verbosity)
         track->number = t;
 
         /* Get offset - prefer SCSI if available, fall back to libdiscid */
-        if (have_full_toc && track_offsets[t] != 0) {
+        if (have_full_toc && (track_offsets[t] != 0 || !disc)) {
             track->offset = track_offsets[t];
         } else if (t >= libdiscid_first && t <= libdiscid_last) {
             track->offset = discid_get_track_offset(disc, t) - PREGAP_FRAMES;
@@ -356,6 +391,9 @@ int device_read_toc(const char *device, toc_t *toc, int verbosity)
         toc->leadout = libdiscid_leadout;
     }
 
+    if (have_full_toc)
+        memcpy(toc->session_leadouts, session_leadouts, sizeof(toc->session_leadouts));
+
     /* Determine audio_leadout for AccurateRip calculations */
     /* For Enhanced CDs: audio_leadout = start of first data track (end of audio session) */
     /* For other discs: audio_leadout = disc leadout */
@@ -401,16 +439,43 @@ int device_read_toc(const char *device, toc_t *toc, int verbosity)
                 toc->tracks[i].type == TRACK_TYPE_DATA ? "data" : "audio");
     }
 
-    discid_free(disc);
+    if (disc)
+        discid_free(disc);
     free(dev_path);
     return 0;
 }
 
+/*
+ * Read MCN from a disc image via the SCSI layer
+ */
+static int read_image_mcn(const char *device, char *mcn, int verbosity)
+{
+    mcn[0] = '\0';
+
+    scsi_device_t *scsi = scsi_open(device);
+    if (!scsi) {
+        return EX_IOERR;
+    }
+
+    if (scsi_read_mcn(scsi, mcn)) {
+        verbose(1, verbosity, "mcn: %s", mcn);
+    } else {
+        verbose(1, verbosity, "mcn: not present");
+    }
+
+    scsi_close(scsi);
+    return 0;
+}
+
 /*
  * Read MCN from device
  */
 int device_read_mcn(const char *device, char *mcn, int verbosity)
 {
+    if (image_is_image_path(device)) {
+        return read_image_mcn(device, mcn, verbosity);
+    }
+
     DiscId *disc = discid_new();
     if (!disc) {
         return EX_SOFTWARE;
@@ -418,7 +483,9 @@ int device_read_mcn(const char *device, char *mcn, int verbosity)
 
     /* Suppress stderr during MCN reading - libdiscid may emit warnings
      * for drives that don't support MCN, but per spec §6.1.1, absence
-     * of optional metadata must produce no output */
+     * of optional metadata must produce no output. Pending verbose
+     * lines go out first so they are not lost to /dev/null */
+    verbose_flush();
     int saved_stderr = dup(STDERR_FILENO);
     int devnull = open("/dev/null", O_WRONLY);
     if (devnull >= 0) {
@@ -468,6 +535,74 @@ int device_read_isrc(const char *device, toc_t *toc, int verbosity)
     return 0;
 }
 
+/*
+ * Select the ISRC sampling profile
+ */
+int device_set_isrc_profile(const char *spec)
+{
+    return isrc_set_profile(spec);
+}
+
+/* Seconds each phase of the last acquisition took (device_phase_times) */
+static double phase_seconds[PHASE_COUNT];
+
+void device_phase_times(double *seconds)
+{
+    memcpy(seconds, phase_seconds, sizeof(phase_seconds));
+}
+
+/*
+ * Verify ISRCs against expected values
+ */
+int device_verify_isrc(const char *device, const toc_t *toc, const char *expect,
+                       isrc_check_t *checks, bool fail_fast, int verbosity)
+{
+    int ret = isrc_parse_expected(expect, toc, checks);
+    if (ret != 0)
+        return ret;
+
+    char *dev_path = device_normalize_path(device);
+    double start = monotonic_seconds();
+    int result = isrc_verify_disc(toc, dev_path, checks, fail_fast, verbosity);
+    phase_seconds[PHASE_VERIFY] = monotonic_seconds() - start;
+    free(dev_path);
+
+    /* isrc_verify_disc returns -1 on error, >= 0 for tracks not matching */
+    return result < 0 ? EX_IOERR : 0;
+}
+
+/*
+ * Read pregap/index map from device
+ */
+int device_read_indexes(const char *device, const toc_t *toc, index_map_t *map,
+                        int verbosity)
+{
+    int result = indexmap_read_disc(toc, device, map, verbosity);
+
+    /* indexmap_read_disc returns -1 on error, >= 0 for count of tracks mapped */
+    if (result < 0) {
+        return EX_IOERR;
+    }
+
+    return result > 0 ? 0 : EX_IOERR;
+}
+
+/*
+ * Read audio tracks and compute their checksums
+ */
+int device_read_audio(const char *device, const toc_t *toc, int read_offset,
+                      track_crc_t *crcs, int verbosity)
+{
+    char *dev_path = device_normalize_path(device);
+    double start = monotonic_seconds();
+    int result = audio_read_crcs(toc, dev_path, read_offset, crcs, verbosity);
+    phase_seconds[PHASE_AUDIO] = monotonic_seconds() - start;
+    free(dev_path);
+
+    /* audio_read_crcs reports its own errors */
+    return result < 0 ? EX_IOERR : 0;
+}
+
 /*
  * Read CD-Text from device
  * On macOS: uses BSD ioctl (DKIOCCDREADTOC with kCDTOCFormatText)
@@ -488,30 +623,33 @@ int device_read_cdtext(const char *device, cdtext_t *cdtext, int verbosity)
 
 #ifdef PLATFORM_MACOS
     /* On macOS, use BSD ioctl to avoid SCSI/Disk Arbitration complexity */
-    if (!read_cdtext_ioctl(dev_path, &raw_data, &raw_len)) {
-        verbose(1, verbosity, "cdtext: not present");
-        free(dev_path);
-        return 0;  /* Not an error - CD-Text is optional */
-    }
-#else
-    /* On Linux, use SCSI (works fine without exclusive access issues) */
-    scsi_device_t *scsi = scsi_open(dev_path);
-    if (!scsi) {
-        verbose(1, verbosity, "cdtext: failed to open device");
-        free(dev_path);
-        return 0;  /* Not an error - CD-Text is optional */
-    }
+    if (!image_is_image_path(dev_path)) {
+        if (!read_cdtext_ioctl(dev_path, &raw_data, &raw_len)) {
+            verbose(1, verbosity, "cdtext: not present");
+            free(dev_path);
+            return 0;  /* Not an error - CD-Text is optional */
+        }
+    } else
+#endif
+    {
+        /* On Linux and for disc images, use SCSI */
+        scsi_device_t *scsi = scsi_open(dev_path);
+        if (!scsi) {
+            verbose(1, verbosity, "cdtext: failed to open device");
+            free(dev_path);
+            return 0;  /* Not an error - CD-Text is optional */
+        }
+
+        if (!scsi_read_cdtext_raw(scsi, &raw_data, &raw_len)) {
+            verbose(1, verbosity, "cdtext: not present");
+            scsi_close(scsi);
+            free(dev_path);
+            return 0;  /* Not an error - CD-Text is optional */
+        }
 
-    if (!scsi_read_cdtext_raw(scsi, &raw_data, &raw_len)) {
-        verbose(1, verbosity, "cdtext: not present");
         scsi_close(scsi);
-        free(dev_path);
-        return 0;  /* Not an error - CD-Text is optional */
     }
 
-    scsi_close(scsi);
-#endif
-
     free(dev_path);
 
     verbose(2, verbosity, "cdtext: %zu bytes of raw data", raw_len);
@@ -537,12 +675,15 @@ int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbo
     int ret;
 
     memset(disc, 0, sizeof(*disc));
+    memset(phase_seconds, 0, sizeof(phase_seconds));
+    double start = monotonic_seconds();
 
     /* Normalize device path (e.g., /dev/diskN -> /dev/rdiskN on macOS) */
     char *dev_path = device_normalize_path(device);
 
     /* Read TOC (always required) */
     ret = device_read_toc(dev_path, &disc->toc, verbosity);
+    phase_seconds[PHASE_TOC] = monotonic_seconds() - start;
     if (ret != 0) {
         free(dev_path);
         return ret;
@@ -553,7 +694,9 @@ int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbo
 
     /* Read MCN if requested */
     if (flags & READ_MCN) {
+        start = monotonic_seconds();
         ret = device_read_mcn(dev_path, disc->ids.mcn, verbosity);
+        phase_seconds[PHASE_MCN] = monotonic_seconds() - start;
         if (ret == 0 && disc->ids.mcn[0] != '\0') {
             disc->has_mcn = true;
         }
@@ -561,7 +704,9 @@ int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbo
 
     /* Read ISRCs if requested */
     if (flags & READ_ISRC) {
+        start = monotonic_seconds();
         ret = device_read_isrc(dev_path, &disc->toc, verbosity);
+        phase_seconds[PHASE_ISRC] = monotonic_seconds() - start;
         if (ret == 0) {
             /* Check if any valid ISRCs were found */
             for (int i = 0; i < disc->toc.track_count; i++) {
@@ -575,20 +720,22 @@ int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbo
 
     /* Read CD-Text if requested */
     if (flags & READ_CDTEXT) {
+        start = monotonic_seconds();
         ret = device_read_cdtext(dev_path, &disc->cdtext, verbosity);
+        phase_seconds[PHASE_CDTEXT] = monotonic_seconds() - start;
         if (ret == 0) {
             /* Check if we got any CD-Text */
-            if (disc->cdtext.album.album || disc->cdtext.album.albumartist) {
-                disc->has_cdtext = true;
-            } else {
-                /* Also check for any track-level text */
-                for (int i = 0; i < disc->cdtext.track_count; i++) {
-                    if (disc->cdtext.tracks[i].title || disc->cdtext.tracks[i].artist) {
-                        disc->has_cdtext = true;
-                        break;
-                    }
-                }
-            }
+            disc->has_cdtext = cdtext_has_text(&disc->cdtext);
+        }
+    }
+
+    /* Read index map if requested */
+    if (flags & READ_INDEXES) {
+        start = monotonic_seconds();
+        ret = device_read_indexes(dev_path, &disc->toc, &disc->indexes, verbosity);
+        phase_seconds[PHASE_INDEXES] = monotonic_seconds() - start;
+        if (ret == 0) {
+            disc->has_indexes = true;
         }
     }
 
@@ -596,50 +743,394 @@ int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbo
     return 0;
 }
 
+void device_quiesce(const char *device, int verbosity)
+{
+    char *dev_path = device_normalize_path(device);
+    scsi_quiesce(dev_path, verbosity);
+    free(dev_path);
+}
+
+void device_resume(void)
+{
+    scsi_resume();
+}
+
+int device_eject(const char *device, int verbosity)
+{
+    char *dev_path = device_normalize_path(device);
+
+    if (image_is_image_path(dev_path)) {
+        verbose(1, verbosity, "device: %s: disc image, nothing to eject", dev_path);
+        free(dev_path);
+        return 0;
+    }
+
+    scsi_device_t *scsi = scsi_open(dev_path);
+    if (!scsi) {
+        error("device: cannot eject: %s", dev_path);
+        free(dev_path);
+        return EX_IOERR;
+    }
+    scsi_set_verbosity(scsi, verbosity);
+
+    int ret = 0;
+    if (!scsi_eject(scsi)) {
+        error("device: cannot eject: %s", scsi_error(scsi));
+        ret = EX_IOERR;
+    }
+
+    scsi_close(scsi);
+    free(dev_path);
+    return ret;
+}
+
+#ifndef PLATFORM_MACOS
+/* Sysfs root for block devices */
+#define SYSFS_BLOCK "/sys/class/block"
+
+/* SCSI peripheral device type of a CD/DVD drive */
+#define SCSI_TYPE_MMC 5
+
+/* One optical drive found in sysfs */
+typedef struct {
+    char name[32];          /* Block device name (sr0) */
+    char sg[32];            /* SCSI generic node name (sg0) or empty */
+    char vendor[16];
+    char model[32];
+    char rev[16];
+    char bus[32];           /* Bus the drive shares (usb2-1, ata3, host6) */
+    bool shared_bus;        /* Probed one drive at a time */
+    bool probed;
+    bool present;
+    bool tray_open;
+    int profile;
+    double start, end;      /* Probe timing, seconds */
+} drive_t;
+
 /*
- * List optical drives
- * Per spec §8.7: output exactly as produced by system tools
- * If no drives, output is empty with EX_OK
+ * Read the first line of a sysfs attribute, trailing blanks trimmed
+ * Returns false if the attribute cannot be read
  */
-int device_list_drives(void)
+static bool read_attr(const char *name, const char *attr, char *buf, size_t size)
 {
-#ifdef PLATFORM_MACOS
-    /* §8.7.3: Print drutil output exactly as produced */
-    int ret = system("drutil status 2>/dev/null");
-    (void)ret;  /* Ignore return - empty output for no drives per §8.7.1 */
-#else
-    /* §8.7.2: Print lsblk output exactly as produced */
-    int ret = system("lsblk -dp -I 11 -o NAME,VENDOR,MODEL,REV 2>/dev/null");
-    (void)ret;  /* Ignore return - empty output for no drives per §8.7.1 */
-#endif
+    char path[256];
+    snprintf(path, sizeof(path), SYSFS_BLOCK "/%s/device/%s", name, attr);
 
-    return EX_OK;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0)
+        return false;
+
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' '))
+        n--;
+    buf[n] = '\0';
+    return true;
 }
 
 /*
- * Free CD-Text structure
+ * Find the SCSI generic node bound to the same SCSI device
  */
-void cdtext_free(cdtext_t *cdtext)
+static void find_sg(const char *name, char *sg, size_t size)
 {
-    if (!cdtext)
+    char path[256];
+    snprintf(path, sizeof(path), SYSFS_BLOCK "/%s/device/scsi_generic", name);
+
+    sg[0] = '\0';
+    DIR *dir = opendir(path);
+    if (!dir)
         return;
 
-    free(cdtext->album.album);
-    free(cdtext->album.albumartist);
-    free(cdtext->album.genre);
-    free(cdtext->album.lyricist);
-    free(cdtext->album.composer);
-    free(cdtext->album.arranger);
-    free(cdtext->album.comment);
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL) {
+        if (e->d_name[0] != '.') {
+            /* A name that does not fit is no node we can open */
+            if ((size_t)snprintf(sg, size, "%s", e->d_name) >= size)
+                sg[0] = '\0';
+            break;
+        }
+    }
+    closedir(dir);
+}
 
-    for (int i = 0; i < cdtext->track_count; i++) {
-        free(cdtext->tracks[i].title);
-        free(cdtext->tracks[i].artist);
-        free(cdtext->tracks[i].lyricist);
-        free(cdtext->tracks[i].composer);
-        free(cdtext->tracks[i].arranger);
-        free(cdtext->tracks[i].comment);
+/*
+ * Bus a drive hangs off, from its sysfs device path: USB drives share
+ * the hub they are plugged into (usb2 for a root hub port, usb2-1 for
+ * hub 2-1), ATA drives their port (several sit behind a port
+ * multiplier), anything else its SCSI host. Drives on a USB hub or ATA
+ * port contend for it; SCSI hosts (SAS, virtual) are taken as parallel.
+ */
+static void find_bus(drive_t *d)
+{
+    /* The class link holds the whole chain: ../../devices/.../host6/.../block/sr0 */
+    char link[256], path[PATH_MAX];
+    snprintf(link, sizeof(link), SYSFS_BLOCK "/%s", d->name);
+
+    d->bus[0] = '\0';
+    d->shared_bus = false;
+    ssize_t len = readlink(link, path, sizeof(path) - 1);
+    if (len < 0)
+        return;
+    path[len] = '\0';
+
+    char hub[32] = "", port[32] = "", ata[32] = "", host[32] = "";
+    for (char *c = strtok(path, "/"); c; c = strtok(NULL, "/")) {
+        if (strncmp(c, "usb", 3) == 0 && isdigit((unsigned char)c[3])) {
+            snprintf(hub, sizeof(hub), "%s", c);
+            port[0] = '\0';
+        } else if (hub[0] && isdigit((unsigned char)c[0]) && strchr(c, '-') &&
+                   !strchr(c, ':')) {
+            /* USB device: the previous one is the hub it is plugged into */
+            if (port[0])
+                snprintf(hub, sizeof(hub), "usb%s", port);
+            snprintf(port, sizeof(port), "%s", c);
+        } else if (strncmp(c, "ata", 3) == 0 && isdigit((unsigned char)c[3])) {
+            snprintf(ata, sizeof(ata), "%s", c);
+        } else if (strncmp(c, "host", 4) == 0 && isdigit((unsigned char)c[4]) && !host[0]) {
+            snprintf(host, sizeof(host), "%s", c);
+        }
     }
 
-    memset(cdtext, 0, sizeof(*cdtext));
+    const char *bus = port[0] ? hub : ata[0] ? ata : host;
+    snprintf(d->bus, sizeof(d->bus), "%s", bus);
+    d->shared_bus = port[0] || ata[0];
+}
+
+/*
+ * Order sr2 before sr10
+ */
+static int compare_drives(const void *a, const void *b)
+{
+    const drive_t *da = a, *db = b;
+    size_t la = strlen(da->name), lb = strlen(db->name);
+    if (la != lb)
+        return la < lb ? -1 : 1;
+    return strcmp(da->name, db->name);
+}
+
+/*
+ * Collect optical drives: block devices whose SCSI type is MMC
+ * Vendor, model and revision are the kernel's cached INQUIRY strings
+ * Returns drive count, *drives must be freed by caller
+ */
+static int scan_drives(drive_t **drives)
+{
+    int count = 0, cap = 0;
+
+    *drives = NULL;
+    DIR *dir = opendir(SYSFS_BLOCK);
+    if (!dir)
+        return 0;
+
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL) {
+        char type[8];
+        if (e->d_name[0] == '.' || strlen(e->d_name) >= sizeof((*drives)->name))
+            continue;
+        if (!read_attr(e->d_name, "type", type, sizeof(type)) ||
+            atoi(type) != SCSI_TYPE_MMC)
+            continue;
+
+        if (count == cap) {
+            cap = cap ? cap * 2 : 4;
+            *drives = xrealloc(*drives, (size_t)cap * sizeof(**drives));
+        }
+        drive_t *d = &(*drives)[count++];
+        memset(d, 0, sizeof(*d));
+        snprintf(d->name, sizeof(d->name), "%s", e->d_name);
+        read_attr(d->name, "vendor", d->vendor, sizeof(d->vendor));
+        read_attr(d->name, "model", d->model, sizeof(d->model));
+        read_attr(d->name, "rev", d->rev, sizeof(d->rev));
+        find_sg(d->name, d->sg, sizeof(d->sg));
+        find_bus(d);
+    }
+    closedir(dir);
+
+    if (count > 1)
+        qsort(*drives, (size_t)count, sizeof(**drives), compare_drives);
+    return count;
+}
+
+/*
+ * Probe one drive's tray and media state
+ */
+static void probe_drive(drive_t *d)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/%s", d->name);
+
+    d->start = monotonic_seconds();
+    scsi_device_t *scsi = scsi_open(path);
+    if (scsi) {
+        d->probed = scsi_get_media(scsi, &d->present, &d->tray_open, &d->profile);
+        scsi_close(scsi);
+    }
+    d->end = monotonic_seconds();
+}
+
+/* Drives probed by one thread, in order */
+typedef struct {
+    drive_t **drives;
+    int count;
+} probe_queue_t;
+
+static void *probe_thread(void *arg)
+{
+    probe_queue_t *queue = arg;
+    for (int i = 0; i < queue->count; i++)
+        probe_drive(queue->drives[i]);
+    return NULL;
+}
+
+/*
+ * Probe every drive: one thread per shared bus taking its drives in
+ * turn, and one per drive elsewhere, so contending drives queue while
+ * independent buses run in parallel
+ */
+static void probe_drives(drive_t *drives, int count, int verbosity)
+{
+    probe_queue_t *queues = xcalloc((size_t)count, sizeof(*queues));
+    drive_t **order = xmalloc((size_t)count * sizeof(*order));
+    int num_queues = 0, placed = 0;
+
+    for (int i = 0; i < count; i++) {
+        drive_t *d = &drives[i];
+        bool queued = false;
+        for (int j = 0; j < i && !queued; j++)
+            queued = drives[j].shared_bus && d->shared_bus &&
+                     strcmp(drives[j].bus, d->bus) == 0;
+        if (queued)
+            continue;
+
+        probe_queue_t *q = &queues[num_queues++];
+        q->drives = &order[placed];
+        order[placed++] = d;
+        for (int j = i + 1; j < count && d->shared_bus; j++) {
+            if (drives[j].shared_bus && strcmp(drives[j].bus, d->bus) == 0)
+                order[placed++] = &drives[j];
+        }
+        q->count = (int)(&order[placed] - q->drives);
+    }
+
+    pthread_t *tid = xmalloc((size_t)num_queues * sizeof(*tid));
+    bool *started = xcalloc((size_t)num_queues, sizeof(*started));
+    for (int i = 0; i < num_queues; i++)
+        started[i] = pthread_create(&tid[i], NULL, probe_thread, &queues[i]) == 0;
+    for (int i = 0; i < num_queues; i++) {
+        if (started[i])
+            pthread_join(tid[i], NULL);
+        else
+            probe_thread(&queues[i]);
+    }
+
+    /* Throughput per bus: drives over the span from first start to last end */
+    for (int i = 0; i < count && verbosity >= 1; i++) {
+        bool reported = false;
+        for (int j = 0; j < i && !reported; j++)
+            reported = strcmp(drives[j].bus, drives[i].bus) == 0;
+        if (reported)
+            continue;
+
+        int n = 0;
+        double first = drives[i].start, last = drives[i].end;
+        for (int j = i; j < count; j++) {
+            if (strcmp(drives[j].bus, drives[i].bus) != 0)
+                continue;
+            n++;
+            if (drives[j].start < first)
+                first = drives[j].start;
+            if (drives[j].end > last)
+                last = drives[j].end;
+        }
+        double span = last - first;
+        verbose(1, verbosity, "device: bus %s: %d drives probed in %.2fs (%.1f per second, %s)",
+                drives[i].bus[0] ? drives[i].bus : "unknown", n, span,
+                span > 0.0 ? n / span : 0.0,
+                drives[i].shared_bus ? "shared, one at a time" : "parallel");
+    }
+
+    free(started);
+    free(tid);
+    free(order);
+    free(queues);
+}
+
+/*
+ * Name of an MMC profile, or NULL if not a common one
+ */
+static const char *profile_name(int profile)
+{
+    switch (profile) {
+    case 0x0008: return "CD-ROM";
+    case 0x0009: return "CD-R";
+    case 0x000A: return "CD-RW";
+    case 0x0010: return "DVD-ROM";
+    case 0x0011: return "DVD-R";
+    case 0x0012: return "DVD-RAM";
+    case 0x0013:
+    case 0x0014: return "DVD-RW";
+    case 0x001A: return "DVD+RW";
+    case 0x001B: return "DVD+R";
+    case 0x002B: return "DVD+R DL";
+    case 0x0040: return "BD-ROM";
+    case 0x0041:
+    case 0x0042: return "BD-R";
+    case 0x0043: return "BD-RE";
+    default:     return NULL;
+    }
+}
+#endif
+
+/*
+ * List optical drives
+ * Per spec §8.7: one line per drive, empty output with EX_OK if none
+ */
+int device_list_drives(bool media, int verbosity)
+{
+#ifdef PLATFORM_MACOS
+    /* §8.7.3: Print drutil output exactly as produced */
+    (void)media;
+    (void)verbosity;
+    int ret = system("drutil status 2>/dev/null");
+    (void)ret;  /* Ignore return - empty output for no drives per §8.7.1 */
+#else
+    /* §8.7.2: Enumerate from sysfs without opening any device */
+    drive_t *drives;
+    int count = scan_drives(&drives);
+
+    verbose(1, verbosity, "device: %d optical drives", count);
+
+    /* One command pair per drive, contending drives in turn */
+    if (media && count > 0)
+        probe_drives(drives, count, verbosity);
+
+    for (int i = 0; i < count; i++) {
+        drive_t *d = &drives[i];
+        printf("/dev/%s\t%s%s\t%s\t%s\t%s", d->name,
+               d->sg[0] ? "/dev/" : "-", d->sg,
+               d->vendor[0] ? d->vendor : "-",
+               d->model[0] ? d->model : "-",
+               d->rev[0] ? d->rev : "-");
+
+        if (media) {
+            const char *state = !d->probed ? "unknown" :
+                                d->present ? "present" :
+                                d->tray_open ? "open" : "none";
+            const char *name = profile_name(d->profile);
+            if (name)
+                printf("\t%s\t%s", state, name);
+            else if (d->profile)
+                printf("\t%s\t0x%04X", state, d->profile);
+            else
+                printf("\t%s\t-", state);
+        }
+        printf("\n");
+    }
+
+    free(drives);
+#endif
+
+    return EX_OK;
 }
@@ -14,11 +14,13 @@
 #define READ_MCN     (1 << 0)
 #define READ_ISRC    (1 << 1)
 #define READ_CDTEXT  (1 << 2)
+#define READ_INDEXES (1 << 3)
 #define READ_ALL     (READ_MCN | READ_ISRC | READ_CDTEXT)
 
 /*
  * Read disc information from device
- * flags controls what optional data to read (READ_MCN, READ_ISRC, READ_CDTEXT)
+ * flags controls what optional data to read (READ_MCN, READ_ISRC, READ_CDTEXT,
+ * READ_INDEXES)
  * Returns 0 on success, exit code on error
  */
 int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbosity);
@@ -41,18 +43,116 @@ int device_read_mcn(const char *device, char *mcn, int verbosity);
  */
 int device_read_isrc(const char *device, toc_t *toc, int verbosity);
 
+/*
+ * Verify ISRCs against expected values (--expect, see isrc_verify_disc)
+ * expect: file or list, parsed against toc
+ * checks: output, parallel to toc->tracks
+ * Returns 0 when verification ran (verdicts in checks), exit code on error
+ */
+int device_verify_isrc(const char *device, const toc_t *toc, const char *expect,
+                       isrc_check_t *checks, bool fail_fast, int verbosity);
+
+/*
+ * Select the ISRC sampling profile (--isrc-profile, see isrc_set_profile)
+ * Returns 0 on success, EX_USAGE if spec is invalid
+ */
+int device_set_isrc_profile(const char *spec);
+
+/*
+ * Read pregap/index map from device
+ * Returns 0 on success, exit code on error
+ */
+int device_read_indexes(const char *device, const toc_t *toc, index_map_t *map,
+                        int verbosity);
+
+/*
+ * Read audio tracks and compute their checksums
+ * read_offset: drive read offset in samples
+ * Returns 0 on success, exit code on error
+ */
+int device_read_audio(const char *device, const toc_t *toc, int read_offset,
+                      track_crc_t *crcs, int verbosity);
+
 /*
  * Read CD-Text from device
  * Returns 0 on success, exit code on error
  */
 int device_read_cdtext(const char *device, cdtext_t *cdtext, int verbosity);
 
+/* Acquisition phases, timed for --repeat */
+typedef enum {
+    PHASE_TOC,
+    PHASE_MCN,
+    PHASE_ISRC,
+    PHASE_CDTEXT,
+    PHASE_INDEXES,
+    PHASE_AUDIO,
+    PHASE_VERIFY,
+    PHASE_COUNT
+} device_phase_t;
+
+/*
+ * Seconds each phase took in the last acquisition (0 if it did not run)
+ * seconds: output, PHASE_COUNT entries
+ */
+void device_phase_times(double *seconds);
+
+/* One acquisition of the disc (what a run of --repeat repeats) */
+typedef int (*device_acquire_fn)(const char *device, disc_info_t *disc, int flags,
+                                 const options_t *opts);
+
+/*
+ * Acquire the disc opts->repeat times (--repeat), each run from a fresh
+ * session: no cached Q frames, Q skew or slow regions, and with
+ * opts->repeat_reset the drive repositioned or its cache flushed.
+ * disc keeps the first run. Per-track agreement, phase timing and
+ * command latency are reported on stderr unless opts->quiet.
+ * Returns 0, or the first failing run's exit code
+ */
+int device_read_repeated(const char *device, disc_info_t *disc, int flags,
+                         const options_t *opts, device_acquire_fn acquire);
+
+/* What main.c does with a disc once it is read: IDs, lookups, output */
+typedef int (*device_finish_fn)(disc_info_t *disc, const options_t *opts, void *ctx);
+
+/*
+ * Identify every disc in the media changer opts->changer (--changer):
+ * load each full slot into the drive (opts->drive, or the simulator's)
+ * with MOVE MEDIUM, read it with acquire, and return it and load the
+ * next slot on a second thread while finish processes it. finish runs
+ * in slot order with disc->slot set, and stdout is flushed after each
+ * disc. Per-slot and batch timing is logged at -v.
+ * Returns 0, or the first failing slot's exit code; a failed move ends
+ * the batch
+ */
+int device_read_changer(int flags, const options_t *opts, device_acquire_fn acquire,
+                        device_finish_fn finish, void *ctx);
+
+/*
+ * Hold device exclusively and suspend kernel media polling until
+ * device_resume() (see scsi_quiesce); failure is reported at -v only
+ */
+void device_quiesce(const char *device, int verbosity);
+
+/*
+ * Undo device_quiesce()
+ */
+void device_resume(void);
+
+/*
+ * Unlock the tray and eject the disc without waiting for the tray to
+ * finish moving (--eject-when-done); disc images are left alone
+ * Returns 0 on success, EX_IOERR (reported) on error
+ */
+int device_eject(const char *device, int verbosity);
+
 /*
  * List optical drives
- * Prints output to stdout
+ * Prints one tab-separated line per drive to stdout
+ * media: also probe tray/media state and disc profile, in parallel
  * Returns 0 on success, exit code on error
  */
-int device_list_drives(void);
+int device_list_drives(bool media, int verbosity);
 
 /*
  * Get default device path for platform
@@ -66,9 +166,4 @@ const char *device_get_default(void);
  */
 char *device_normalize_path(const char *device);
 
-/*
- * Free CD-Text structure
- */
-void cdtext_free(cdtext_t *cdtext);
-
 #endif /* MBDISCID_DEVICE_H */
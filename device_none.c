@@ -0,0 +1,114 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * device_none.c - Device layer of the calculation-only build
+ *
+ * mbdiscid-calc links this in place of device.c, textfiles.c and the
+ * SCSI backends, so it carries no libdiscid, SCSI or threading code.
+ * Anything that would need a drive or a file fails with EX_UNAVAILABLE.
+ */
+
+#include "device.h"
+#include "textfiles.h"
+#include "util.h"
+
+static int unavailable(void)
+{
+    error("device: mbdiscid-calc only calculates from TOC input (-c)");
+    return EX_UNAVAILABLE;
+}
+
+int device_read_disc(const char *device, disc_info_t *disc, int flags, int verbosity)
+{
+    (void)device;
+    (void)disc;
+    (void)flags;
+    (void)verbosity;
+    return unavailable();
+}
+
+int device_read_audio(const char *device, const toc_t *toc, int read_offset,
+                      track_crc_t *crcs, int verbosity)
+{
+    (void)device;
+    (void)toc;
+    (void)read_offset;
+    (void)crcs;
+    (void)verbosity;
+    return unavailable();
+}
+
+int device_verify_isrc(const char *device, const toc_t *toc, const char *expect,
+                       isrc_check_t *checks, bool fail_fast, int verbosity)
+{
+    (void)device;
+    (void)toc;
+    (void)expect;
+    (void)checks;
+    (void)fail_fast;
+    (void)verbosity;
+    return unavailable();
+}
+
+int device_read_repeated(const char *device, disc_info_t *disc, int flags,
+                         const options_t *opts, device_acquire_fn acquire)
+{
+    (void)device;
+    (void)disc;
+    (void)flags;
+    (void)opts;
+    (void)acquire;
+    return unavailable();
+}
+
+int device_read_changer(int flags, const options_t *opts, device_acquire_fn acquire,
+                        device_finish_fn finish, void *ctx)
+{
+    (void)flags;
+    (void)opts;
+    (void)acquire;
+    (void)finish;
+    (void)ctx;
+    return unavailable();
+}
+
+int device_set_isrc_profile(const char *spec)
+{
+    (void)spec;
+    return unavailable();
+}
+
+void device_quiesce(const char *device, int verbosity)
+{
+    (void)device;
+    (void)verbosity;
+}
+
+void device_resume(void)
+{
+}
+
+int device_eject(const char *device, int verbosity)
+{
+    (void)device;
+    (void)verbosity;
+    return unavailable();
+}
+
+int device_list_drives(bool media, int verbosity)
+{
+    (void)media;
+    (void)verbosity;
+    return unavailable();
+}
+
+int textfiles_run(char **files, int file_count, bool quiet, int verbosity)
+{
+    (void)files;
+    (void)file_count;
+    (void)verbosity;
+    if (!quiet)
+        unavailable();
+    return EX_UNAVAILABLE;
+}
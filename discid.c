@@ -11,7 +11,119 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+#ifndef MBDISCID_CALC_ONLY
 #include <discid/discid.h>
+#endif
+
+/* MusicBrainz TOC string: first, last, leadout + 99 track offsets */
+#define MB_TOC_LENGTH (2 + 2 + 100 * 8)
+
+static uint32_t rol32(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+/*
+ * SHA-1 compression of one 64-byte block
+ */
+static void sha1_block(uint32_t h[5], const uint8_t *p)
+{
+    uint32_t w[80];
+
+    for (int i = 0; i < 16; i++)
+        w[i] = ((uint32_t)p[4 * i] << 24) | ((uint32_t)p[4 * i + 1] << 16) |
+               ((uint32_t)p[4 * i + 2] << 8) | p[4 * i + 3];
+    for (int i = 16; i < 80; i++)
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = t;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+/*
+ * SHA-1 digest of a short message
+ */
+static void sha1(const uint8_t *msg, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t tail[128];
+    size_t full = len & ~(size_t)63;
+
+    for (size_t pos = 0; pos < full; pos += 64)
+        sha1_block(h, msg + pos);
+
+    /* Padding: 0x80, zeros, then the bit length big-endian */
+    size_t rest = len - full;
+    size_t tail_len = rest < 56 ? 64 : 128;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, msg + full, rest);
+    tail[rest] = 0x80;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++)
+        tail[tail_len - 1 - i] = (uint8_t)(bits >> (8 * i));
+
+    for (size_t pos = 0; pos < tail_len; pos += 64)
+        sha1_block(h, tail + pos);
+
+    for (int i = 0; i < 5; i++) {
+        digest[4 * i] = (uint8_t)(h[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)h[i];
+    }
+}
+
+/*
+ * MusicBrainz variant of base64: '.', '_' and '-' replace '+', '/' and '='
+ */
+static void mb_base64(const uint8_t digest[20], char *out)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789._";
+    int j = 0;
+
+    for (int i = 0; i < 20; i += 3) {
+        uint32_t v = (uint32_t)digest[i] << 16;
+        if (i + 1 < 20)
+            v |= (uint32_t)digest[i + 1] << 8;
+        if (i + 2 < 20)
+            v |= digest[i + 2];
+
+        out[j++] = alphabet[(v >> 18) & 63];
+        out[j++] = alphabet[(v >> 12) & 63];
+        out[j++] = i + 1 < 20 ? alphabet[(v >> 6) & 63] : '-';
+        out[j++] = i + 2 < 20 ? alphabet[v & 63] : '-';
+    }
+    out[j] = '\0';
+}
 
 /*
  * Calculate sum of decimal digits
@@ -117,7 +229,7 @@ char *calc_accuraterip_id(const toc_t *toc)
 }
 
 /*
- * Calculate MusicBrainz disc ID using libdiscid
+ * Calculate MusicBrainz disc ID
  *
  * Per MusicBrainz documentation (https://musicbrainz.org/doc/Disc_ID_Calculation):
  *
@@ -138,12 +250,8 @@ char *calc_accuraterip_id(const toc_t *toc)
  */
 char *calc_musicbrainz_id(const toc_t *toc)
 {
-    DiscId *disc = discid_new();
-    if (!disc)
-        return NULL;
-
-    /* Build offsets array for libdiscid
-     * libdiscid wants: offsets[0] = leadout, offsets[track_num] = track offset */
+    /* Offsets as libdiscid's discid_put() takes them:
+     * offsets[0] = leadout, offsets[track_num] = track offset */
     int offsets[MAX_TRACKS + 1];
     memset(offsets, 0, sizeof(offsets));
 
@@ -157,7 +265,6 @@ char *calc_musicbrainz_id(const toc_t *toc)
 
     if (first_audio == 0) {
         /* No audio tracks - can't calculate MusicBrainz ID */
-        discid_free(disc);
         return NULL;
     }
 
@@ -184,15 +291,26 @@ char *calc_musicbrainz_id(const toc_t *toc)
         }
     }
 
-    int result = discid_put(disc, first_track, last_track, offsets);
-
-    if (!result) {
-        discid_free(disc);
+    /* Same checks as discid_put() */
+    if (first_track < 1 || last_track > MAX_TRACKS || first_track > last_track)
         return NULL;
+    for (int t = first_track; t <= last_track; t++) {
+        if (offsets[t] <= 0 || offsets[t] > offsets[0])
+            return NULL;
     }
 
-    char *id = xstrdup(discid_get_id(disc));
-    discid_free(disc);
+    /* SHA-1 of the hex TOC string, as libdiscid computes it */
+    char toc_str[MB_TOC_LENGTH + 1];
+    int pos = snprintf(toc_str, sizeof(toc_str), "%02X%02X", first_track, last_track);
+    for (int i = 0; i <= MAX_TRACKS; i++)
+        pos += snprintf(toc_str + pos, sizeof(toc_str) - (size_t)pos, "%08X",
+                        (unsigned)offsets[i]);
+
+    uint8_t digest[20];
+    sha1((const uint8_t *)toc_str, (size_t)pos, digest);
+
+    char *id = xmalloc(MB_ID_LENGTH + 1);
+    mb_base64(digest, id);
 
     return id;
 }
@@ -216,5 +334,9 @@ char *get_musicbrainz_url(const char *disc_id)
  */
 const char *get_libdiscid_version(void)
 {
+#ifdef MBDISCID_CALC_ONLY
+    return "calculation only";
+#else
     return discid_get_version_string();
+#endif
 }
@@ -31,7 +31,7 @@ char *calc_accuraterip_id(const toc_t *toc);
 char *calc_freedb_id(const toc_t *toc);
 
 /*
- * Calculate MusicBrainz Disc ID using libdiscid
+ * Calculate MusicBrainz Disc ID (natively; same result as libdiscid)
  * 28-character base64-like string
  *
  * Returns allocated string or NULL on error, caller must free
@@ -45,7 +45,7 @@ char *calc_musicbrainz_id(const toc_t *toc);
 char *get_musicbrainz_url(const char *disc_id);
 
 /*
- * Get libdiscid version string
+ * Get libdiscid version string ("calculation only" in mbdiscid-calc)
  */
 const char *get_libdiscid_version(void);
 
@@ -0,0 +1,1623 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * image.c - Disc image backend (CUE/BIN, CloneCD, cdrdao TOC)
+ *
+ * Each format is parsed into the same model: a list of tracks with their
+ * index positions, control nibble, session, ISRC and CD-Text strings, plus
+ * the memory-mapped files holding main channel (and, for CloneCD,
+ * subchannel) data. The scsi.h read functions are then answered from that
+ * model. Sector data is never copied; the page cache is shared with any
+ * other reader of the same image.
+ */
+
+#include "image.h"
+#include "subq.h"
+#include "cdtext.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Image limits */
+#define IMAGE_MAX_FILES     MAX_TRACKS
+#define IMAGE_MAX_INDEX     100
+#define IMAGE_MAX_SESSIONS  10
+#define IMAGE_TEXT_FIELDS   6       /* CD-Text pack types 0x80-0x85 */
+
+/* Sector geometry */
+#define SUB_SECTOR_SIZE     96
+#define SUB_Q_OFFSET        12      /* Q follows P in deinterleaved subchannel */
+
+/* CD-Text pack layout */
+#define PACK_SIZE           18
+#define PACK_TEXT_SIZE      12
+
+/* Q frames synthesized per 100: one MCN and one ISRC, like a mastered disc */
+#define SYNTH_MCN_SLOT      25
+#define SYNTH_ISRC_SLOT     75
+
+/* Frames scanned when voting on MCN/ISRC from captured subchannel */
+#define SUB_SCAN_FRAMES     1000
+
+/*
+ * Memory-mapped image file
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t data_start;      /* First sector byte (WAVE data chunk, else 0) */
+    int sector_size;        /* Sector size of the first track stored here */
+} image_file_t;
+
+/*
+ * Track as described by the sheet
+ */
+typedef struct {
+    int number;
+    int session;
+    uint8_t control;
+    int32_t index[IMAGE_MAX_INDEX];     /* LBA of each index, -1 if absent */
+    int last_index;
+    char isrc[ISRC_LENGTH + 1];
+    int file;               /* files[] slot holding main channel, -1 if none */
+    int32_t file_lba;       /* LBA mapped to file_offset */
+    size_t file_offset;     /* Byte offset of the sector at file_lba */
+    int sector_size;
+} image_track_t;
+
+struct image {
+    char *dir;              /* Directory of the sheet, for relative names */
+    image_track_t tracks[MAX_TRACKS];
+    int track_count;
+    int32_t session_leadouts[IMAGE_MAX_SESSIONS];
+    int last_session;
+    char mcn[MCN_LENGTH + 1];
+    char *text[MAX_TRACKS + 1][IMAGE_TEXT_FIELDS];  /* [0] = disc */
+    image_file_t files[IMAGE_MAX_FILES];
+    int file_count;
+    image_file_t sub;       /* CloneCD subchannel, data NULL if absent */
+    uint8_t *cdtext;        /* Raw CD-Text packs, NULL if none */
+    size_t cdtext_len;
+};
+
+/* ============================================================================
+ * File helpers
+ * ============================================================================ */
+
+static bool has_suffix(const char *path, const char *suffix)
+{
+    size_t len = strlen(path);
+    size_t slen = strlen(suffix);
+    return len > slen && strcasecmp(path + len - slen, suffix) == 0;
+}
+
+bool image_is_image_path(const char *path)
+{
+    if (!path)
+        return false;
+    return has_suffix(path, ".cue") || has_suffix(path, ".ccd") ||
+           has_suffix(path, ".toc");
+}
+
+/*
+ * Resolve a file name from a sheet relative to the sheet's directory
+ */
+static char *resolve_path(const image_t *img, const char *name)
+{
+    if (name[0] == '/' || img->dir[0] == '\0')
+        return xstrdup(name);
+
+    size_t len = strlen(img->dir) + strlen(name) + 2;
+    char *path = xmalloc(len);
+    snprintf(path, len, "%s/%s", img->dir, name);
+    return path;
+}
+
+/*
+ * Replace the extension of path (including the dot) with ext
+ */
+static char *replace_ext(const char *path, const char *ext)
+{
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    size_t base = (dot && (!slash || dot > slash)) ? (size_t)(dot - path) : strlen(path);
+
+    char *result = xmalloc(base + strlen(ext) + 1);
+    memcpy(result, path, base);
+    strcpy(result + base, ext);
+    return result;
+}
+
+static bool map_file(const char *path, image_file_t *f)
+{
+    memset(f, 0, sizeof(*f));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+
+    f->size = (size_t)st.st_size;
+    if (f->size > 0) {
+        void *p = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        f->data = p;
+    }
+
+    close(fd);
+    return true;
+}
+
+static void unmap_file(image_file_t *f)
+{
+    if (f->data)
+        munmap((void *)f->data, f->size);
+    memset(f, 0, sizeof(*f));
+}
+
+/*
+ * Point data_start past the RIFF header of a WAVE file
+ */
+static void locate_wave_data(image_file_t *f)
+{
+    if (f->size < 12 || memcmp(f->data, "RIFF", 4) != 0 ||
+        memcmp(f->data + 8, "WAVE", 4) != 0)
+        return;
+
+    size_t pos = 12;
+    while (pos + 8 <= f->size) {
+        const uint8_t *c = f->data + pos;
+        size_t len = (size_t)c[4] | ((size_t)c[5] << 8) |
+                     ((size_t)c[6] << 16) | ((size_t)c[7] << 24);
+        if (memcmp(c, "data", 4) == 0) {
+            f->data_start = pos + 8;
+            return;
+        }
+        pos += 8 + len + (len & 1);
+    }
+}
+
+/*
+ * Number of whole sectors in a mapped file
+ */
+static int32_t file_sectors(const image_file_t *f)
+{
+    if (f->sector_size <= 0 || f->size <= f->data_start)
+        return 0;
+    return (int32_t)((f->size - f->data_start) / (size_t)f->sector_size);
+}
+
+/*
+ * Read a whole text file, NUL-terminated
+ */
+static char *read_text_file(const char *path, size_t *out_len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return NULL;
+
+    size_t cap = 4096, len = 0;
+    char *buf = xmalloc(cap);
+    size_t n;
+    while ((n = fread(buf + len, 1, cap - len - 1, fp)) > 0) {
+        len += n;
+        if (cap - len - 1 == 0) {
+            cap *= 2;
+            buf = xrealloc(buf, cap);
+        }
+    }
+    fclose(fp);
+
+    buf[len] = '\0';
+    if (out_len)
+        *out_len = len;
+    return buf;
+}
+
+/* ============================================================================
+ * Sheet helpers
+ * ============================================================================ */
+
+/*
+ * Parse mm:ss:ff into frames, -1 on error
+ */
+static int32_t parse_msf(const char *s)
+{
+    int m, sec, f;
+    char extra;
+    if (sscanf(s, "%d:%d:%d%c", &m, &sec, &f, &extra) != 3)
+        return -1;
+    if (m < 0 || sec < 0 || sec > 59 || f < 0 || f > 74)
+        return -1;
+    return ((int32_t)m * 60 + sec) * FRAMES_PER_SECOND + f;
+}
+
+/*
+ * Split off the next token of a CUE line; quoted tokens may contain spaces
+ */
+static char *next_token(char **p)
+{
+    char *s = *p;
+    while (*s && isspace((unsigned char)*s))
+        s++;
+    if (!*s) {
+        *p = s;
+        return NULL;
+    }
+
+    char *tok;
+    if (*s == '"') {
+        tok = ++s;
+        while (*s && *s != '"')
+            s++;
+    } else {
+        tok = s;
+        while (*s && !isspace((unsigned char)*s))
+            s++;
+    }
+    if (*s)
+        *s++ = '\0';
+
+    *p = s;
+    return tok;
+}
+
+/*
+ * Split off the next line, stripping CR; returns NULL at end of text
+ */
+static char *next_line(char **p)
+{
+    char *s = *p;
+    if (!*s)
+        return NULL;
+
+    char *eol = strchr(s, '\n');
+    if (eol) {
+        *eol = '\0';
+        *p = eol + 1;
+    } else {
+        *p = s + strlen(s);
+    }
+
+    size_t len = strlen(s);
+    if (len > 0 && s[len - 1] == '\r')
+        s[len - 1] = '\0';
+    return s;
+}
+
+static image_track_t *new_track(image_t *img, int number, int session)
+{
+    if (img->track_count >= MAX_TRACKS)
+        return NULL;
+
+    image_track_t *t = &img->tracks[img->track_count++];
+    memset(t, 0, sizeof(*t));
+    t->number = number;
+    t->session = session;
+    t->file = -1;
+    t->sector_size = RAW_SECTOR_SIZE;
+    t->last_index = 1;
+    for (int i = 0; i < IMAGE_MAX_INDEX; i++)
+        t->index[i] = -1;
+    return t;
+}
+
+static void set_text(image_t *img, int track, int field, const char *value)
+{
+    if (track < 0 || track > MAX_TRACKS || field < 0 || field >= IMAGE_TEXT_FIELDS)
+        return;
+    free(img->text[track][field]);
+    img->text[track][field] = value[0] ? xstrdup(value) : NULL;
+}
+
+/*
+ * Map a CD-Text keyword to its pack type offset (0x80 + n), -1 if unknown
+ */
+static int text_field(const char *keyword)
+{
+    static const char *const names[IMAGE_TEXT_FIELDS] = {
+        "TITLE", "PERFORMER", "SONGWRITER", "COMPOSER", "ARRANGER", "MESSAGE"
+    };
+
+    for (int i = 0; i < IMAGE_TEXT_FIELDS; i++) {
+        if (strcasecmp(keyword, names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Load a binary CD-Text file (.cdt): packs, optionally behind the 4-byte
+ * READ TOC header and followed by a terminating NUL
+ */
+static bool load_cdtext_file(image_t *img, const char *path)
+{
+    image_file_t f;
+    if (!map_file(path, &f))
+        return false;
+
+    size_t start, len;
+    if (cdtext_locate_packs(f.size, &start, &len) && len >= PACK_SIZE) {
+        img->cdtext = xmalloc(len);
+        memcpy(img->cdtext, f.data + start, len);
+        img->cdtext_len = len;
+    }
+
+    unmap_file(&f);
+    return img->cdtext != NULL;
+}
+
+/* ============================================================================
+ * CUE sheet
+ * ============================================================================ */
+
+static bool cue_track_mode(const char *mode, uint8_t *control, int *sector_size)
+{
+    static const struct { const char *name; uint8_t control; int size; } modes[] = {
+        { "AUDIO",      0x00, 2352 },
+        { "CDG",        0x00, 2448 },
+        { "MODE1/2048", 0x04, 2048 },
+        { "MODE1/2352", 0x04, 2352 },
+        { "MODE2/2048", 0x04, 2048 },
+        { "MODE2/2324", 0x04, 2324 },
+        { "MODE2/2336", 0x04, 2336 },
+        { "MODE2/2352", 0x04, 2352 },
+        { "CDI/2336",   0x04, 2336 },
+        { "CDI/2352",   0x04, 2352 },
+    };
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strcasecmp(mode, modes[i].name) == 0) {
+            *control = modes[i].control;
+            *sector_size = modes[i].size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Finish a track once its last index line has been seen
+ */
+static bool cue_finish_track(image_track_t *t, int32_t pregap, const char *path, int line)
+{
+    if (!t)
+        return true;
+
+    if (t->index[1] < 0) {
+        error("image: %s: line %d: track %d has no INDEX 01", path, line, t->number);
+        return false;
+    }
+
+    /* PREGAP frames are not in the file; they precede INDEX 01 as index 0 */
+    if (pregap > 0 && t->index[0] < 0)
+        t->index[0] = t->index[1] - pregap;
+
+    return true;
+}
+
+static bool parse_cue(image_t *img, char *text, const char *path)
+{
+    int file = -1;
+    image_track_t *track = NULL;
+    int session = 1;
+    bool session_pending = false;
+    bool leadout_pending = false;   /* Session ends at the next INDEX */
+    int32_t file_base = 0;      /* Sum of earlier files' sectors */
+    int32_t gap = 0;            /* Frames not backed by any file so far */
+    int32_t pregap = 0;
+    int line_no = 0;
+
+    char *p = text;
+    char *line;
+    while ((line = next_line(&p)) != NULL) {
+        line_no++;
+        char *s = line;
+        char *kw = next_token(&s);
+        if (!kw)
+            continue;
+
+        if (strcasecmp(kw, "FILE") == 0) {
+            char *name = next_token(&s);
+            char *type = next_token(&s);
+            if (!name || !type) {
+                error("image: %s: line %d: malformed FILE", path, line_no);
+                return false;
+            }
+            if (img->file_count >= IMAGE_MAX_FILES) {
+                error("image: %s: line %d: too many files", path, line_no);
+                return false;
+            }
+            if (file >= 0)
+                file_base += file_sectors(&img->files[file]);
+
+            char *fpath = resolve_path(img, name);
+            file = img->file_count;
+            if (!map_file(fpath, &img->files[file])) {
+                error("image: cannot open %s", fpath);
+                free(fpath);
+                return false;
+            }
+            free(fpath);
+            img->file_count++;
+            if (strcasecmp(type, "WAVE") == 0)
+                locate_wave_data(&img->files[file]);
+
+        } else if (strcasecmp(kw, "TRACK") == 0) {
+            char *num = next_token(&s);
+            char *mode = next_token(&s);
+            int n = num ? atoi(num) : 0;
+            uint8_t control;
+            int sector_size;
+
+            if (n < 1 || n > MAX_TRACKS || !mode ||
+                !cue_track_mode(mode, &control, &sector_size)) {
+                error("image: %s: line %d: malformed TRACK", path, line_no);
+                return false;
+            }
+            if (!cue_finish_track(track, pregap, path, line_no))
+                return false;
+            if (track && n <= track->number) {
+                error("image: %s: line %d: tracks out of order", path, line_no);
+                return false;
+            }
+
+            image_track_t *prev = track;
+            track = new_track(img, n, session);
+            if (!track) {
+                error("image: %s: line %d: too many tracks", path, line_no);
+                return false;
+            }
+            track->control = control;
+            track->sector_size = sector_size;
+            track->file = file;
+            if (file >= 0) {
+                image_file_t *f = &img->files[file];
+                if (f->sector_size == 0)
+                    f->sector_size = sector_size;
+                track->file_offset = f->data_start;
+            }
+            track->file_lba = file_base + gap;
+            pregap = 0;
+
+            /* A new session starts after the lead-out and lead-in of the last.
+             * The last ends with the previous track: at the end of its file,
+             * or where this track's first INDEX starts when they share one */
+            if (session_pending) {
+                if (prev->file != file)
+                    img->session_leadouts[session - 2] = track->file_lba;
+                else
+                    leadout_pending = true;
+                gap += SESSION_GAP_FRAMES;
+                track->file_lba += SESSION_GAP_FRAMES;
+                session_pending = false;
+            }
+
+        } else if (strcasecmp(kw, "INDEX") == 0) {
+            char *num = next_token(&s);
+            char *msf = next_token(&s);
+            int n = num ? atoi(num) : -1;
+            int32_t frames = msf ? parse_msf(msf) : -1;
+
+            if (!track || track->file < 0 || n < 0 || n >= IMAGE_MAX_INDEX || frames < 0) {
+                error("image: %s: line %d: malformed INDEX", path, line_no);
+                return false;
+            }
+            track->index[n] = track->file_lba + frames;
+            if (leadout_pending) {
+                img->session_leadouts[session - 2] = track->index[n] - SESSION_GAP_FRAMES;
+                leadout_pending = false;
+            }
+            if (n > track->last_index)
+                track->last_index = n;
+
+        } else if (strcasecmp(kw, "PREGAP") == 0 || strcasecmp(kw, "POSTGAP") == 0) {
+            char *msf = next_token(&s);
+            int32_t frames = msf ? parse_msf(msf) : -1;
+            if (!track || frames < 0) {
+                error("image: %s: line %d: malformed %s", path, line_no, kw);
+                return false;
+            }
+            gap += frames;
+            if (strcasecmp(kw, "PREGAP") == 0) {
+                track->file_lba += frames;
+                pregap = frames;
+            }
+
+        } else if (strcasecmp(kw, "FLAGS") == 0) {
+            char *flag;
+            while (track && (flag = next_token(&s)) != NULL) {
+                if (strcasecmp(flag, "DCP") == 0)
+                    track->control |= 0x02;
+                else if (strcasecmp(flag, "4CH") == 0)
+                    track->control |= 0x08;
+                else if (strcasecmp(flag, "PRE") == 0)
+                    track->control |= 0x01;
+            }
+
+        } else if (strcasecmp(kw, "ISRC") == 0) {
+            char *isrc = next_token(&s);
+            if (track && isrc && strlen(isrc) == ISRC_LENGTH && is_valid_isrc(isrc))
+                strcpy(track->isrc, isrc);
+
+        } else if (strcasecmp(kw, "CATALOG") == 0) {
+            char *mcn = next_token(&s);
+            if (mcn && strlen(mcn) == MCN_LENGTH && is_valid_mcn(mcn))
+                strcpy(img->mcn, mcn);
+
+        } else if (strcasecmp(kw, "CDTEXTFILE") == 0) {
+            char *name = next_token(&s);
+            if (name) {
+                char *fpath = resolve_path(img, name);
+                load_cdtext_file(img, fpath);
+                free(fpath);
+            }
+
+        } else if (strcasecmp(kw, "REM") == 0) {
+            char *what = next_token(&s);
+            char *value = next_token(&s);
+            if (what && value && strcasecmp(what, "SESSION") == 0) {
+                int n = atoi(value);
+                if (n > session && n <= IMAGE_MAX_SESSIONS) {
+                    session = n;
+                    session_pending = img->track_count > 0;
+                }
+            }
+
+        } else {
+            int field = text_field(kw);
+            char *value = next_token(&s);
+            if (field >= 0 && value)
+                set_text(img, track ? track->number : 0, field, value);
+        }
+    }
+
+    if (!cue_finish_track(track, pregap, path, line_no))
+        return false;
+    if (img->track_count == 0) {
+        error("image: %s: no tracks", path);
+        return false;
+    }
+
+    if (file >= 0)
+        file_base += file_sectors(&img->files[file]);
+    img->last_session = session;
+    img->session_leadouts[session - 1] = file_base + gap;
+    return true;
+}
+
+/* ============================================================================
+ * CloneCD control file
+ * ============================================================================ */
+
+/*
+ * Raw Full TOC entry from an [Entry N] section
+ */
+typedef struct {
+    int session;
+    int point;
+    int control;
+    int pmin, psec, pframe;
+} ccd_entry_t;
+
+static void ccd_apply_entry(image_t *img, const ccd_entry_t *e)
+{
+    int32_t lba = ((int32_t)e->pmin * 60 + e->psec) * FRAMES_PER_SECOND + e->pframe - PREGAP_FRAMES;
+    int session = e->session >= 1 && e->session <= IMAGE_MAX_SESSIONS ? e->session : 1;
+
+    if (session > img->last_session)
+        img->last_session = session;
+
+    if (e->point >= 1 && e->point <= MAX_TRACKS) {
+        image_track_t *t = new_track(img, e->point, session);
+        if (!t)
+            return;
+        t->control = (uint8_t)(e->control & 0x0F);
+        t->index[1] = lba;
+        t->file = img->file_count > 0 ? 0 : -1;
+        t->file_lba = 0;
+    } else if (e->point == 0xA2) {
+        img->session_leadouts[session - 1] = lba;
+    }
+}
+
+static image_track_t *find_track(image_t *img, int number)
+{
+    for (int i = 0; i < img->track_count; i++) {
+        if (img->tracks[i].number == number)
+            return &img->tracks[i];
+    }
+    return NULL;
+}
+
+static int compare_tracks(const void *a, const void *b)
+{
+    return ((const image_track_t *)a)->number - ((const image_track_t *)b)->number;
+}
+
+/*
+ * Append one [CDText] entry; CloneCD stores packs without their CRC
+ */
+static void ccd_add_cdtext(image_t *img, const char *hex)
+{
+    uint8_t pack[PACK_SIZE];
+    int n = 0;
+    const char *s = hex;
+    char *end;
+
+    while (n < PACK_SIZE) {
+        unsigned long v = strtoul(s, &end, 16);
+        if (end == s || v > 0xFF)
+            break;
+        pack[n++] = (uint8_t)v;
+        s = end;
+    }
+    if (n != 16 && n != PACK_SIZE)
+        return;
+    if (n == 16) {
+        uint16_t crc = (uint16_t)~subq_crc16(pack, 16);
+        pack[16] = (crc >> 8) & 0xFF;
+        pack[17] = crc & 0xFF;
+    }
+
+    img->cdtext = xrealloc(img->cdtext, img->cdtext_len + PACK_SIZE);
+    memcpy(img->cdtext + img->cdtext_len, pack, PACK_SIZE);
+    img->cdtext_len += PACK_SIZE;
+}
+
+static bool parse_ccd(image_t *img, char *text, const char *path)
+{
+    /* Main channel and subchannel are siblings of the control file */
+    char *img_path = replace_ext(path, ".img");
+    if (map_file(img_path, &img->files[0])) {
+        img->files[0].sector_size = RAW_SECTOR_SIZE;
+        img->file_count = 1;
+    }
+    free(img_path);
+
+    char *sub_path = replace_ext(path, ".sub");
+    map_file(sub_path, &img->sub);
+    free(sub_path);
+
+    enum { SEC_OTHER, SEC_DISC, SEC_CDTEXT, SEC_TRACK } section = SEC_OTHER;
+    ccd_entry_t entry = {0};
+    bool have_entry = false;
+    int track_no = 0;
+    img->last_session = 1;
+
+    /* Track sections refer to tracks created from entries, so collect those first */
+    char *copy = xstrdup(text);
+    char *p = copy;
+    char *line;
+    while ((line = next_line(&p)) != NULL) {
+        char *s = trim(line);
+        if (s[0] == '[') {
+            if (have_entry)
+                ccd_apply_entry(img, &entry);
+            have_entry = strncasecmp(s, "[Entry", 6) == 0;
+            if (have_entry) {
+                memset(&entry, 0, sizeof(entry));
+                entry.session = 1;
+            }
+            continue;
+        }
+        char *eq = strchr(s, '=');
+        if (!have_entry || !eq)
+            continue;
+        *eq = '\0';
+        char *key = trim(s);
+        long v = strtol(eq + 1, NULL, 0);
+        if (strcasecmp(key, "Session") == 0) entry.session = (int)v;
+        else if (strcasecmp(key, "Point") == 0) entry.point = (int)v;
+        else if (strcasecmp(key, "Control") == 0) entry.control = (int)v;
+        else if (strcasecmp(key, "PMin") == 0) entry.pmin = (int)v;
+        else if (strcasecmp(key, "PSec") == 0) entry.psec = (int)v;
+        else if (strcasecmp(key, "PFrame") == 0) entry.pframe = (int)v;
+    }
+    if (have_entry)
+        ccd_apply_entry(img, &entry);
+    free(copy);
+
+    if (img->track_count == 0) {
+        error("image: %s: no tracks", path);
+        return false;
+    }
+    qsort(img->tracks, (size_t)img->track_count, sizeof(img->tracks[0]), compare_tracks);
+
+    p = text;
+    while ((line = next_line(&p)) != NULL) {
+        char *s = trim(line);
+        if (s[0] == '[') {
+            if (strcasecmp(s, "[Disc]") == 0) {
+                section = SEC_DISC;
+            } else if (strcasecmp(s, "[CDText]") == 0) {
+                section = SEC_CDTEXT;
+            } else if (strncasecmp(s, "[TRACK", 6) == 0) {
+                section = SEC_TRACK;
+                track_no = atoi(s + 6);
+            } else {
+                section = SEC_OTHER;
+            }
+            continue;
+        }
+
+        char *eq = strchr(s, '=');
+        if (!eq)
+            continue;
+        *eq = '\0';
+        char *key = trim(s);
+        char *value = trim(eq + 1);
+
+        if (section == SEC_DISC && strcasecmp(key, "CATALOG") == 0) {
+            if (strlen(value) == MCN_LENGTH && is_valid_mcn(value))
+                strcpy(img->mcn, value);
+        } else if (section == SEC_CDTEXT && strncasecmp(key, "Entry", 5) == 0) {
+            ccd_add_cdtext(img, value);
+        } else if (section == SEC_TRACK) {
+            image_track_t *t = find_track(img, track_no);
+            if (!t)
+                continue;
+            if (strncasecmp(key, "INDEX", 5) == 0) {
+                int n = atoi(key + 5);
+                if (n >= 0 && n < IMAGE_MAX_INDEX) {
+                    t->index[n] = (int32_t)strtol(value, NULL, 10);
+                    if (n > t->last_index)
+                        t->last_index = n;
+                }
+            } else if (strcasecmp(key, "ISRC") == 0) {
+                if (strlen(value) == ISRC_LENGTH && is_valid_isrc(value))
+                    strcpy(t->isrc, value);
+            }
+        }
+    }
+
+    return true;
+}
+
+/* ============================================================================
+ * cdrdao TOC file
+ * ============================================================================ */
+
+typedef struct {
+    const char *p;
+    int line;
+    bool quoted;
+    char tok[1024];
+} toc_lexer_t;
+
+/*
+ * Read the next token: a quoted string (escapes decoded), a brace, or a
+ * word. Comments (// to end of line) are skipped.
+ */
+static bool toc_next(toc_lexer_t *lx)
+{
+    const char *s = lx->p;
+
+    for (;;) {
+        while (*s && isspace((unsigned char)*s)) {
+            if (*s == '\n')
+                lx->line++;
+            s++;
+        }
+        if (s[0] == '/' && s[1] == '/') {
+            while (*s && *s != '\n')
+                s++;
+            continue;
+        }
+        break;
+    }
+
+    size_t n = 0;
+    lx->quoted = false;
+
+    if (!*s) {
+        lx->p = s;
+        lx->tok[0] = '\0';
+        return false;
+    }
+
+    if (*s == '{' || *s == '}' || *s == ':') {
+        lx->tok[n++] = *s++;
+    } else if (*s == '"') {
+        lx->quoted = true;
+        s++;
+        while (*s && *s != '"') {
+            char c = *s++;
+            if (c == '\\' && *s) {
+                if (*s >= '0' && *s <= '7') {
+                    int v = 0;
+                    for (int i = 0; i < 3 && *s >= '0' && *s <= '7'; i++)
+                        v = v * 8 + (*s++ - '0');
+                    c = (char)v;
+                } else {
+                    c = *s++;
+                }
+            }
+            if (n < sizeof(lx->tok) - 1)
+                lx->tok[n++] = c;
+        }
+        if (*s == '"')
+            s++;
+    } else {
+        while (*s && !isspace((unsigned char)*s) && *s != '{' && *s != '}' &&
+               *s != '"' && *s != ':') {
+            if (n < sizeof(lx->tok) - 1)
+                lx->tok[n++] = *s;
+            s++;
+        }
+        /* Keep m:s:f times together */
+        while (*s == ':' && isdigit((unsigned char)s[1]) && n > 0 &&
+               isdigit((unsigned char)lx->tok[n - 1])) {
+            do {
+                if (n < sizeof(lx->tok) - 1)
+                    lx->tok[n++] = *s;
+                s++;
+            } while (isdigit((unsigned char)*s));
+        }
+    }
+
+    lx->tok[n] = '\0';
+    lx->p = s;
+    return true;
+}
+
+static bool toc_is(const toc_lexer_t *lx, const char *word)
+{
+    return !lx->quoted && strcmp(lx->tok, word) == 0;
+}
+
+/*
+ * Check whether the next token is a length (msf or sample count) without consuming it
+ */
+static bool toc_peek_length(toc_lexer_t *lx)
+{
+    toc_lexer_t save = *lx;
+    bool is_length = toc_next(lx) && !lx->quoted && isdigit((unsigned char)lx->tok[0]);
+    lx->p = save.p;
+    lx->line = save.line;
+    strcpy(lx->tok, save.tok);
+    lx->quoted = save.quoted;
+    return is_length;
+}
+
+/*
+ * Convert the current token to frames: m:s:f, or a plain number of
+ * samples (audio) or bytes (data, with unit = sector size)
+ */
+static int32_t toc_length(const toc_lexer_t *lx, int unit)
+{
+    if (strchr(lx->tok, ':'))
+        return parse_msf(lx->tok);
+    if (!is_all_digits(lx->tok))
+        return -1;
+    return (int32_t)(strtoll(lx->tok, NULL, 10) / unit);
+}
+
+/*
+ * Skip the rest of a { ... } group whose opening brace was consumed
+ */
+static void toc_skip_group(toc_lexer_t *lx)
+{
+    int depth = 1;
+    while (depth > 0 && toc_next(lx)) {
+        if (toc_is(lx, "{"))
+            depth++;
+        else if (toc_is(lx, "}"))
+            depth--;
+    }
+}
+
+/*
+ * Parse CD_TEXT { LANGUAGE_MAP { ... } LANGUAGE n { KEY "value" ... } }
+ * Only language 0 is kept
+ */
+static bool toc_parse_cdtext(toc_lexer_t *lx, image_t *img, int track)
+{
+    if (!toc_next(lx) || !toc_is(lx, "{"))
+        return false;
+
+    while (toc_next(lx) && !toc_is(lx, "}")) {
+        if (toc_is(lx, "LANGUAGE_MAP")) {
+            if (!toc_next(lx) || !toc_is(lx, "{"))
+                return false;
+            toc_skip_group(lx);
+        } else if (toc_is(lx, "LANGUAGE")) {
+            if (!toc_next(lx))
+                return false;
+            int language = atoi(lx->tok);
+            if (!toc_next(lx) || !toc_is(lx, "{"))
+                return false;
+
+            while (toc_next(lx) && !toc_is(lx, "}")) {
+                int field = text_field(lx->tok);
+                if (!toc_next(lx))
+                    return false;
+                if (toc_is(lx, "{")) {
+                    toc_skip_group(lx);     /* Binary item */
+                } else if (field >= 0 && language == 0 && lx->quoted) {
+                    set_text(img, track, field, lx->tok);
+                }
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool toc_track_mode(const char *mode, uint8_t *control, int *sector_size)
+{
+    static const struct { const char *name; uint8_t control; int size; } modes[] = {
+        { "AUDIO",          0x00, 2352 },
+        { "MODE0",          0x04, 2336 },
+        { "MODE1",          0x04, 2048 },
+        { "MODE1_RAW",      0x04, 2352 },
+        { "MODE2",          0x04, 2336 },
+        { "MODE2_FORM1",    0x04, 2048 },
+        { "MODE2_FORM2",    0x04, 2324 },
+        { "MODE2_FORM_MIX", 0x04, 2336 },
+        { "MODE2_RAW",      0x04, 2352 },
+    };
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strcmp(mode, modes[i].name) == 0) {
+            *control = modes[i].control;
+            *sector_size = modes[i].size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Map (or reuse) a file named by a TOC track item
+ */
+static int toc_open_file(image_t *img, const char *name)
+{
+    if (img->file_count >= IMAGE_MAX_FILES)
+        return -1;
+
+    char *fpath = resolve_path(img, name);
+    int slot = img->file_count;
+    if (!map_file(fpath, &img->files[slot])) {
+        error("image: cannot open %s", fpath);
+        free(fpath);
+        return -1;
+    }
+    free(fpath);
+
+    if (has_suffix(name, ".wav"))
+        locate_wave_data(&img->files[slot]);
+    img->file_count++;
+    return slot;
+}
+
+static bool parse_toc(image_t *img, char *text, const char *path)
+{
+    toc_lexer_t lx = { .p = text, .line = 1 };
+    image_track_t *track = NULL;
+    int32_t track_start = 0;    /* LBA of the track's first frame */
+    int32_t track_len = 0;      /* Frames in the track so far */
+    int32_t start = 0;          /* Offset of index 1 within the track */
+    int32_t pos = 0;            /* LBA where the next track begins */
+    bool copy = false, pre = false, four = false;
+
+#define TOC_FAIL(what) do { \
+        error("image: %s: line %d: %s", path, lx.line, what); \
+        return false; \
+    } while (0)
+
+    while (toc_next(&lx)) {
+        if (toc_is(&lx, "CATALOG")) {
+            if (!toc_next(&lx))
+                TOC_FAIL("malformed CATALOG");
+            if (strlen(lx.tok) == MCN_LENGTH && is_valid_mcn(lx.tok))
+                strcpy(img->mcn, lx.tok);
+
+        } else if (toc_is(&lx, "CD_DA") || toc_is(&lx, "CD_ROM") ||
+                   toc_is(&lx, "CD_ROM_XA") || toc_is(&lx, "CD_I")) {
+            continue;
+
+        } else if (toc_is(&lx, "CD_TEXT")) {
+            if (!toc_parse_cdtext(&lx, img, track ? track->number : 0))
+                TOC_FAIL("malformed CD_TEXT");
+
+        } else if (toc_is(&lx, "TRACK")) {
+            uint8_t control;
+            int sector_size;
+            if (!toc_next(&lx) || !toc_track_mode(lx.tok, &control, &sector_size))
+                TOC_FAIL("malformed TRACK");
+
+            if (track) {
+                track->index[1] = track_start + start;
+                pos = track_start + track_len;
+            }
+            track = new_track(img, img->track_count + 1, 1);
+            if (!track)
+                TOC_FAIL("too many tracks");
+            track->control = control;
+            track->sector_size = sector_size;
+            track_start = pos;
+            track_len = 0;
+            start = 0;
+            copy = pre = four = false;
+
+            /* Optional subchannel mode */
+            toc_lexer_t save = lx;
+            if (toc_next(&lx) && (toc_is(&lx, "RW") || toc_is(&lx, "RW_RAW")))
+                track->sector_size += SUB_SECTOR_SIZE;
+            else
+                lx = save;
+
+        } else if (!track) {
+            TOC_FAIL("expected TRACK");
+
+        } else if (toc_is(&lx, "NO")) {
+            if (!toc_next(&lx))
+                TOC_FAIL("malformed NO");
+            if (toc_is(&lx, "COPY")) copy = false;
+            else if (toc_is(&lx, "PRE_EMPHASIS")) pre = false;
+
+        } else if (toc_is(&lx, "COPY")) {
+            copy = true;
+        } else if (toc_is(&lx, "PRE_EMPHASIS")) {
+            pre = true;
+        } else if (toc_is(&lx, "FOUR_CHANNEL_AUDIO")) {
+            four = true;
+        } else if (toc_is(&lx, "TWO_CHANNEL_AUDIO")) {
+            four = false;
+
+        } else if (toc_is(&lx, "ISRC")) {
+            if (!toc_next(&lx))
+                TOC_FAIL("malformed ISRC");
+            if (strlen(lx.tok) == ISRC_LENGTH && is_valid_isrc(lx.tok))
+                strcpy(track->isrc, lx.tok);
+
+        } else if (toc_is(&lx, "SILENCE") || toc_is(&lx, "PREGAP")) {
+            bool is_pregap = toc_is(&lx, "PREGAP");
+            int32_t frames = toc_next(&lx) ? toc_length(&lx, SAMPLES_PER_FRAME) : -1;
+            if (frames < 0)
+                TOC_FAIL("malformed length");
+            track_len += frames;
+            if (is_pregap)
+                start = track_len;
+
+        } else if (toc_is(&lx, "ZERO")) {
+            if (!toc_next(&lx))
+                TOC_FAIL("malformed ZERO");
+            uint8_t c;
+            int size;
+            if (toc_track_mode(lx.tok, &c, &size) && !toc_next(&lx))
+                TOC_FAIL("malformed ZERO");
+            int32_t frames = toc_length(&lx, SAMPLES_PER_FRAME);
+            if (frames < 0)
+                TOC_FAIL("malformed length");
+            track_len += frames;
+
+        } else if (toc_is(&lx, "FILE") || toc_is(&lx, "AUDIOFILE") ||
+                   toc_is(&lx, "DATAFILE")) {
+            bool data = toc_is(&lx, "DATAFILE");
+            if (!toc_next(&lx) || !lx.quoted)
+                TOC_FAIL("malformed file item");
+            int slot = toc_open_file(img, lx.tok);
+            if (slot < 0)
+                return false;
+            image_file_t *f = &img->files[slot];
+            if (f->sector_size == 0)
+                f->sector_size = track->sector_size;
+
+            size_t offset = f->data_start;
+            int32_t file_start = 0;
+            int32_t length = -1;
+            int unit = data ? track->sector_size : SAMPLES_PER_FRAME;
+
+            toc_lexer_t save = lx;
+            if (toc_next(&lx) && lx.tok[0] == '#' && !lx.quoted) {
+                offset += (size_t)strtoull(lx.tok + 1, NULL, 10);
+            } else {
+                lx = save;
+            }
+            if (!data && toc_peek_length(&lx)) {
+                toc_next(&lx);
+                file_start = toc_length(&lx, unit);
+            }
+            if (toc_peek_length(&lx)) {
+                toc_next(&lx);
+                length = toc_length(&lx, unit);
+            }
+            if (file_start < 0)
+                TOC_FAIL("malformed file item");
+            if (length < 0) {
+                size_t avail = f->size > offset ? f->size - offset : 0;
+                length = (int32_t)(avail / (size_t)track->sector_size) - file_start;
+                if (length < 0)
+                    length = 0;
+            }
+
+            if (track->file < 0) {
+                track->file = slot;
+                track->file_offset = offset;
+                track->file_lba = track_start + track_len - file_start;
+            }
+            track_len += length;
+
+        } else if (toc_is(&lx, "START")) {
+            start = track_len;
+            if (toc_peek_length(&lx)) {
+                toc_next(&lx);
+                start = toc_length(&lx, SAMPLES_PER_FRAME);
+                if (start < 0)
+                    TOC_FAIL("malformed START");
+            }
+
+        } else if (toc_is(&lx, "INDEX")) {
+            int32_t frames = toc_next(&lx) ? toc_length(&lx, SAMPLES_PER_FRAME) : -1;
+            if (frames < 0 || track->last_index + 1 >= IMAGE_MAX_INDEX)
+                TOC_FAIL("malformed INDEX");
+            track->last_index++;
+            track->index[track->last_index] = track_start + start + frames;
+
+        } else {
+            TOC_FAIL("unsupported statement");
+        }
+
+        if (track) {
+            track->control = (uint8_t)((track->control & 0x04) |
+                                       (copy ? 0x02 : 0) | (pre ? 0x01 : 0) |
+                                       (four ? 0x08 : 0));
+            if (start > 0)
+                track->index[0] = track_start;
+        }
+    }
+
+#undef TOC_FAIL
+
+    if (!track) {
+        error("image: %s: no tracks", path);
+        return false;
+    }
+
+    track->index[1] = track_start + start;
+    img->last_session = 1;
+    img->session_leadouts[0] = track_start + track_len;
+    return true;
+}
+
+/* ============================================================================
+ * CD-Text synthesis
+ * ============================================================================ */
+
+static void put_pack(uint8_t **buf, size_t *len, uint8_t type, uint8_t track,
+                     uint8_t seq, uint8_t pos, const uint8_t *text)
+{
+    *buf = xrealloc(*buf, *len + PACK_SIZE);
+    uint8_t *pack = *buf + *len;
+
+    pack[0] = type;
+    pack[1] = track;
+    pack[2] = seq;
+    pack[3] = pos;
+    memcpy(pack + 4, text, PACK_TEXT_SIZE);
+
+    uint16_t crc = (uint16_t)~subq_crc16(pack, 16);
+    pack[16] = (crc >> 8) & 0xFF;
+    pack[17] = crc & 0xFF;
+    *len += PACK_SIZE;
+}
+
+/*
+ * Check whether a string is well-formed UTF-8
+ */
+static bool is_utf8(const uint8_t *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        int extra = s[i] < 0x80 ? 0 : (s[i] & 0xE0) == 0xC0 ? 1 :
+                    (s[i] & 0xF0) == 0xE0 ? 2 : (s[i] & 0xF8) == 0xF0 ? 3 : -1;
+        if (extra < 0 || i + (size_t)extra >= len)
+            return false;
+        for (int k = 1; k <= extra; k++) {
+            if ((s[i + k] & 0xC0) != 0x80)
+                return false;
+        }
+        i += (size_t)extra;
+    }
+    return true;
+}
+
+/*
+ * Append a sheet string as ISO-8859-1, NUL-terminated. Valid UTF-8 is
+ * transcoded (code points above U+00FF become '?'); anything else is
+ * assumed to be Latin-1 already, which is what most rippers write.
+ */
+static void append_latin1(uint8_t **buf, size_t *len, size_t *cap, const char *s)
+{
+    const uint8_t *u = (const uint8_t *)s;
+    size_t slen = strlen(s);
+    bool utf8 = is_utf8(u, slen);
+
+    if (*len + slen + 1 > *cap) {
+        *cap = (*len + slen + 1) * 2;
+        *buf = xrealloc(*buf, *cap);
+    }
+
+    for (size_t i = 0; i < slen; i++) {
+        if (!utf8 || u[i] < 0x80) {
+            (*buf)[(*len)++] = u[i];
+        } else if ((u[i] & 0xE0) == 0xC0) {
+            uint32_t cp = ((uint32_t)(u[i] & 0x1F) << 6) | (u[i + 1] & 0x3F);
+            (*buf)[(*len)++] = cp <= 0xFF ? (uint8_t)cp : '?';
+            i += 1;
+        } else {
+            (*buf)[(*len)++] = '?';
+            i += (u[i] & 0xF0) == 0xE0 ? 2 : 3;
+        }
+    }
+    (*buf)[(*len)++] = '\0';
+}
+
+/*
+ * Build block 0 CD-Text packs (ISO-8859-1) from sheet strings
+ */
+static void build_cdtext(image_t *img)
+{
+    int first = img->tracks[0].number;
+    int last = img->tracks[img->track_count - 1].number;
+    uint8_t counts[16] = {0};
+    uint8_t seq = 0;
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+
+    for (int field = 0; field < IMAGE_TEXT_FIELDS; field++) {
+        bool any = false;
+        for (int t = 0; t <= last; t++)
+            any = any || img->text[t][field];
+        if (!any)
+            continue;
+
+        /* Concatenate disc string and track strings, remembering where each starts */
+        uint8_t *text = NULL;
+        size_t len = 0, cap = 0;
+        size_t starts[MAX_TRACKS + 2];
+        int owners[MAX_TRACKS + 2];
+        int n = 0;
+        for (int t = 0; t <= last; t++) {
+            if (t != 0 && t < first)
+                continue;
+            starts[n] = len;
+            owners[n++] = t;
+            append_latin1(&text, &len, &cap, img->text[t][field] ? img->text[t][field] : "");
+        }
+        starts[n] = len;
+
+        int owner = 0;
+        for (size_t pos = 0; pos < len && seq < 0xFF; pos += PACK_TEXT_SIZE) {
+            while (owner + 1 < n && starts[owner + 1] <= pos)
+                owner++;
+            size_t offset = pos - starts[owner];
+            uint8_t chunk[PACK_TEXT_SIZE] = {0};
+            size_t take = len - pos < PACK_TEXT_SIZE ? len - pos : PACK_TEXT_SIZE;
+            memcpy(chunk, text + pos, take);
+
+            put_pack(&out, &out_len, (uint8_t)(0x80 + field), (uint8_t)owners[owner],
+                     seq++, (uint8_t)(offset > 15 ? 15 : offset), chunk);
+            counts[field]++;
+        }
+        free(text);
+    }
+
+    if (!out)
+        return;
+
+    /* Size information: three 0x8F packs describing block 0 */
+    counts[15] = 3;
+    uint8_t last_seq = (uint8_t)(seq + 2);
+    uint8_t info[3][PACK_TEXT_SIZE] = {{0}};
+    info[0][0] = 0x00;      /* ISO-8859-1 */
+    info[0][1] = (uint8_t)first;
+    info[0][2] = (uint8_t)last;
+    memcpy(&info[0][4], counts, 8);
+    memcpy(&info[1][0], counts + 8, 8);
+    info[1][8] = last_seq;
+    info[2][4] = 0x09;      /* English */
+    for (int i = 0; i < 3; i++)
+        put_pack(&out, &out_len, 0x8F, (uint8_t)i, seq++, 0, info[i]);
+
+    img->cdtext = out;
+    img->cdtext_len = out_len;
+}
+
+/* ============================================================================
+ * Public interface
+ * ============================================================================ */
+
+image_t *image_open(const char *path)
+{
+    size_t len;
+    char *text = read_text_file(path, &len);
+    if (!text) {
+        error("image: cannot open %s", path);
+        return NULL;
+    }
+
+    image_t *img = xcalloc(1, sizeof(*img));
+    const char *slash = strrchr(path, '/');
+    img->dir = xstrdup(path);
+    img->dir[slash ? (size_t)(slash - path) : 0] = '\0';
+
+    bool ok;
+    if (has_suffix(path, ".ccd"))
+        ok = parse_ccd(img, text, path);
+    else if (has_suffix(path, ".toc"))
+        ok = parse_toc(img, text, path);
+    else
+        ok = parse_cue(img, text, path);
+    free(text);
+
+    if (!ok) {
+        image_close(img);
+        return NULL;
+    }
+
+    if (!img->cdtext)
+        build_cdtext(img);
+
+    return img;
+}
+
+void image_close(image_t *img)
+{
+    if (!img)
+        return;
+
+    for (int i = 0; i < img->file_count; i++)
+        unmap_file(&img->files[i]);
+    unmap_file(&img->sub);
+
+    for (int t = 0; t <= MAX_TRACKS; t++) {
+        for (int f = 0; f < IMAGE_TEXT_FIELDS; f++)
+            free(img->text[t][f]);
+    }
+
+    free(img->cdtext);
+    free(img->dir);
+    free(img);
+}
+
+bool image_read_full_toc(image_t *img, int *first_track, int *last_track,
+                         uint8_t *control, uint8_t *session, int32_t *offsets,
+                         int32_t *session_leadouts, int *last_session)
+{
+    memset(control, 0, 100);
+    memset(session, 0, 100);
+    memset(offsets, 0, 100 * sizeof(int32_t));
+    memset(session_leadouts, 0, IMAGE_MAX_SESSIONS * sizeof(int32_t));
+
+    for (int i = 0; i < img->track_count; i++) {
+        const image_track_t *t = &img->tracks[i];
+        control[t->number] = t->control;
+        session[t->number] = (uint8_t)t->session;
+        offsets[t->number] = t->index[1];
+    }
+    memcpy(session_leadouts, img->session_leadouts, sizeof(img->session_leadouts));
+
+    *first_track = img->tracks[0].number;
+    *last_track = img->tracks[img->track_count - 1].number;
+    *last_session = img->last_session;
+    return true;
+}
+
+bool image_read_toc_control(image_t *img, int *first_track, int *last_track,
+                            uint8_t *control)
+{
+    memset(control, 0, 100);
+    for (int i = 0; i < img->track_count; i++)
+        control[img->tracks[i].number] = img->tracks[i].control;
+
+    *first_track = img->tracks[0].number;
+    *last_track = img->tracks[img->track_count - 1].number;
+    return true;
+}
+
+/*
+ * First frame of a track: index 0 if present, else index 1
+ */
+static int32_t track_begin(const image_track_t *t)
+{
+    return t->index[0] >= 0 ? t->index[0] : t->index[1];
+}
+
+/*
+ * Synthesize the Q frame a drive would return at lba
+ */
+static bool synth_q_frame(const image_t *img, int32_t lba, uint8_t *raw)
+{
+    if (lba < -PREGAP_FRAMES)
+        return false;
+
+    const image_track_t *t = &img->tracks[0];
+    for (int i = 1; i < img->track_count; i++) {
+        if (track_begin(&img->tracks[i]) > lba)
+            break;
+        t = &img->tracks[i];
+    }
+
+    /* Nothing between a session's lead-out and the next session */
+    if (t->session >= 1 && t->session <= IMAGE_MAX_SESSIONS &&
+        lba >= img->session_leadouts[t->session - 1])
+        return false;
+
+    int index = 0;
+    for (int k = t->last_index; k >= 0; k--) {
+        if (t->index[k] >= 0 && t->index[k] <= lba) {
+            index = k;
+            break;
+        }
+    }
+
+    int slot = ((lba % 100) + 100) % 100;
+    if (img->mcn[0] && slot == SYNTH_MCN_SLOT)
+        subq_encode_mcn(raw, t->control, img->mcn, lba);
+    else if (t->isrc[0] && index >= 1 && slot == SYNTH_ISRC_SLOT)
+        subq_encode_isrc(raw, t->control, t->isrc, lba);
+    else
+        subq_encode_position(raw, t->control, t->number, index, lba - t->index[1], lba);
+
+    return true;
+}
+
+static bool read_q_frame(const image_t *img, int32_t lba, q_subchannel_t *q)
+{
+    if (img->sub.data) {
+        if (lba < 0 || (size_t)(lba + 1) * SUB_SECTOR_SIZE > img->sub.size)
+            return false;
+        subq_decode_raw(img->sub.data + (size_t)lba * SUB_SECTOR_SIZE + SUB_Q_OFFSET, q);
+        return true;
+    }
+
+    uint8_t raw[SUBQ_RAW_SIZE];
+    if (!synth_q_frame(img, lba, raw))
+        return false;
+    subq_decode_raw(raw, q);
+    return true;
+}
+
+int image_read_q_batch(image_t *img, int32_t lba, int count, q_subchannel_t *q)
+{
+    int n = 0;
+    while (n < count && read_q_frame(img, lba + n, &q[n]))
+        n++;
+    return n;
+}
+
+/*
+ * Copy one sector of a track's main channel, if its file holds it as
+ * raw 2352-byte audio
+ */
+static bool copy_track_sector(const image_t *img, const image_track_t *t,
+                              int32_t lba, uint8_t *out)
+{
+    if (t->file < 0 || t->sector_size != RAW_SECTOR_SIZE || lba < t->file_lba)
+        return false;
+
+    const image_file_t *f = &img->files[t->file];
+    size_t pos = t->file_offset + (size_t)(lba - t->file_lba) * RAW_SECTOR_SIZE;
+    if (pos + RAW_SECTOR_SIZE > f->size)
+        return false;
+
+    memcpy(out, f->data + pos, RAW_SECTOR_SIZE);
+    return true;
+}
+
+int image_read_cd_audio(image_t *img, int32_t lba, int count, uint8_t *buf)
+{
+    int32_t end = img->session_leadouts[img->last_session - 1];
+    int n = 0;
+
+    for (; n < count && lba + n >= 0 && lba + n < end; n++) {
+        int32_t pos = lba + n;
+        int i = 0;
+        while (i + 1 < img->track_count && track_begin(&img->tracks[i + 1]) <= pos)
+            i++;
+
+        const image_track_t *t = &img->tracks[i];
+        if (t->control & 0x04)
+            break;
+
+        /* A pregap stored at the end of the previous track's file, else silence */
+        uint8_t *out = buf + (size_t)n * RAW_SECTOR_SIZE;
+        if (!copy_track_sector(img, t, pos, out) &&
+            !(i > 0 && copy_track_sector(img, &img->tracks[i - 1], pos, out)))
+            memset(out, 0, RAW_SECTOR_SIZE);
+    }
+
+    return n;
+}
+
+bool image_read_isrc(image_t *img, int track, char *isrc)
+{
+    isrc[0] = '\0';
+
+    const image_track_t *t = find_track(img, track);
+    if (!t)
+        return false;
+
+    if (t->isrc[0]) {
+        strcpy(isrc, t->isrc);
+        return true;
+    }
+    if (!img->sub.data)
+        return false;
+
+    /* Captured subchannel: accept the first ISRC seen twice with valid CRC */
+    char seen[ISRC_LENGTH + 1] = "";
+    q_subchannel_t q;
+    for (int32_t lba = t->index[1]; lba < t->index[1] + SUB_SCAN_FRAMES; lba++) {
+        if (!read_q_frame(img, lba, &q))
+            break;
+        if (!q.crc_valid || !q.has_isrc || !is_valid_isrc(q.isrc))
+            continue;
+        if (strcmp(seen, q.isrc) == 0) {
+            strcpy(isrc, q.isrc);
+            return true;
+        }
+        strcpy(seen, q.isrc);
+    }
+    return false;
+}
+
+bool image_read_mcn(image_t *img, char *mcn)
+{
+    mcn[0] = '\0';
+
+    if (img->mcn[0]) {
+        strcpy(mcn, img->mcn);
+        return true;
+    }
+    if (!img->sub.data)
+        return false;
+
+    char seen[MCN_LENGTH + 1] = "";
+    q_subchannel_t q;
+    for (int32_t lba = 0; lba < SUB_SCAN_FRAMES; lba++) {
+        if (!read_q_frame(img, lba, &q))
+            break;
+        if (!q.crc_valid || !q.has_mcn || !is_valid_mcn(q.mcn))
+            continue;
+        if (strcmp(seen, q.mcn) == 0) {
+            strcpy(mcn, q.mcn);
+            return true;
+        }
+        strcpy(seen, q.mcn);
+    }
+    return false;
+}
+
+bool image_read_cdtext_raw(image_t *img, uint8_t **data, size_t *len)
+{
+    *data = NULL;
+    *len = 0;
+
+    if (!img->cdtext)
+        return false;
+
+    *data = xmalloc(img->cdtext_len);
+    memcpy(*data, img->cdtext, img->cdtext_len);
+    *len = img->cdtext_len;
+    return true;
+}
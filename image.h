@@ -0,0 +1,65 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * image.h - Disc image backend (CUE/BIN, CloneCD, cdrdao TOC)
+ *
+ * Serves the same data a drive would return through scsi.h (Full TOC,
+ * CD-Text packs, Q-subchannel frames, MCN/ISRC) from image files on disk.
+ * Sector and subchannel files are memory-mapped, so reads run at memory
+ * bandwidth and are fully deterministic.
+ *
+ * Supported formats:
+ *   .cue  CUE sheet with BINARY/WAVE files. CATALOG, ISRC, FLAGS, PREGAP,
+ *         POSTGAP, REM SESSION, CDTEXTFILE and TITLE/PERFORMER/SONGWRITER.
+ *   .ccd  CloneCD control file with .img main channel and optional .sub
+ *         (96 bytes per sector, deinterleaved P-W). [CDText] is honored.
+ *   .toc  cdrdao TOC file with AUDIOFILE/FILE/DATAFILE/SILENCE/ZERO, START,
+ *         INDEX, PREGAP, ISRC, CATALOG and CD_TEXT language 0.
+ *
+ * When an image has no captured subchannel (.cue, .toc, .ccd without .sub),
+ * Q frames are synthesized from the sheet: position frames everywhere, with
+ * an MCN frame and an ISRC frame once per 100 frames where present.
+ */
+
+#ifndef MBDISCID_IMAGE_H
+#define MBDISCID_IMAGE_H
+
+#include "types.h"
+#include "scsi.h"
+#include <stddef.h>
+
+/* Opaque image handle */
+typedef struct image image_t;
+
+/*
+ * Check whether a device argument names a disc image (by extension)
+ */
+bool image_is_image_path(const char *path);
+
+/*
+ * Open and parse an image
+ * Reports parse errors via error() and returns NULL on failure
+ */
+image_t *image_open(const char *path);
+
+/*
+ * Close image and unmap its files
+ */
+void image_close(image_t *img);
+
+/*
+ * Backend counterparts of the scsi.h functions of the same name
+ */
+bool image_read_full_toc(image_t *img, int *first_track, int *last_track,
+                         uint8_t *control, uint8_t *session, int32_t *offsets,
+                         int32_t *session_leadouts, int *last_session);
+bool image_read_toc_control(image_t *img, int *first_track, int *last_track,
+                            uint8_t *control);
+int image_read_q_batch(image_t *img, int32_t lba, int count, q_subchannel_t *q);
+bool image_read_isrc(image_t *img, int track, char *isrc);
+bool image_read_mcn(image_t *img, char *mcn);
+bool image_read_cdtext_raw(image_t *img, uint8_t **data, size_t *len);
+int image_read_cd_audio(image_t *img, int32_t lba, int count, uint8_t *buf);
+
+#endif /* MBDISCID_IMAGE_H */
@@ -0,0 +1,236 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * indexmap.c - Pregap, index and hidden-track map from Q-subchannel
+ */
+
+#include "indexmap.h"
+#include "scsi.h"
+#include "toc.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Frames read per probe; MCN/ISRC frames and CRC failures are skipped */
+#define PROBE_FRAMES   4
+
+/* Q absolute time further than this from the requested LBA is not trusted */
+#define PROBE_SLACK    75
+
+/* First backward step when searching for a pregap (doubles each miss) */
+#define GALLOP_FRAMES  75
+
+/* Probe context */
+typedef struct {
+    scsi_device_t *dev;
+    int probes;
+} prober_t;
+
+/* Decoded Q position */
+typedef struct {
+    int track;
+    int index;
+    int32_t lba;
+} qpos_t;
+
+/*
+ * Read Q at lba and return the first CRC-valid position frame
+ */
+static bool probe(prober_t *p, int32_t lba, qpos_t *pos)
+{
+    q_subchannel_t q[PROBE_FRAMES];
+
+    p->probes++;
+    int n = scsi_read_q_subchannel_batch(p->dev, lba, PROBE_FRAMES, q);
+
+    for (int i = 0; i < n; i++) {
+        if (!q[i].crc_valid || q[i].adr != 1)
+            continue;
+
+        pos->track = q[i].track;
+        pos->index = q[i].index;
+        pos->lba = q[i].lba;
+        if (abs(pos->lba - (lba + i)) > PROBE_SLACK)
+            pos->lba = lba + i;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * True if pos is at or past INDEX index of track
+ * (lead-out reports track AA, which is past every track)
+ */
+static bool reached(const qpos_t *pos, int track, int index)
+{
+    return pos->track > track || (pos->track == track && pos->index >= index);
+}
+
+/*
+ * Find the first LBA in (lo, hi] at which track/index has been reached
+ * lo must be known before the boundary and hi at or past it
+ * Returns -1 on read error
+ */
+static int32_t bisect(prober_t *p, int32_t lo, int32_t hi, int track, int index)
+{
+    while (hi - lo > 1) {
+        int32_t mid = lo + (hi - lo) / 2;
+        qpos_t pos;
+
+        if (!probe(p, mid, &pos))
+            return -1;
+
+        /* No position frame before hi: mid..hi-1 carry no position, keep hi */
+        if (pos.lba >= hi) {
+            lo = mid;
+            continue;
+        }
+
+        int32_t at = (pos.lba > lo) ? pos.lba : mid;
+        if (reached(&pos, track, index))
+            hi = at;
+        else
+            lo = at;
+    }
+
+    return hi;
+}
+
+/*
+ * Locate INDEX 00 of track t, which lies in [floor, offset]
+ * Gallops backward from the offset so a track without a pregap costs
+ * one probe and a pregap of n frames costs O(log n)
+ * Returns -1 on read error
+ */
+static int32_t find_pregap(prober_t *p, int32_t floor, int32_t offset, int track)
+{
+    int32_t hi = offset;
+    int32_t step = 1;
+
+    for (;;) {
+        int32_t lo = hi - step;
+        if (lo <= floor)
+            return bisect(p, floor, hi, track, 0);
+
+        qpos_t pos;
+        if (!probe(p, lo, &pos))
+            return -1;
+        if (pos.lba >= hi || !reached(&pos, track, 0))
+            return bisect(p, lo, hi, track, 0);
+
+        hi = (pos.lba > lo) ? pos.lba : lo;
+        step = (step == 1) ? GALLOP_FRAMES : step * 2;
+    }
+}
+
+/*
+ * Locate INDEX 02 and above within [start, end)
+ * Returns highest index found, or -1 on read error
+ */
+static int find_indexes(prober_t *p, int32_t start, int32_t end, int track,
+                        int32_t *index)
+{
+    qpos_t pos;
+
+    if (end - start < 2 || !probe(p, end - 1, &pos))
+        return end - start < 2 ? 1 : -1;
+    if (pos.track != track || pos.index <= 1)
+        return 1;
+
+    int last = pos.index > MAX_INDEX ? MAX_INDEX : pos.index;
+    for (int k = 2; k <= last; k++) {
+        index[k] = bisect(p, index[k - 1], end - 1, track, k);
+        if (index[k] < 0)
+            return -1;
+    }
+
+    return last;
+}
+
+int indexmap_read_disc(const toc_t *toc, const char *device, index_map_t *map,
+                       int verbosity)
+{
+    memset(map, 0, sizeof(*map));
+
+    verbose(1, verbosity, "index: mapping %d tracks", toc->track_count);
+
+    scsi_device_t *dev = scsi_open(device);
+    if (!dev) {
+        verbose(1, verbosity, "index: failed to open device");
+        return -1;
+    }
+    scsi_set_verbosity(dev, verbosity);
+
+    prober_t p = { .dev = dev, .probes = 0 };
+    bool failed[MAX_TRACKS] = { false };
+
+    /* Pregaps first: each track's end is the next track's INDEX 00 */
+    for (int i = 0; i < toc->track_count; i++) {
+        const track_t *t = &toc->tracks[i];
+        track_index_t *ti = &map->tracks[i];
+
+        ti->index[1] = t->offset;
+        ti->pregap = t->offset;
+
+        if (i == 0) {
+            /* Hidden track: track 1 starts late and LBA 0 is its INDEX 00 */
+            qpos_t pos;
+            if (t->offset > 0 && probe(&p, 0, &pos) &&
+                pos.track == t->number && pos.index == 0) {
+                ti->pregap = 0;
+                map->htoa_length = t->offset;
+                verbose(1, verbosity, "index: hidden track one audio, %d frames",
+                        t->offset);
+            }
+            continue;
+        }
+
+        /* Lead-out and lead-in separate sessions; no pregap to search */
+        if (t->session != toc->tracks[i - 1].session)
+            continue;
+
+        int32_t pregap = find_pregap(&p, toc->tracks[i - 1].offset, t->offset,
+                                     t->number);
+        if (pregap < 0) {
+            verbose(2, verbosity, "index: track %d: pregap probe failed: %s",
+                    t->number, scsi_error(dev));
+            failed[i] = true;
+            continue;
+        }
+        ti->pregap = pregap;
+    }
+
+    /* Sub-indices: everything between INDEX 01 and the next boundary */
+    int mapped = 0;
+    for (int i = 0; i < toc->track_count; i++) {
+        const track_t *t = &toc->tracks[i];
+        track_index_t *ti = &map->tracks[i];
+
+        int32_t end = toc_get_track_end(toc, i);
+        if (i + 1 < toc->track_count && toc->tracks[i + 1].session == t->session)
+            end = map->tracks[i + 1].pregap;
+
+        ti->index_count = failed[i] ? -1 :
+                          find_indexes(&p, t->offset, end, t->number, ti->index);
+        if (ti->index_count < 0) {
+            verbose(2, verbosity, "index: track %d: index probe failed: %s",
+                    t->number, scsi_error(dev));
+            ti->index_count = 1;
+            continue;
+        }
+
+        ti->mapped = true;
+        mapped++;
+        verbose(2, verbosity, "index: track %d: pregap %d frames, %d indices",
+                t->number, t->offset - ti->pregap, ti->index_count);
+    }
+
+    map->probes = p.probes;
+    verbose(1, verbosity, "index: %d of %d tracks mapped with %d probes",
+            mapped, toc->track_count, p.probes);
+
+    scsi_close(dev);
+    return mapped;
+}
@@ -0,0 +1,37 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * indexmap.h - Pregap, index and hidden-track map from Q-subchannel
+ */
+
+#ifndef MBDISCID_INDEXMAP_H
+#define MBDISCID_INDEXMAP_H
+
+#include "types.h"
+
+/*
+ * Map every index transition on the disc by binary search over Q
+ * position frames (ADR=1):
+ * - Pregaps: INDEX 00 start of each track, searched backward from the
+ *   TOC offset (1 probe when there is no pregap)
+ * - Sub-indices: highest index probed at the track end, then each
+ *   INDEX nn (nn >= 2) located by bisection
+ * - Hidden track one audio: INDEX 00 of track 1 at LBA 0 when the
+ *   TOC offset of track 1 is non-zero
+ *
+ * Each boundary costs O(log n) probes of a few frames each, instead of
+ * reading every frame of the disc.
+ *
+ * toc: TOC read from the same device
+ * device: device path (will be opened/closed internally)
+ * map: output, zeroed first; tracks that could not be probed stay unmapped
+ * verbosity: verbosity level for diagnostics
+ *
+ * Returns number of tracks mapped (0 if the drive returns no Q data)
+ * Returns -1 on device error
+ */
+int indexmap_read_disc(const toc_t *toc, const char *device, index_map_t *map,
+                       int verbosity);
+
+#endif /* MBDISCID_INDEXMAP_H */
@@ -11,20 +11,111 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stddef.h>
+#include <sys/stat.h>
 
-/* Configuration per spec §5 */
+/* Configuration per spec §5; sampling parameters come from the profile */
 #define PROBE_COUNT          3
-#define MIN_TRACKS_FOR_PROBE 5
 #define MAX_CANDIDATES       8
-#define INITIAL_TRANCHES     3
-#define RESCUE_TRANCHES      1
-#define FRAMES_PER_TRANCHE   192
-#define BOOKEND_FRAMES       (2 * 75)
-#define SHORT_TRACK_THRESHOLD ((2 * BOOKEND_FRAMES) + ((INITIAL_TRANCHES + RESCUE_TRANCHES + 1) * FRAMES_PER_TRANCHE))
-#define EARLY_STOP_VALID_FRAMES 64
+#define MAX_TRANCHES         8      /* Per phase (initial or rescue) */
+#define MIN_FRAMES_PER_TRANCHE 16
+#define MAX_FRAMES_PER_TRANCHE 256  /* Largest batch READ CD transfer */
+#define MAX_BOOKEND_FRAMES   (10 * 75)
+#define MAX_EARLY_STOP       4096
+
+/* Adaptive tranches trust the disc's ISRC yield after this many frames */
+#define ADAPT_MIN_ISRC_FRAMES 8
+
+/*
+ * ISRC cadence: gaps between consecutive ISRC frames in contiguous reads
+ * reveal the period, and hit positions the phase (absolute, or relative
+ * to the track start for encoders that restart it per track). Both must
+ * agree for 80% of the evidence before reads are aimed at the slots.
+ */
+#define CADENCE_MIN_GAPS     6
+#define CADENCE_MAX_PERIOD   128
+#define CADENCE_MAX_HITS     256
+#define CADENCE_WINDOW       3      /* Frames read around each predicted slot */
+#define MAX_WINDOWS          (MAX_TRANCHES * MAX_FRAMES_PER_TRANCHE / 100 + MAX_TRANCHES)
+
+/*
+ * Latency hedging: a read far slower than the session's usual reads
+ * means the drive is retrying a damaged area. The frames around it are
+ * avoided for the rest of the session, and sampling moves elsewhere in
+ * the same track.
+ */
+#define HEDGE_MIN_READS      8      /* Reads timed before any is called slow */
+#define HEDGE_FACTOR         4      /* Slow: over p95 and this times the median */
+#define HEDGE_FLOOR_MS       50.0   /* ... and never faster than this */
+#define HEDGE_MARGIN         375    /* Frames avoided either side (5 seconds) */
+#define HEDGE_STEP           750    /* Relocation step (10 seconds) */
+#define LATENCY_HISTORY      64
+#define MAX_SLOW_REGIONS     32
 
 #define MAX_LBAS_PER_CANDIDATE 16
 
+/*
+ * Verification (--expect) is a sequential test on CRC-valid ISRC frames.
+ * A frame is taken to carry the wrong ISRC with probability at most 1%
+ * (stale or neighbouring ISRCs returned by the drive). At 99.9%
+ * confidence the test decides once agreeing minus disagreeing frames
+ * reaches +/-ceil(ln 999 / ln 99) = 2.
+ */
+#define VERIFY_MARGIN        2
+#define VERIFY_CHUNK         50
+#define VERIFY_BUDGET        (profile.tranches * profile.frames)
+
+/* Presets for --isrc-profile; balanced is the spec §5 default */
+static const isrc_profile_t presets[] = {
+    /* name       tranches rescue frames bookend early_stop probe_min adaptive cadence */
+    { "fast",            2,     1,   128,    150,        32,        5,       1,       1 },
+    { "balanced",        3,     1,   192,    150,        64,        5,       1,       1 },
+    { "paranoid",        5,     2,   256,    225,         0,        0,       1,       0 },
+};
+
+/* Profile in effect for this run */
+static isrc_profile_t profile = { "balanced", 3, 1, 192, 150, 64, 5, 1, 1 };
+
+/* Reads issued by the current scan: reported at -v, and the disc's
+ * observed ISRC yield for adaptive tranches */
+static struct {
+    int reads;
+    int64_t frames;         /* Frames requested */
+    int64_t returned;       /* Frames the drive returned */
+    int64_t isrc_frames;    /* CRC-valid ADR=3 frames */
+    int64_t crc_bad;
+    int64_t read_errors;    /* Frames of failed reads */
+    int plan_tranches;      /* Last plan, to log changes only */
+    int plan_frames;
+    double start;
+} scan_stats;
+
+/* ISRC frame cadence learned during the current scan */
+static struct {
+    int gaps[CADENCE_MAX_PERIOD + 1];   /* Histogram of gaps between hits */
+    int gap_count;
+    int32_t hits[CADENCE_MAX_HITS];     /* Hit LBAs ... */
+    int32_t hit_tracks[CADENCE_MAX_HITS]; /* ... and their track's start */
+    int hit_count;
+    int32_t track_offset;               /* Start of the track being read */
+    int period;                         /* 0 until known */
+    int phase;
+    bool relative;                      /* Phase counts from the track start */
+    bool broken;                        /* A prediction missed: stop aiming */
+    int windows, window_hits;
+} cadence;
+
+/* Read latencies and slow regions, kept across scans of the session */
+static struct {
+    double ms[LATENCY_HISTORY];         /* Ring of recent read latencies */
+    int reads;
+    int32_t start[MAX_SLOW_REGIONS];    /* Avoided [start, end) */
+    int32_t end[MAX_SLOW_REGIONS];
+    int regions;
+    int moved;                          /* Reads relocated or repeated */
+    int verbosity;
+} hedge;
+
 typedef struct {
     char isrc[13];
     int count;
@@ -80,9 +171,332 @@ bool isrc_validate(const char *isrc)
     return true;
 }
 
+/*
+ * Tracks too short for tranche sampling are scanned in full
+ */
 static bool is_short_track(const track_t *track)
 {
-    return track->length < SHORT_TRACK_THRESHOLD;
+    int32_t threshold = 2 * profile.bookend +
+                        (profile.tranches + profile.rescue + 1) * profile.frames;
+    return track->length < threshold;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Latency above which a read counts as slow (0 until enough are timed)
+ */
+static double slow_threshold(void)
+{
+    int n = hedge.reads < LATENCY_HISTORY ? hedge.reads : LATENCY_HISTORY;
+    if (n < HEDGE_MIN_READS)
+        return 0.0;
+
+    double sorted[LATENCY_HISTORY];
+    memcpy(sorted, hedge.ms, (size_t)n * sizeof(sorted[0]));
+    qsort(sorted, (size_t)n, sizeof(sorted[0]), compare_double);
+
+    double threshold = sorted[n * 95 / 100];
+    if (threshold < HEDGE_FACTOR * sorted[n / 2])
+        threshold = HEDGE_FACTOR * sorted[n / 2];
+    if (threshold < HEDGE_FLOOR_MS)
+        threshold = HEDGE_FLOOR_MS;
+    return threshold;
+}
+
+/*
+ * Known slow region overlapping [lba, lba + count), or -1
+ */
+static int slow_region(int32_t lba, int count)
+{
+    for (int i = 0; i < hedge.regions; i++) {
+        if (lba < hedge.end[i] && lba + count > hedge.start[i])
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Q read timed against the session's latency; a slow read marks its
+ * surroundings to be avoided
+ */
+static int timed_read(scsi_device_t *dev, int32_t lba, int count, q_subchannel_t *q)
+{
+    double start = monotonic_seconds();
+    int got = scsi_read_q_subchannel_batch(dev, lba, count, q);
+    double ms = (monotonic_seconds() - start) * 1e3;
+    double threshold = slow_threshold();
+    hedge.ms[hedge.reads++ % LATENCY_HISTORY] = ms;
+
+    if (threshold > 0.0 && ms > threshold && hedge.regions < MAX_SLOW_REGIONS &&
+        slow_region(lba, count) < 0) {
+        hedge.start[hedge.regions] = lba - HEDGE_MARGIN;
+        hedge.end[hedge.regions] = lba + count + HEDGE_MARGIN;
+        hedge.regions++;
+        verbose(2, hedge.verbosity, "isrc: slow read at %d (%.0f ms, threshold %.0f ms), avoiding frames %d-%d",
+                lba, ms, threshold, lba - HEDGE_MARGIN, lba + count + HEDGE_MARGIN - 1);
+    }
+    return got;
+}
+
+/*
+ * Position for a count-frame read planned at lba: lba itself unless it
+ * touches a slow region, else the nearest whole HEDGE_STEP away that is
+ * inside the track's usable region, clear of slow regions and of the
+ * track's other reads (frames read twice would vote twice)
+ */
+static int32_t hedge_position(const track_t *track, int32_t lba, int count,
+                              const int32_t *others, int num_others)
+{
+    if (slow_region(lba, count) < 0)
+        return lba;
+
+    int32_t lo = track->offset + profile.bookend;
+    int32_t hi = track->offset + track->length - profile.bookend - count;
+    if (hi < lo) {
+        lo = track->offset;
+        hi = track->offset + track->length - count;
+    }
+
+    for (int32_t d = HEDGE_STEP; d <= track->length; d += HEDGE_STEP) {
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            int32_t cand = lba + sign * d;
+            if (cand < lo || cand > hi || slow_region(cand, count) >= 0)
+                continue;
+
+            bool overlap = false;
+            for (int i = 0; i < num_others && !overlap; i++)
+                overlap = cand < others[i] + count && cand + count > others[i];
+            if (overlap)
+                continue;
+
+            hedge.moved++;
+            verbose(2, hedge.verbosity, "isrc: track %d: slow region at %d, reading at %d instead",
+                    track->number, lba, cand);
+            return cand;
+        }
+    }
+    return lba;
+}
+
+/*
+ * Batch Q read, counted for the scan statistics
+ */
+static int read_q_batch(scsi_device_t *dev, int32_t lba, int count, q_subchannel_t *q)
+{
+    int got = timed_read(dev, lba, count, q);
+
+    scan_stats.reads++;
+    scan_stats.frames += count;
+    if (got <= 0) {
+        scan_stats.read_errors += count;
+        return got;
+    }
+
+    scan_stats.returned += got;
+    int last_hit = -1;
+    for (int i = 0; i < got; i++) {
+        if (!q[i].crc_valid) {
+            scan_stats.crc_bad++;
+            continue;
+        }
+        if (q[i].adr != 3)
+            continue;
+
+        scan_stats.isrc_frames++;
+        if (last_hit >= 0 && i - last_hit <= CADENCE_MAX_PERIOD) {
+            cadence.gaps[i - last_hit]++;
+            cadence.gap_count++;
+        }
+        last_hit = i;
+        if (cadence.hit_count < CADENCE_MAX_HITS) {
+            cadence.hits[cadence.hit_count] = lba + i;
+            cadence.hit_tracks[cadence.hit_count++] = cadence.track_offset;
+        }
+    }
+    return got;
+}
+
+/*
+ * Tranche count and size for the next track
+ *
+ * The profile's tranches x frames expect one ISRC frame per 100 (Red
+ * Book's minimum density). Once the disc has shown its own yield of
+ * CRC-valid ISRC frames per frame read (CRC failures and read errors
+ * count against it), the sample is resized to expect the same number:
+ * smaller on clean discs that repeat ISRCs often, larger on damaged
+ * ones. A sample too large for the profile's tranches gets more of
+ * them, spread evenly over the track.
+ */
+static void plan_tranches(const track_t *track, int *tranches, int *frames, int verbosity)
+{
+    *tranches = profile.tranches;
+    *frames = profile.frames;
+
+    if (!profile.adaptive || scan_stats.isrc_frames < ADAPT_MIN_ISRC_FRAMES)
+        return;
+
+    int64_t seen = scan_stats.returned + scan_stats.read_errors;
+    int64_t nominal = (int64_t)profile.tranches * profile.frames;
+    int64_t total = (nominal * seen + 100 * scan_stats.isrc_frames - 1) /
+                    (100 * scan_stats.isrc_frames);
+
+    /* Within an eighth of nominal the difference is sampling noise */
+    if (total > nominal - nominal / 8 && total < nominal + nominal / 8)
+        return;
+
+    int t = profile.tranches;
+    while (t < MAX_TRANCHES && total > (int64_t)t * MAX_FRAMES_PER_TRANCHE)
+        t++;
+
+    /* Never below a quarter of the profile: a tranche must still span
+     * several ISRC periods to be worth its seek */
+    int64_t f = ((total + t - 1) / t + 7) / 8 * 8;
+    int64_t min_frames = profile.frames / 4;
+    if (min_frames < MIN_FRAMES_PER_TRANCHE)
+        min_frames = MIN_FRAMES_PER_TRANCHE;
+    if (f < min_frames)
+        f = min_frames;
+    if (f > MAX_FRAMES_PER_TRANCHE)
+        f = MAX_FRAMES_PER_TRANCHE;
+
+    *tranches = t;
+    *frames = (int)f;
+
+    if (t != scan_stats.plan_tranches || f != scan_stats.plan_frames) {
+        int64_t total_q = scan_stats.returned > 0 ? scan_stats.returned : 1;
+        verbose(2, verbosity, "isrc: track %d: %d tranches of %d frames (ISRC yield %.2f%%, CRC errors %.1f%%, read errors %.1f%%)",
+                track->number, t, (int)f,
+                100.0 * (double)scan_stats.isrc_frames / (double)seen,
+                100.0 * (double)scan_stats.crc_bad / (double)total_q,
+                100.0 * (double)scan_stats.read_errors / (double)seen);
+        scan_stats.plan_tranches = t;
+        scan_stats.plan_frames = (int)f;
+    }
+}
+
+static void scan_stats_start(void)
+{
+    memset(&scan_stats, 0, sizeof(scan_stats));
+    memset(&cadence, 0, sizeof(cadence));
+    scan_stats.start = monotonic_seconds();
+}
+
+static void scan_stats_report(scsi_device_t *dev, int tracks, int verbosity)
+{
+    char skew[32] = "";
+    int frames;
+    if (scsi_get_q_skew(dev, &frames))
+        snprintf(skew, sizeof(skew), ", Q skew %+d", frames);
+    char slow[48] = "";
+    if (hedge.regions > 0)
+        snprintf(slow, sizeof(slow), ", %d slow regions, %d reads moved",
+                 hedge.regions, hedge.moved);
+
+    double secs = monotonic_seconds() - scan_stats.start;
+
+    verbose(1, verbosity, "isrc: profile %s: %d reads, %lld frames in %.2fs (%.1f reads, %.0f frames per track%s%s)",
+            profile.name, scan_stats.reads, (long long)scan_stats.frames, secs,
+            tracks > 0 ? (double)scan_stats.reads / tracks : 0.0,
+            tracks > 0 ? (double)scan_stats.frames / tracks : 0.0, skew, slow);
+}
+
+/*
+ * Parse one "key=value" override into p
+ * Returns false if the key is unknown or the value out of range
+ */
+static bool set_parameter(isrc_profile_t *p, const char *key, const char *value)
+{
+    static const struct {
+        const char *key;
+        size_t offset;
+        int min, max;
+    } params[] = {
+        { "tranches",   offsetof(isrc_profile_t, tranches),   1, MAX_TRANCHES },
+        { "rescue",     offsetof(isrc_profile_t, rescue),     0, MAX_TRANCHES },
+        { "frames",     offsetof(isrc_profile_t, frames),     MIN_FRAMES_PER_TRANCHE, MAX_FRAMES_PER_TRANCHE },
+        { "bookend",    offsetof(isrc_profile_t, bookend),    0, MAX_BOOKEND_FRAMES },
+        { "early-stop", offsetof(isrc_profile_t, early_stop), 0, MAX_EARLY_STOP },
+        { "probe-min",  offsetof(isrc_profile_t, probe_min),  0, MAX_TRACKS },
+        { "adaptive",   offsetof(isrc_profile_t, adaptive),   0, 1 },
+        { "cadence",    offsetof(isrc_profile_t, cadence),    0, 1 },
+    };
+
+    for (size_t i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+        if (strcmp(key, params[i].key) != 0)
+            continue;
+
+        char *end;
+        long v = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || v < params[i].min || v > params[i].max)
+            return false;
+        /* A probe needs PROBE_COUNT tracks to choose from */
+        if (params[i].offset == offsetof(isrc_profile_t, probe_min) &&
+            v != 0 && v < PROBE_COUNT)
+            return false;
+
+        *(int *)((char *)p + params[i].offset) = (int)v;
+        return true;
+    }
+
+    return false;
+}
+
+void isrc_session_reset(void)
+{
+    int verbosity = hedge.verbosity;
+    memset(&hedge, 0, sizeof(hedge));
+    hedge.verbosity = verbosity;
+}
+
+int isrc_set_profile(const char *spec)
+{
+    char *copy = xstrdup(spec);
+    char *save = NULL;
+    char *tok = strtok_r(copy, ",", &save);
+    isrc_profile_t p = profile;
+    bool named = false;
+    int ret = 0;
+
+    /* A leading preset name is optional: "frames=96" tunes balanced */
+    if (tok && !strchr(tok, '=')) {
+        for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++) {
+            if (strcmp(tok, presets[i].name) == 0) {
+                p = presets[i];
+                named = true;
+            }
+        }
+        if (!named) {
+            error("isrc: unknown profile: %s", tok);
+            free(copy);
+            return EX_USAGE;
+        }
+        tok = strtok_r(NULL, ",", &save);
+    }
+
+    for (; tok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        if (eq)
+            *eq = '\0';
+        if (!eq || !set_parameter(&p, tok, eq + 1)) {
+            if (eq)
+                *eq = '=';
+            error("isrc: invalid profile setting: %s", tok);
+            ret = EX_USAGE;
+            break;
+        }
+        /* Overrides make it a custom profile */
+        p.name = "custom";
+    }
+
+    if (ret == 0)
+        profile = p;
+    free(copy);
+    return ret;
 }
 
 static void collector_add(isrc_collector_t *c, const char *isrc, int32_t lba)
@@ -153,18 +567,16 @@ static char *collector_format_candidates(isrc_collector_t *c)
         return xstrdup("(none)");
     }
 
-    /* Estimate buffer size: 12 chars ISRC + "×" + count + ", " per candidate */
-    size_t bufsize = c->num_candidates * 24;
+    /* 12 chars ISRC + "×" (2 bytes) + count (up to 10) + ", " per candidate */
+    size_t bufsize = c->num_candidates * 28 + 1;
     char *buf = xmalloc(bufsize);
+    size_t len = 0;
     buf[0] = '\0';
 
-    for (int i = 0; i < c->num_candidates; i++) {
-        char entry[32];
-        snprintf(entry, sizeof(entry), "%s×%d", c->candidates[i].isrc, c->candidates[i].count);
-        if (i > 0) {
-            strcat(buf, ", ");
-        }
-        strcat(buf, entry);
+    /* Appends at a running offset: one pass, no rescans of buf */
+    for (int i = 0; i < c->num_candidates && len < bufsize; i++) {
+        len += snprintf(buf + len, bufsize - len, "%s%s×%d", i > 0 ? ", " : "",
+                        c->candidates[i].isrc, c->candidates[i].count);
     }
 
     return buf;
@@ -254,14 +666,160 @@ static int select_probe_tracks(const toc_t *toc, int *probe_indices, int verbosi
     return PROBE_COUNT;
 }
 
+/*
+ * Most common phase of the recorded hits for period, counted from the
+ * disc start or from each hit's track start
+ * Returns its share of the hits in *votes
+ */
+static int cadence_phase(int period, bool relative, int *votes)
+{
+    int count[CADENCE_MAX_PERIOD] = {0};
+    int best = 0;
+
+    for (int i = 0; i < cadence.hit_count; i++) {
+        int32_t pos = cadence.hits[i] - (relative ? cadence.hit_tracks[i] : 0);
+        int ph = (int)(((pos % period) + period) % period);
+        if (++count[ph] > count[best])
+            best = ph;
+    }
+
+    *votes = count[best];
+    return best;
+}
+
+/*
+ * Whether ISRC frames fall on a known cadence, learning it from the
+ * contiguous reads so far
+ */
+static bool cadence_known(int verbosity)
+{
+    if (!profile.cadence || cadence.broken)
+        return false;
+    if (cadence.period > 0)
+        return true;
+    if (cadence.gap_count < CADENCE_MIN_GAPS)
+        return false;
+
+    int period = 1;
+    for (int g = 2; g <= CADENCE_MAX_PERIOD; g++) {
+        if (cadence.gaps[g] > cadence.gaps[period])
+            period = g;
+    }
+    if (period < 2 || cadence.gaps[period] * 5 < cadence.gap_count * 4)
+        return false;
+
+    int abs_votes, rel_votes;
+    int abs_phase = cadence_phase(period, false, &abs_votes);
+    int rel_phase = cadence_phase(period, true, &rel_votes);
+    bool relative = rel_votes > abs_votes;
+    int votes = relative ? rel_votes : abs_votes;
+    if (votes * 5 < cadence.hit_count * 4)
+        return false;
+
+    cadence.period = period;
+    cadence.phase = relative ? rel_phase : abs_phase;
+    cadence.relative = relative;
+    verbose(2, verbosity, "isrc: ISRC every %d frames at phase %d%s, reading predicted slots",
+            period, cadence.phase, relative ? " of each track" : "");
+    return true;
+}
+
+/*
+ * Read CADENCE_WINDOW frames around predicted ISRC slots instead of
+ * contiguous tranches: as many slots as the tranche plan expects ISRC
+ * frames, split over the tranche positions
+ * Returns false (cadence abandoned) when predicted slots turn out to
+ * hold clean non-ISRC frames; hits so far stay in the collector
+ */
+static bool read_track_targeted(scsi_device_t *dev, const track_t *track,
+                                const int32_t *positions, int tranches,
+                                isrc_collector_t *c, int verbosity)
+{
+    q_subchannel_t q[CADENCE_WINDOW];
+    int32_t windows[MAX_WINDOWS];
+    int sizes[MAX_WINDOWS];
+    int num_windows = 0;
+    int period = cadence.period;
+    int32_t origin = cadence.relative ? track->offset : 0;
+    int32_t end = track->offset + track->length;
+    int slots = (profile.tranches * profile.frames + 99) / 100;
+    int per_tranche = (slots + tranches - 1) / tranches;
+    int hits = 0, misses = 0;
+
+    for (int t = 0; t < tranches; t++) {
+        /* First slot at or after the tranche position */
+        int32_t rel = positions[t] - origin;
+        int32_t slot = positions[t] + (int32_t)((((cadence.phase - rel) % period) + period) % period);
+
+        for (int w = 0; w < per_tranche && num_windows < MAX_WINDOWS; slot += period) {
+            int32_t lba = slot - CADENCE_WINDOW / 2;
+            if (lba + CADENCE_WINDOW > end)
+                break;
+
+            /* Slots in a slow region are passed over, not counted */
+            if (slow_region(lba, CADENCE_WINDOW) >= 0)
+                continue;
+            w++;
+            windows[num_windows] = lba;
+            sizes[num_windows++] = CADENCE_WINDOW;
+        }
+    }
+
+    /* Windows close enough to share a command on this drive do */
+    scsi_prefetch_q_subchannel(dev, windows, sizes, num_windows);
+
+    for (int w = 0; w < num_windows; w++) {
+        int32_t lba = windows[w];
+        if (slow_region(lba, CADENCE_WINDOW) >= 0)
+            continue;
+
+        int got = timed_read(dev, lba, CADENCE_WINDOW, q);
+        scan_stats.reads++;
+        scan_stats.frames += CADENCE_WINDOW;
+        cadence.windows++;
+        if (got <= 0)
+            continue;
+
+        bool hit = false, clean = true;
+        for (int f = 0; f < got; f++) {
+            c->total_read++;
+            if (!q[f].crc_valid) {
+                clean = false;
+            } else if (q[f].has_isrc) {
+                collector_add(c, q[f].isrc, lba + f);
+                hit = true;
+            }
+        }
+
+        if (hit) {
+            hits++;
+            cadence.window_hits++;
+        } else if (clean) {
+            misses++;
+        }
+
+        /* A damaged window proves nothing; clean misses do */
+        if (misses >= 2 && misses > hits) {
+            verbose(2, verbosity, "isrc: track %d: ISRC cadence lost (%d of %d slots missed), contiguous reads",
+                    track->number, misses, hits + misses);
+            cadence.broken = true;
+            return false;
+        }
+    }
+
+    verbose(3, verbosity, "isrc: track %d: %d of %d predicted slots held an ISRC",
+            track->number, hits, hits + misses);
+    return true;
+}
+
 static void calculate_tranche_positions(const track_t *track, int num_tranches,
-                                        int32_t *positions, int *frames_per_tranche)
+                                        int32_t *positions)
 {
     int32_t track_start = track->offset;
     int32_t track_length = track->length;
 
-    int32_t usable_start = track_start + BOOKEND_FRAMES;
-    int32_t usable_end = track_start + track_length - BOOKEND_FRAMES;
+    int32_t usable_start = track_start + profile.bookend;
+    int32_t usable_end = track_start + track_length - profile.bookend;
 
     if (usable_end <= usable_start) {
         usable_start = track_start;
@@ -278,20 +836,40 @@ static void calculate_tranche_positions(const track_t *track, int num_tranches,
             positions[i] = usable_start + step * (i + 1);
         }
     }
+}
 
-    *frames_per_tranche = FRAMES_PER_TRANCHE;
+/*
+ * Read tranche t of num, moving it off slow regions first; a read that
+ * fails where it has just been found slow is repeated once elsewhere
+ * pos[t] is updated to where the tranche was read
+ */
+static int read_tranche(scsi_device_t *dev, const track_t *track, int32_t *pos,
+                        int t, int num, int frames, q_subchannel_t *batch)
+{
+    pos[t] = hedge_position(track, pos[t], frames, pos, num);
+    int got = read_q_batch(dev, pos[t], frames, batch);
+
+    if (got <= 0 && slow_region(pos[t], frames) >= 0) {
+        int32_t alt = hedge_position(track, pos[t], frames, pos, num);
+        if (alt != pos[t]) {
+            pos[t] = alt;
+            got = read_q_batch(dev, alt, frames, batch);
+        }
+    }
+    return got;
 }
 
 static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
 {
     isrc_collector_t collector = {0};
     collector.track_offset = track->offset;
+    cadence.track_offset = track->offset;
     int crc_valid_count = 0;
     int crc_invalid_count = 0;
     int adr_counts[4] = {0};
     int read_errors = 0;
 
-    if (track->length < SHORT_TRACK_THRESHOLD) {
+    if (is_short_track(track)) {
         verbose(2, verbosity, "isrc: track %d: short track (%d frames), full scan",
                 track->number, track->length);
 
@@ -301,7 +879,7 @@ static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
             return false;
         }
 
-        int read_count = scsi_read_q_subchannel_batch(dev, track->offset, track->length, batch);
+        int read_count = read_q_batch(dev, track->offset, track->length, batch);
 
         if (read_count > 0) {
             for (int i = 0; i < read_count; i++) {
@@ -352,9 +930,10 @@ static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
         return false;
     }
 
-    int32_t tranche_pos[INITIAL_TRANCHES + RESCUE_TRANCHES];
-    int frames_per_tranche;
-    calculate_tranche_positions(track, INITIAL_TRANCHES, tranche_pos, &frames_per_tranche);
+    int32_t tranche_pos[2 * MAX_TRANCHES];
+    int tranches, frames_per_tranche;
+    plan_tranches(track, &tranches, &frames_per_tranche, verbosity);
+    calculate_tranche_positions(track, tranches, tranche_pos);
 
     q_subchannel_t *batch = malloc(frames_per_tranche * sizeof(q_subchannel_t));
     if (!batch) {
@@ -362,10 +941,15 @@ static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
         return false;
     }
 
-    for (int t = 0; t < INITIAL_TRANCHES; t++) {
-        int32_t base_lba = tranche_pos[t];
+    /* Aim at the ISRC slots once the disc has shown where they are */
+    bool targeted = cadence_known(verbosity) &&
+                    read_track_targeted(dev, track, tranche_pos, tranches,
+                                        &collector, verbosity);
 
-        int read_count = scsi_read_q_subchannel_batch(dev, base_lba, frames_per_tranche, batch);
+    for (int t = 0; !targeted && t < tranches; t++) {
+        int read_count = read_tranche(dev, track, tranche_pos, t, tranches,
+                                      frames_per_tranche, batch);
+        int32_t base_lba = tranche_pos[t];
 
         if (read_count > 0) {
             for (int f = 0; f < read_count; f++) {
@@ -387,7 +971,7 @@ static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
             collector.total_read += frames_per_tranche;
         }
 
-        if (collector.total_valid >= EARLY_STOP_VALID_FRAMES) {
+        if (profile.early_stop > 0 && collector.total_valid >= profile.early_stop) {
             const char *winner = collector_get_majority(&collector);
             if (winner) {
                 strncpy(track->isrc, winner, 12);
@@ -433,14 +1017,14 @@ static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
         verbose(2, verbosity, "isrc: track %d: rescue sampling (%d candidates, no majority)",
                 track->number, collector.num_candidates);
 
-        calculate_tranche_positions(track, INITIAL_TRANCHES + RESCUE_TRANCHES,
-                                    tranche_pos, &frames_per_tranche);
+        calculate_tranche_positions(track, tranches + profile.rescue, tranche_pos);
 
-        for (int t = INITIAL_TRANCHES; t < INITIAL_TRANCHES + RESCUE_TRANCHES; t++) {
+        for (int t = tranches; t < tranches + profile.rescue; t++) {
+            int read_count = read_tranche(dev, track, tranche_pos, t,
+                                          tranches + profile.rescue,
+                                          frames_per_tranche, batch);
             int32_t base_lba = tranche_pos[t];
 
-            int read_count = scsi_read_q_subchannel_batch(dev, base_lba, frames_per_tranche, batch);
-
             if (read_count > 0) {
                 for (int f = 0; f < read_count; f++) {
                     collector.total_read++;
@@ -496,6 +1080,28 @@ static bool read_track_isrc(scsi_device_t *dev, track_t *track, int verbosity)
     return false;
 }
 
+/*
+ * Short tracks are read in full one after another: offer the run of
+ * them starting at toc index i to the drive as one plan, so adjacent
+ * tracks share commands
+ */
+static void prefetch_short_tracks(scsi_device_t *dev, const toc_t *toc, int i)
+{
+    int32_t lba[MAX_TRACKS];
+    int count[MAX_TRACKS];
+    int n = 0;
+
+    for (; i < toc->track_count; i++) {
+        const track_t *track = &toc->tracks[i];
+        if (track->type != TRACK_TYPE_AUDIO || !is_short_track(track))
+            break;
+        lba[n] = track->offset;
+        count[n++] = track->length;
+    }
+    if (n > 1)
+        scsi_prefetch_q_subchannel(dev, lba, count, n);
+}
+
 int isrc_read_disc(toc_t *toc, const char *device, int verbosity)
 {
     verbose(1, verbosity, "isrc: starting scan");
@@ -507,6 +1113,8 @@ int isrc_read_disc(toc_t *toc, const char *device, int verbosity)
     }
 
     scsi_set_verbosity(dev, verbosity);
+    hedge.verbosity = verbosity;
+    scan_stats_start();
 
     int found_count = 0;
 
@@ -594,7 +1202,7 @@ int isrc_read_disc(toc_t *toc, const char *device, int verbosity)
     bool disc_has_isrc = false;
 
     /* Use batch Q-subchannel reading with majority voting */
-    if (audio_count >= MIN_TRACKS_FOR_PROBE) {
+    if (profile.probe_min > 0 && audio_count >= profile.probe_min) {
         int probe_indices[PROBE_COUNT];
         int num_probes = select_probe_tracks(toc, probe_indices, verbosity);
 
@@ -612,6 +1220,7 @@ int isrc_read_disc(toc_t *toc, const char *device, int verbosity)
 
             if (!disc_has_isrc) {
                 verbose(1, verbosity, "isrc: no ISRCs in probe tracks, skipping full scan");
+                scan_stats_report(dev, num_probes, verbosity);
                 scsi_close(dev);
                 return 0;
             }
@@ -633,6 +1242,7 @@ int isrc_read_disc(toc_t *toc, const char *device, int verbosity)
                     continue;
                 }
 
+                prefetch_short_tracks(dev, toc, i);
                 if (read_track_isrc(dev, &toc->tracks[i], verbosity)) {
                     found_count++;
                 }
@@ -649,14 +1259,258 @@ full_scan:
                 continue;
             }
 
+            prefetch_short_tracks(dev, toc, i);
             if (read_track_isrc(dev, &toc->tracks[i], verbosity)) {
                 found_count++;
             }
         }
     }
 
-    scsi_close(dev);
-
     verbose(1, verbosity, "isrc: scan complete, %d found", found_count);
+    scan_stats_report(dev, audio_count, verbosity);
+    scsi_close(dev);
     return found_count;
 }
+
+/*
+ * Copy an expected ISRC token, dropping the hyphens of the printed form
+ * (US-ABC-00-00001). Returns false if it is not a valid ISRC.
+ */
+static bool parse_isrc_token(const char *tok, char *isrc)
+{
+    int n = 0;
+
+    for (const char *p = tok; *p; p++) {
+        if (*p == '-')
+            continue;
+        if (n == ISRC_LENGTH)
+            return false;
+        isrc[n++] = (char)toupper((unsigned char)*p);
+    }
+    isrc[n] = '\0';
+
+    return isrc_validate(isrc);
+}
+
+int isrc_parse_expected(const char *arg, const toc_t *toc, isrc_check_t *checks)
+{
+    char *text;
+    struct stat st;
+
+    /* A path names a file; anything else is the list itself */
+    if (stat(arg, &st) == 0) {
+        FILE *f = fopen(arg, "r");
+        if (!f || !S_ISREG(st.st_mode)) {
+            if (f)
+                fclose(f);
+            error("isrc: cannot open %s", arg);
+            return EX_NOINPUT;
+        }
+        text = xmalloc((size_t)st.st_size + 1);
+        size_t n = fread(text, 1, (size_t)st.st_size, f);
+        text[n] = '\0';
+        fclose(f);
+    } else {
+        text = xstrdup(arg);
+    }
+
+    memset(checks, 0, MAX_TRACKS * sizeof(*checks));
+
+    /* "N: ISRC" (the -I output) names a track; bare ISRCs or "-" follow
+     * the audio tracks in order */
+    int next_audio = 0, count = 0, ret = 0;
+    for (char *save, *tok = strtok_r(text, " \t\r\n,", &save); tok;
+         tok = strtok_r(NULL, " \t\r\n,", &save)) {
+        int index = -1;
+        size_t len = strlen(tok);
+
+        if (len > 1 && tok[len - 1] == ':') {
+            int number = atoi(tok);
+            for (int i = 0; i < toc->track_count; i++) {
+                if (toc->tracks[i].number == number &&
+                    toc->tracks[i].type == TRACK_TYPE_AUDIO)
+                    index = i;
+            }
+            tok = strtok_r(NULL, " \t\r\n,", &save);
+            if (index < 0) {
+                error("isrc: track %d is not an audio track", number);
+                ret = EX_DATAERR;
+                break;
+            }
+            if (!tok) {
+                error("isrc: track %d: missing expected ISRC", number);
+                ret = EX_DATAERR;
+                break;
+            }
+        } else {
+            while (next_audio < toc->track_count &&
+                   toc->tracks[next_audio].type != TRACK_TYPE_AUDIO)
+                next_audio++;
+            if (next_audio == toc->track_count) {
+                error("isrc: more expected ISRCs than audio tracks");
+                ret = EX_DATAERR;
+                break;
+            }
+            index = next_audio++;
+        }
+
+        if (strcmp(tok, "-") == 0) {
+            checks[index].expected[0] = '\0';
+            continue;
+        }
+        if (!parse_isrc_token(tok, checks[index].expected)) {
+            error("isrc: invalid expected ISRC: %s", tok);
+            ret = EX_DATAERR;
+            break;
+        }
+        count++;
+    }
+
+    if (ret == 0 && count == 0) {
+        error("isrc: no expected ISRCs");
+        ret = EX_DATAERR;
+    }
+
+    free(text);
+    return ret;
+}
+
+/*
+ * Check one track against check->expected with the fewest Q frames
+ */
+static void verify_track(scsi_device_t *dev, const track_t *track,
+                         isrc_check_t *check, int verbosity)
+{
+    isrc_collector_t others = {0};
+    q_subchannel_t batch[VERIFY_CHUNK];
+    int net = 0, seen = 0, read_errors = 0;
+
+    /* Same usable region as discovery: skip the bookends where drives
+     * still report the neighbouring track's ISRC */
+    int32_t start = track->offset + profile.bookend;
+    int32_t end = track->offset + track->length - profile.bookend;
+    if (end <= start) {
+        start = track->offset;
+        end = track->offset + track->length;
+    }
+
+    check->verdict = ISRC_UNDECIDED;
+    for (int32_t lba = start; lba < end && check->frames < VERIFY_BUDGET; ) {
+        int n = VERIFY_CHUNK;
+        if (n > end - lba)
+            n = end - lba;
+        if (n > VERIFY_BUDGET - check->frames)
+            n = VERIFY_BUDGET - check->frames;
+
+        int slow = slow_region(lba, n);
+        if (slow >= 0) {
+            lba = hedge.end[slow];
+            continue;
+        }
+
+        int got = timed_read(dev, lba, n, batch);
+        check->frames += n;
+        lba += n;
+        if (got <= 0) {
+            read_errors += n;
+            continue;
+        }
+
+        for (int f = 0; f < got; f++) {
+            const q_subchannel_t *q = &batch[f];
+            if (!q->crc_valid || !q->has_isrc || !isrc_validate(q->isrc))
+                continue;
+
+            seen++;
+            if (strcmp(q->isrc, check->expected) == 0) {
+                net++;
+            } else {
+                net--;
+                collector_add(&others, q->isrc, lba - n + f);
+            }
+        }
+
+        /* Decide at chunk granularity: the frames are already read */
+        if (net >= VERIFY_MARGIN) {
+            check->verdict = ISRC_MATCH;
+            break;
+        }
+        if (net <= -VERIFY_MARGIN) {
+            check->verdict = ISRC_MISMATCH;
+            break;
+        }
+    }
+
+    /* Drive-reported ISRC when subchannel reads are unavailable */
+    if (seen == 0 && read_errors == check->frames) {
+        char isrc[ISRC_LENGTH + 1];
+        verbose(2, verbosity, "isrc: track %d: subchannel unreadable, asking drive",
+                track->number);
+        if (scsi_read_isrc(dev, track->number, isrc) && isrc_validate(isrc)) {
+            if (strcmp(isrc, check->expected) == 0) {
+                check->verdict = ISRC_MATCH;
+            } else {
+                check->verdict = ISRC_MISMATCH;
+                strcpy(check->found, isrc);
+            }
+            return;
+        }
+    }
+
+    if (check->verdict == ISRC_UNDECIDED && seen == 0)
+        check->verdict = ISRC_MISSING;
+
+    /* Report what the disc has instead */
+    int best = -1;
+    for (int i = 0; i < others.num_candidates; i++) {
+        if (best < 0 || others.candidates[i].count > others.candidates[best].count)
+            best = i;
+    }
+    if (best >= 0 && check->verdict != ISRC_MATCH)
+        strcpy(check->found, others.candidates[best].isrc);
+
+    verbose(3, verbosity, "isrc: track %d: %d ISRC frames, net %+d, read_err:%d",
+            track->number, seen, net, read_errors);
+}
+
+int isrc_verify_disc(const toc_t *toc, const char *device, isrc_check_t *checks,
+                     bool fail_fast, int verbosity)
+{
+    verbose(1, verbosity, "isrc: verifying expected ISRCs");
+    hedge.verbosity = verbosity;
+
+    scsi_device_t *dev = scsi_open(device);
+    if (!dev) {
+        verbose(1, verbosity, "isrc: failed to open device");
+        return -1;
+    }
+
+    scsi_set_verbosity(dev, verbosity);
+
+    int failed = 0, frames = 0;
+    for (int i = 0; i < toc->track_count; i++) {
+        isrc_check_t *check = &checks[i];
+        if (!check->expected[0])
+            continue;
+
+        verify_track(dev, &toc->tracks[i], check, verbosity);
+        frames += check->frames;
+        verbose(2, verbosity, "isrc: track %d: %s after %d frames",
+                toc->tracks[i].number,
+                check->verdict == ISRC_MATCH ? "confirmed" : "not confirmed",
+                check->frames);
+
+        if (check->verdict != ISRC_MATCH) {
+            failed++;
+            if (fail_fast && (check->verdict == ISRC_MISMATCH ||
+                              check->verdict == ISRC_MISSING))
+                break;
+        }
+    }
+
+    scsi_close(dev);
+
+    verbose(1, verbosity, "isrc: verify complete, %d frames read, %d not matching",
+            frames, failed);
+    return failed;
+}
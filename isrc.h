@@ -11,14 +11,43 @@
 #include "types.h"
 #include "scsi.h"
 
+/* Sampling parameters of the ISRC scan (--isrc-profile, spec §5.2) */
+typedef struct {
+    const char *name;       /* Preset name, or "custom" after overrides */
+    int tranches;           /* Tranches read per track */
+    int rescue;             /* Extra tranches when there is no majority */
+    int frames;             /* Q frames per tranche */
+    int bookend;            /* Frames skipped at each end of a track */
+    int early_stop;         /* Valid ISRC frames that end a track early (0 = off) */
+    int probe_min;          /* Audio tracks needed to probe first (0 = never) */
+    int adaptive;           /* Resize tranches to the disc's ISRC yield (0 = off) */
+    int cadence;            /* Read only predicted ISRC slots once known (0 = off) */
+} isrc_profile_t;
+
+/*
+ * Select the sampling profile for later scans and verifications:
+ * spec is "NAME[,key=value...]" or "key=value[,...]" (tuning balanced);
+ * NAME is fast, balanced or paranoid; keys are tranches, rescue, frames,
+ * bookend, early-stop, probe-min, adaptive and cadence
+ *
+ * Returns 0 on success, EX_USAGE if spec is invalid (reported via error())
+ */
+int isrc_set_profile(const char *spec);
+
+/*
+ * Forget slow regions and read latencies learned so far (--repeat runs
+ * start from scratch)
+ */
+void isrc_session_reset(void);
+
 /*
  * Read ISRCs from disc using spec §5 algorithm:
  * - Raw subchannel reading at specific LBA positions
- * - Tranche-based sampling (4 tranches × 32 frames = 128 samples)
+ * - Tranche-based sampling per the profile (balanced: 3 × 192 frames)
  * - CRC validation per frame
- * - Probe strategy for n≥5 tracks (3 probes at 33/50/67%)
+ * - Probe strategy for n ≥ probe_min tracks (3 probes at 33/50/67%)
  * - Majority voting with strong majority rule (2:1)
- * - Rescue sampling (2 additional tranches) if no majority
+ * - Rescue sampling (profile's rescue tranches) if no majority
  * - Early termination if no ISRCs detected in probes
  *
  * toc: TOC with track info (modified in place - ISRCs filled in)
@@ -30,6 +59,34 @@
  */
 int isrc_read_disc(toc_t *toc, const char *device, int verbosity);
 
+/*
+ * Parse expected ISRCs for verification (--expect):
+ * - arg: a file, or the list itself if no such path exists
+ * - "N: ISRC" pairs (as printed by -I) name a track; bare ISRCs (hyphens
+ *   allowed) and "-" (no expectation) are assigned to audio tracks in order
+ *
+ * checks: output, parallel to toc->tracks (MAX_TRACKS entries)
+ *
+ * Returns 0 on success, EX_NOINPUT or EX_DATAERR (reported via error())
+ */
+int isrc_parse_expected(const char *arg, const toc_t *toc, isrc_check_t *checks);
+
+/*
+ * Verify each track that has an expected ISRC with as few Q frames as
+ * possible: reading stops as soon as a sequential test on CRC-valid
+ * ISRC frames confirms or refutes the match at 99.9% confidence, or
+ * after the profile's initial tranche budget (tranches x frames).
+ *
+ * checks: expectations in, verdicts out (ISRC_UNCHECKED past a
+ *         --fail-fast stop)
+ * fail_fast: stop after the first mismatch or missing ISRC
+ *
+ * Returns number of checked tracks that did not match
+ * Returns -1 on device error
+ */
+int isrc_verify_disc(const toc_t *toc, const char *device, isrc_check_t *checks,
+                     bool fail_fast, int verbosity);
+
 /*
  * Validate ISRC format per spec §5.1.3:
  * - 2 uppercase letters (country code)
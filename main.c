@@ -11,6 +11,10 @@
 #include "toc.h"
 #include "discid.h"
 #include "output.h"
+#include "ardb.h"
+#include "record.h"
+#include "template.h"
+#include "textfiles.h"
 #include "util.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -42,6 +46,41 @@ static char *read_stdin_toc(void)
     return result;
 }
 
+/*
+ * Read everything the mode needs from the device
+ * Returns 0 on success, exit code on error
+ */
+static int acquire(const char *device, disc_info_t *disc, int flags,
+                   const options_t *opts)
+{
+    int ret = device_read_disc(device, disc, flags, opts->verbosity);
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Audio checksums read the whole disc; only when asked for */
+    if (opts->mode == MODE_CRC) {
+        ret = device_read_audio(device, &disc->toc, opts->read_offset,
+                                disc->crcs, opts->verbosity);
+        if (ret != 0) {
+            return ret;
+        }
+        disc->has_crcs = true;
+    }
+
+    /* Known ISRCs: confirm or refute each instead of discovering */
+    if (opts->expect) {
+        ret = device_verify_isrc(device, &disc->toc, opts->expect, disc->checks,
+                                 opts->fail_fast, opts->verbosity);
+        if (ret != 0) {
+            return ret;
+        }
+        disc->has_checks = true;
+    }
+
+    return 0;
+}
+
 /*
  * Calculate and store disc IDs
  * Returns 0 on success, error code if a required ID fails to calculate
@@ -50,7 +89,8 @@ static int calculate_ids(disc_info_t *disc, int mode, bool quiet)
 {
     char *id;
     bool need_mb = (mode == MODE_MUSICBRAINZ || mode == MODE_ALL);
-    bool need_freedb = (mode == MODE_FREEDB || mode == MODE_ALL || mode == MODE_ACCURATERIP);
+    bool need_freedb = (mode == MODE_FREEDB || mode == MODE_ALL || mode == MODE_ACCURATERIP ||
+                        mode == MODE_CUE);
     bool need_ar = (mode == MODE_ACCURATERIP || mode == MODE_ALL);
 
     /* MusicBrainz ID */
@@ -89,6 +129,149 @@ static int calculate_ids(disc_info_t *disc, int mode, bool quiet)
     return 0;
 }
 
+/*
+ * Everything after the disc is read: IDs, the --ar-db lookup, output
+ * and the --expect verdict. Frees the disc's CD-Text.
+ * Returns 0 on success, exit code on error
+ */
+static int finish(disc_info_t *disc, const options_t *opts, void *ctx)
+{
+    const template_t *tpl = ctx;
+
+    int ret = calculate_ids(disc, opts->mode, opts->quiet);
+    if (ret != 0) {
+        cdtext_free(&disc->cdtext);
+        return ret;
+    }
+
+    /* Local AccurateRip lookup: no network, just the mapped dBAR file */
+    ardb_t ardb = { 0 };
+    if (opts->ar_db) {
+        ret = ardb_open(&ardb, opts->ar_db, disc->ids.accuraterip, opts->verbosity);
+        if (ret != 0) {
+            cdtext_free(&disc->cdtext);
+            return ret;
+        }
+    }
+
+    /* One disc of a changer batch: label it in text output */
+    if (disc->slot > 0 && opts->output == OUTPUT_TEXT && !opts->format) {
+        output_slot_header(disc->slot);
+    }
+
+    /* Structured record or template: the whole disc, whatever the mode read */
+    if (opts->output != OUTPUT_TEXT || opts->format) {
+        ret = opts->format ? template_output(tpl, disc) : record_output(disc, opts->output);
+        if (ret != 0) {
+            ardb_close(&ardb);
+            cdtext_free(&disc->cdtext);
+            return ret;
+        }
+    } else {
+        /* Generate output based on mode */
+        switch (opts->mode) {
+        case MODE_TYPE:
+            output_type(disc);
+            break;
+
+        case MODE_TEXT:
+            output_text(disc);
+            break;
+
+        case MODE_MCN:
+            output_mcn(disc);
+            break;
+
+        case MODE_ISRC:
+            if (disc->has_checks)
+                output_isrc_checks(disc);
+            else
+                output_isrc(disc);
+            break;
+
+        case MODE_GAPS:
+            output_gaps(disc);
+            break;
+
+        case MODE_CUE:
+            output_cue(disc);
+            break;
+
+        case MODE_CRC:
+            output_crc(disc, opts->ar_db ? &ardb : NULL);
+            break;
+
+        case MODE_RAW:
+            output_raw_toc(&disc->toc);
+            break;
+
+        case MODE_ACCURATERIP:
+            if (opts->actions & ACTION_TOC)
+                output_accuraterip_toc(&disc->toc);
+            if (opts->actions & ACTION_ID)
+                output_accuraterip_id(disc->ids.accuraterip);
+            if (opts->ar_db)
+                output_ardb(&ardb);
+            break;
+
+        case MODE_FREEDB:
+            if (opts->actions & ACTION_TOC)
+                output_freedb_toc(&disc->toc);
+            if (opts->actions & ACTION_ID)
+                output_freedb_id(disc->ids.freedb);
+            break;
+
+        case MODE_MUSICBRAINZ:
+            if (opts->actions & ACTION_TOC)
+                output_musicbrainz_toc(&disc->toc);
+            if (opts->actions & ACTION_ID)
+                output_musicbrainz_id(disc->ids.musicbrainz);
+            if (opts->actions & ACTION_URL) {
+                char *url = get_musicbrainz_url(disc->ids.musicbrainz);
+                output_musicbrainz_url(url);
+                free(url);
+            }
+            if (opts->actions & ACTION_OPEN) {
+                char *url = get_musicbrainz_url(disc->ids.musicbrainz);
+                output_open_url(url);
+                free(url);
+            }
+            break;
+
+        case MODE_ALL:
+            output_all(disc, opts);
+            break;
+
+        default:
+            /* Should not reach here after cli_apply_defaults */
+            output_musicbrainz_id(disc->ids.musicbrainz);
+            break;
+        }
+    }
+
+    /* Cleanup */
+    ardb_close(&ardb);
+    cdtext_free(&disc->cdtext);
+
+    /* Verification fails unless every checked track matched */
+    if (disc->has_checks) {
+        int checked = 0, failed = 0;
+        for (int i = 0; i < disc->toc.track_count; i++) {
+            if (disc->checks[i].expected[0] != '\0') {
+                checked++;
+                if (disc->checks[i].verdict != ISRC_MATCH)
+                    failed++;
+            }
+        }
+        if (failed > 0) {
+            error_quiet(opts->quiet, "isrc: %d of %d tracks not verified", failed, checked);
+            return EX_DATAERR;
+        }
+    }
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     options_t opts;
@@ -112,7 +295,7 @@ int main(int argc, char **argv)
     }
 
     if (opts.list_drives) {
-        return device_list_drives();
+        return device_list_drives(opts.media, opts.verbosity);
     }
 
     /* Validate options */
@@ -124,9 +307,26 @@ int main(int argc, char **argv)
     /* Apply defaults */
     cli_apply_defaults(&opts);
 
+    /* Compile the template before any disc is read */
+    template_t tpl = { 0 };
+    if (opts.format) {
+        ret = template_compile(&tpl, opts.format, opts.quiet);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    /* Archived CD-Text: no disc or TOC involved */
+    if (opts.mode == MODE_TEXT_FILES) {
+        return textfiles_run(opts.files, opts.file_count, opts.quiet, opts.verbosity);
+    }
+
     disc_info_t disc;
     memset(&disc, 0, sizeof(disc));
 
+    /* Cycle timing for --eject-when-done */
+    double cycle_start = monotonic_seconds(), read_end = 0, eject_end = 0;
+
     if (opts.calculate) {
         /* Calculate from TOC string */
         const char *toc_str = opts.cdtoc;
@@ -178,10 +378,6 @@ int main(int argc, char **argv)
         }
 
         disc.type = toc_get_disc_type(&disc.toc);
-        ret = calculate_ids(&disc, opts.mode, opts.quiet);
-        if (ret != 0) {
-            return ret;
-        }
     } else {
         /* Read from device */
         const char *device = opts.device;
@@ -191,90 +387,84 @@ int main(int argc, char **argv)
         if (opts.mode == MODE_MCN || opts.mode == MODE_ALL) {
             flags |= READ_MCN;
         }
-        if (opts.mode == MODE_ISRC || opts.mode == MODE_ALL) {
+        if ((opts.mode == MODE_ISRC && !opts.expect) || opts.mode == MODE_ALL) {
             flags |= READ_ISRC;
         }
         if (opts.mode == MODE_TEXT || opts.mode == MODE_ALL) {
             flags |= READ_CDTEXT;
         }
+        if (opts.mode == MODE_GAPS) {
+            flags |= READ_INDEXES;
+        }
+        if (opts.mode == MODE_CUE) {
+            /* Everything the sheet needs, read once */
+            flags |= READ_ALL | READ_INDEXES;
+        }
 
-        ret = device_read_disc(device, &disc, flags, opts.verbosity);
-        if (ret != 0) {
-            return ret;
+        if (opts.isrc_profile) {
+            ret = device_set_isrc_profile(opts.isrc_profile);
+            if (ret != 0) {
+                return ret;
+            }
         }
 
-        ret = calculate_ids(&disc, opts.mode, opts.quiet);
-        if (ret != 0) {
-            cdtext_free(&disc.cdtext);
+        /* A changer batch: every disc is read, processed and printed in turn */
+        if (opts.changer) {
+            if (opts.exclusive && opts.drive) {
+                device_quiesce(opts.drive, opts.verbosity);
+            }
+            ret = device_read_changer(flags, &opts, acquire, finish, &tpl);
+            if (opts.exclusive) {
+                device_resume();
+            }
+            template_free(&tpl);
             return ret;
         }
-    }
 
-    /* Generate output based on mode */
-    switch (opts.mode) {
-    case MODE_TYPE:
-        output_type(&disc);
-        break;
-
-    case MODE_TEXT:
-        output_text(&disc);
-        break;
-
-    case MODE_MCN:
-        output_mcn(&disc);
-        break;
-
-    case MODE_ISRC:
-        output_isrc(&disc);
-        break;
-
-    case MODE_RAW:
-        output_raw_toc(&disc.toc);
-        break;
-
-    case MODE_ACCURATERIP:
-        if (opts.actions & ACTION_TOC)
-            output_accuraterip_toc(&disc.toc);
-        if (opts.actions & ACTION_ID)
-            output_accuraterip_id(disc.ids.accuraterip);
-        break;
-
-    case MODE_FREEDB:
-        if (opts.actions & ACTION_TOC)
-            output_freedb_toc(&disc.toc);
-        if (opts.actions & ACTION_ID)
-            output_freedb_id(disc.ids.freedb);
-        break;
-
-    case MODE_MUSICBRAINZ:
-        if (opts.actions & ACTION_TOC)
-            output_musicbrainz_toc(&disc.toc);
-        if (opts.actions & ACTION_ID)
-            output_musicbrainz_id(disc.ids.musicbrainz);
-        if (opts.actions & ACTION_URL) {
-            char *url = get_musicbrainz_url(disc.ids.musicbrainz);
-            output_musicbrainz_url(url);
-            free(url);
+        /* Keep udisks and the kernel's media polling out of the scans */
+        if (opts.exclusive) {
+            device_quiesce(device, opts.verbosity);
+        }
+
+        if (opts.repeat > 0) {
+            ret = device_read_repeated(device, &disc, flags, &opts, acquire);
+        } else {
+            ret = acquire(device, &disc, flags, &opts);
         }
-        if (opts.actions & ACTION_OPEN) {
-            char *url = get_musicbrainz_url(disc.ids.musicbrainz);
-            output_open_url(url);
-            free(url);
+        if (ret != 0) {
+            /* A disc that cannot be read still has to leave the drive */
+            if (opts.eject) {
+                device_eject(device, opts.verbosity);
+            }
+            return ret;
         }
-        break;
 
-    case MODE_ALL:
-        output_all(&disc, &opts);
-        break;
+        if (opts.exclusive) {
+            device_resume();
+        }
 
-    default:
-        /* Should not reach here after cli_apply_defaults */
-        output_musicbrainz_id(disc.ids.musicbrainz);
-        break;
+        /* The last drive command is done: move the tray while IDs,
+         * lookups and output are produced. A failed eject is reported
+         * but does not change the exit status */
+        read_end = monotonic_seconds();
+        if (opts.eject) {
+            device_eject(device, opts.verbosity);
+        }
+        eject_end = monotonic_seconds();
     }
 
-    /* Cleanup */
-    cdtext_free(&disc.cdtext);
+    ret = finish(&disc, &opts, &tpl);
+    template_free(&tpl);
+
+    if (opts.eject) {
+        double end = monotonic_seconds();
+        double cycle = end - cycle_start;
+        verbose(1, opts.verbosity,
+                "device: cycle %.2fs: read %.2fs, eject %.2fs, ids and output %.2fs "
+                "(%.0f discs per hour)",
+                cycle, read_end - cycle_start, eject_end - read_end, end - eject_end,
+                cycle > 0 ? 3600.0 / cycle : 0.0);
+    }
 
-    return EX_OK;
+    return ret;
 }
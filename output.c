@@ -8,6 +8,7 @@
 #include "output.h"
 #include "toc.h"
 #include "discid.h"
+#include "record.h"
 #include "util.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,6 +22,18 @@ void output_section_header(const char *name)
     printf("----- %s -----\n", name);
 }
 
+/*
+ * Print slot header for a changer batch, a blank line apart from the
+ * previous disc
+ */
+void output_slot_header(int slot)
+{
+    static bool first = true;
+
+    printf("%s===== Slot %d =====\n", first ? "" : "\n", slot);
+    first = false;
+}
+
 /*
  * Get disc type name
  */
@@ -255,6 +268,234 @@ void output_isrc(const disc_info_t *disc)
     }
 }
 
+/*
+ * Output ISRC verification (--expect)
+ */
+void output_isrc_checks(const disc_info_t *disc)
+{
+    for (int i = 0; i < disc->toc.track_count; i++) {
+        const isrc_check_t *c = &disc->checks[i];
+        if (c->expected[0] == '\0')
+            continue;
+
+        printf("%d: %s %s", disc->toc.tracks[i].number, c->expected,
+               isrc_verdict_name(c->verdict));
+        if (c->found[0] != '\0')
+            printf(" %s", c->found);
+        printf("\n");
+    }
+}
+
+/*
+ * Print one index map row
+ */
+static void output_index_row(int track, int index, int32_t start, int32_t end,
+                             const char *note)
+{
+    int m, s, f;
+    int len_m, len_s, len_f;
+
+    lba_to_msf(start + PREGAP_FRAMES, &m, &s, &f);
+    lba_to_msf(end - start, &len_m, &len_s, &len_f);
+
+    printf("%2d  %02d   %02d:%02d:%02d  %7d  %02d:%02d:%02d%s%s\n",
+           track, index, m, s, f, start, len_m, len_s, len_f,
+           note ? "  " : "", note ? note : "");
+}
+
+/*
+ * Output Gaps mode (index map)
+ */
+void output_gaps(const disc_info_t *disc)
+{
+    if (!disc->has_indexes)
+        return;
+
+    const toc_t *toc = &disc->toc;
+    const index_map_t *map = &disc->indexes;
+
+    printf("T#  I#        MSF      LBA     Length\n");
+
+    for (int i = 0; i < toc->track_count; i++) {
+        const track_t *t = &toc->tracks[i];
+        const track_index_t *ti = &map->tracks[i];
+
+        /* Track ends at the next track's INDEX 00 within a session */
+        int32_t end = toc_get_track_end(toc, i);
+        if (i + 1 < toc->track_count && toc->tracks[i + 1].session == t->session)
+            end = map->tracks[i + 1].pregap;
+
+        /* Unmapped: its INDEX 01 as the TOC has it */
+        if (!ti->mapped) {
+            output_index_row(t->number, 1, t->offset, end, "unmapped");
+            continue;
+        }
+
+        if (ti->pregap < ti->index[1]) {
+            output_index_row(t->number, 0, ti->pregap, ti->index[1],
+                             (i == 0 && map->htoa_length > 0) ? "hidden" : NULL);
+        }
+
+        for (int k = 1; k <= ti->index_count; k++) {
+            int32_t next = (k < ti->index_count) ? ti->index[k + 1] : end;
+            output_index_row(t->number, k, ti->index[k], next, NULL);
+        }
+    }
+}
+
+/*
+ * Output audio checksums
+ */
+void output_crc(const disc_info_t *disc, const ardb_t *db)
+{
+    if (!disc->has_crcs)
+        return;
+
+    printf("T#  ARv1      ARv2      CRC32%s\n", db ? "     Conf" : "");
+
+    /* Database entries are numbered by audio track */
+    int audio = 0;
+    for (int i = 0; i < disc->toc.track_count; i++) {
+        const track_crc_t *c = &disc->crcs[i];
+        if (disc->toc.tracks[i].type != TRACK_TYPE_AUDIO)
+            continue;
+
+        if (c->valid) {
+            printf("%2d  %08X  %08X  %08X", disc->toc.tracks[i].number,
+                   c->ar_v1, c->ar_v2, c->crc32);
+            if (db)
+                printf("  %4d", ardb_confidence(db, audio, c->ar_v1, c->ar_v2));
+            printf("\n");
+        }
+        audio++;
+    }
+}
+
+/*
+ * Output every pressing in a local AccurateRip database file
+ */
+void output_ardb(const ardb_t *db)
+{
+    if (!db->data)
+        return;
+
+    printf("P#  T#  Conf  CRC       Frame450\n");
+
+    for (int p = 0; p < db->pressings; p++) {
+        for (int t = 0; t < db->tracks; t++) {
+            ardb_entry_t e;
+            ardb_entry(db, p, t, &e);
+            printf("%2d  %2d  %4d  %08X  %08X\n", p + 1, t + 1, e.confidence,
+                   e.crc, e.frame450);
+        }
+    }
+}
+
+/* Name of the single image file a generated CUE sheet refers to */
+#define CUE_IMAGE_NAME "CDImage.bin"
+
+/*
+ * Print a quoted CUE command; the format has no escapes, so double
+ * quotes become single quotes and line breaks become spaces
+ */
+static void output_cue_string(const char *indent, const char *cmd, const char *value)
+{
+    if (!value || value[0] == '\0')
+        return;
+
+    printf("%s%s \"", indent, cmd);
+    for (const char *p = value; *p; p++) {
+        if (*p == '"')
+            putchar('\'');
+        else if (*p == '\n' || *p == '\r')
+            putchar(' ');
+        else
+            putchar(*p);
+    }
+    printf("\"\n");
+}
+
+/*
+ * Print a CUE INDEX line (frames relative to the image file)
+ */
+static void output_cue_index(int index, int32_t frames)
+{
+    int m, s, f;
+
+    lba_to_msf(frames, &m, &s, &f);
+    printf("    INDEX %02d %02d:%02d:%02d\n", index, m, s, f);
+}
+
+/*
+ * Output CUE sheet for a single BINARY image of the whole disc
+ * Later sessions follow the earlier ones directly in the image; the
+ * lead-out/lead-in between them is marked with REM SESSION
+ */
+void output_cue(const disc_info_t *disc)
+{
+    const toc_t *toc = &disc->toc;
+    const cdtext_t *text = disc->has_cdtext ? &disc->cdtext : NULL;
+    const index_map_t *map = disc->has_indexes ? &disc->indexes : NULL;
+
+    /* Disc scope */
+    if (text)
+        output_cue_string("", "REM GENRE", text->album.genre);
+    if (disc->ids.freedb[0] != '\0')
+        printf("REM DISCID %s\n", disc->ids.freedb);
+    printf("REM COMMENT \"mbdiscid %s\"\n", MBDISCID_VERSION);
+    if (disc->has_mcn)
+        printf("CATALOG %s\n", disc->ids.mcn);
+    if (text) {
+        output_cue_string("", "PERFORMER", text->album.albumartist);
+        output_cue_string("", "TITLE", text->album.album);
+        output_cue_string("", "SONGWRITER", text->album.lyricist);
+    }
+    printf("FILE \"%s\" BINARY\n", CUE_IMAGE_NAME);
+
+    /* Track scope; base is the disc LBA of image frame 0 for this session */
+    int32_t base = 0;
+    for (int i = 0; i < toc->track_count; i++) {
+        const track_t *t = &toc->tracks[i];
+        const track_index_t *ti = (map && map->tracks[i].mapped) ? &map->tracks[i] : NULL;
+
+        if (i > 0 && t->session != toc->tracks[i - 1].session) {
+            /* The image skips the gap from the last session's lead-out
+             * (longer after the first session) to this session's start */
+            int32_t leadout = toc_get_session_leadout(toc, toc->tracks[i - 1].session);
+            base += leadout > 0 && leadout < t->offset ? t->offset - leadout
+                                                       : SESSION_GAP_FRAMES;
+        }
+        if (toc->last_session > 1 && (i == 0 || t->session != toc->tracks[i - 1].session))
+            printf("  REM SESSION %02d\n", t->session);
+
+        printf("  TRACK %02d %s\n", t->number,
+               t->type == TRACK_TYPE_AUDIO ? "AUDIO" : "MODE1/2352");
+
+        if (t->type == TRACK_TYPE_AUDIO && (t->control & 0x0B)) {
+            printf("    FLAGS%s%s%s\n",
+                   (t->control & 0x02) ? " DCP" : "",
+                   (t->control & 0x08) ? " 4CH" : "",
+                   (t->control & 0x01) ? " PRE" : "");
+        }
+
+        if (text && t->number <= text->track_count) {
+            const cdtext_track_t *tt = &text->tracks[t->number - 1];
+            output_cue_string("    ", "TITLE", tt->title);
+            output_cue_string("    ", "PERFORMER", tt->artist);
+            output_cue_string("    ", "SONGWRITER", tt->lyricist);
+        }
+
+        if (t->isrc[0] != '\0')
+            printf("    ISRC %s\n", t->isrc);
+
+        if (ti && ti->pregap < t->offset)
+            output_cue_index(0, ti->pregap - base);
+        output_cue_index(1, t->offset - base);
+        for (int k = 2; ti && k <= ti->index_count; k++)
+            output_cue_index(k, ti->index[k] - base);
+    }
+}
+
 /*
  * Output Raw TOC
  */
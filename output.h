@@ -9,12 +9,18 @@
 #define MBDISCID_OUTPUT_H
 
 #include "types.h"
+#include "ardb.h"
 
 /*
  * Print section header (for All mode only)
  */
 void output_section_header(const char *name);
 
+/*
+ * Print the header that starts each disc of a changer batch (--changer)
+ */
+void output_slot_header(int slot);
+
 /*
  * Output functions for single-mode output (no headers)
  */
@@ -31,6 +37,21 @@ void output_mcn(const disc_info_t *disc);
 /* ISRC mode output */
 void output_isrc(const disc_info_t *disc);
 
+/* ISRC mode output with --expect: one verdict per checked track */
+void output_isrc_checks(const disc_info_t *disc);
+
+/* Gaps mode output (index map) */
+void output_gaps(const disc_info_t *disc);
+
+/* CUE sheet output */
+void output_cue(const disc_info_t *disc);
+
+/* Audio checksum output (db: AccurateRip matches, or NULL) */
+void output_crc(const disc_info_t *disc, const ardb_t *db);
+
+/* Local AccurateRip database entries */
+void output_ardb(const ardb_t *db);
+
 /* Raw TOC output */
 void output_raw_toc(const toc_t *toc);
 
@@ -0,0 +1,413 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * record.c - Structured output records (--output)
+ */
+
+#include "record.h"
+#include "toc.h"
+#include "discid.h"
+#include "util.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *isrc_verdict_name(isrc_verdict_t verdict)
+{
+    switch (verdict) {
+    case ISRC_MATCH:     return "match";
+    case ISRC_MISMATCH:  return "mismatch";
+    case ISRC_MISSING:   return "missing";
+    case ISRC_UNDECIDED: return "undecided";
+    default:             return "unchecked";
+    }
+}
+
+const char *disc_type_key(disc_type_t type)
+{
+    switch (type) {
+    case DISC_TYPE_AUDIO:    return "audio";
+    case DISC_TYPE_ENHANCED: return "enhanced";
+    case DISC_TYPE_MIXED:    return "mixed";
+    default:                 return "unknown";
+    }
+}
+
+void record_buf_init(record_buf_t *buf, size_t cap)
+{
+    buf->data = xmalloc(cap);
+    buf->len = 0;
+    buf->cap = cap;
+}
+
+static void reserve(record_buf_t *buf, size_t len)
+{
+    if (buf->len + len <= buf->cap)
+        return;
+
+    while (buf->len + len > buf->cap)
+        buf->cap *= 2;
+    buf->data = xrealloc(buf->data, buf->cap);
+}
+
+void record_buf_append(record_buf_t *buf, const char *s, size_t len)
+{
+    reserve(buf, len);
+    memcpy(buf->data + buf->len, s, len);
+    buf->len += len;
+}
+
+void record_buf_printf(record_buf_t *buf, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, args);
+    va_end(args);
+
+    if (n < 0)
+        return;
+    if ((size_t)n >= buf->cap - buf->len) {
+        reserve(buf, (size_t)n + 1);
+        va_start(args, fmt);
+        vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, args);
+        va_end(args);
+    }
+    buf->len += (size_t)n;
+}
+
+int record_buf_write(const record_buf_t *buf)
+{
+    fflush(stdout);
+
+    size_t done = 0;
+    while (done < buf->len) {
+        ssize_t n = write(STDOUT_FILENO, buf->data + done, buf->len - done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            error("output: cannot write: %s", strerror(errno));
+            return EX_IOERR;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+void record_buf_free(record_buf_t *buf)
+{
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = buf->cap = 0;
+}
+
+static size_t text_length(const char *s)
+{
+    return s ? strlen(s) : 0;
+}
+
+size_t record_estimate(const disc_info_t *disc)
+{
+    /* Fixed fields and four TOC strings, then per track */
+    size_t size = 1024 + 4 * 8 * (size_t)(disc->toc.track_count + 3);
+    size += 384 * (size_t)disc->toc.track_count;
+
+    /* CD-Text, allowing for escapes */
+    if (disc->has_cdtext) {
+        const cdtext_album_t *a = &disc->cdtext.album;
+        size_t text = text_length(a->album) + text_length(a->albumartist) +
+                      text_length(a->genre) + text_length(a->lyricist) +
+                      text_length(a->composer) + text_length(a->arranger) +
+                      text_length(a->comment);
+        for (int i = 0; i < disc->cdtext.track_count; i++) {
+            const cdtext_track_t *t = &disc->cdtext.tracks[i];
+            text += text_length(t->title) + text_length(t->artist) +
+                    text_length(t->lyricist) + text_length(t->composer) +
+                    text_length(t->arranger) + text_length(t->comment) + 64;
+        }
+        size += 2 * text;
+    }
+    return size;
+}
+
+/*
+ * JSON
+ */
+
+/* Quoted string with JSON escapes (UTF-8 passes through) */
+static void json_string(record_buf_t *buf, const char *s)
+{
+    reserve(buf, 2 + 6 * strlen(s));
+    char *p = buf->data + buf->len;
+
+    *p++ = '"';
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = (char)c;
+        } else if (c < 0x20) {
+            p += sprintf(p, "\\u%04x", c);
+        } else {
+            *p++ = (char)c;
+        }
+    }
+    *p++ = '"';
+    buf->len = (size_t)(p - buf->data);
+}
+
+/* ,"key":"value", or nothing if value is NULL or empty */
+static void json_field(record_buf_t *buf, const char *key, const char *value)
+{
+    if (!value || !value[0])
+        return;
+    record_buf_printf(buf, ",\"%s\":", key);
+    json_string(buf, value);
+}
+
+/* ,"key":"value" or ,"key":null */
+static void json_field_or_null(record_buf_t *buf, const char *key, const char *value)
+{
+    if (value && value[0]) {
+        json_field(buf, key, value);
+    } else {
+        record_buf_printf(buf, ",\"%s\":null", key);
+    }
+}
+
+static void json_toc(record_buf_t *buf, const toc_t *toc)
+{
+    char *formats[4] = {
+        toc_format_raw(toc), toc_format_musicbrainz(toc),
+        toc_format_accuraterip(toc), toc_format_freedb(toc)
+    };
+    static const char *const names[4] = { "raw", "musicbrainz", "accuraterip", "freedb" };
+
+    record_buf_append(buf, ",\"toc\":{", 8);
+    for (int i = 0; i < 4; i++) {
+        record_buf_printf(buf, "%s\"%s\":", i ? "," : "", names[i]);
+        if (formats[i])
+            json_string(buf, formats[i]);
+        else
+            record_buf_append(buf, "null", 4);
+        free(formats[i]);
+    }
+    record_buf_append(buf, "}", 1);
+}
+
+static void json_cdtext_album(record_buf_t *buf, const cdtext_album_t *a)
+{
+    size_t start = buf->len;
+
+    record_buf_append(buf, ",\"cdtext\":{", 11);
+    size_t open = buf->len;
+    json_field(buf, "album", a->album);
+    json_field(buf, "albumartist", a->albumartist);
+    json_field(buf, "genre", a->genre);
+    json_field(buf, "lyricist", a->lyricist);
+    json_field(buf, "composer", a->composer);
+    json_field(buf, "arranger", a->arranger);
+    json_field(buf, "comment", a->comment);
+
+    if (buf->len == open) {
+        buf->len = start;
+        return;
+    }
+    /* Drop the comma the first field brought */
+    memmove(buf->data + open, buf->data + open + 1, buf->len - open - 1);
+    buf->len--;
+    record_buf_append(buf, "}", 1);
+}
+
+static void json_track(record_buf_t *buf, const disc_info_t *disc, int i)
+{
+    const track_t *t = &disc->toc.tracks[i];
+
+    record_buf_printf(buf, "%s{\"number\":%d,\"session\":%d,\"type\":\"%s\","
+                      "\"offset\":%d,\"length\":%d",
+                      i ? "," : "", t->number, t->session,
+                      t->type == TRACK_TYPE_DATA ? "data" : "audio",
+                      t->offset, t->length);
+
+    if (disc->has_isrc)
+        json_field_or_null(buf, "isrc", t->isrc);
+
+    if (disc->has_indexes && disc->indexes.tracks[i].mapped) {
+        const track_index_t *x = &disc->indexes.tracks[i];
+        record_buf_printf(buf, ",\"pregap\":%d,\"indexes\":[", x->pregap);
+        for (int k = 1; k <= x->index_count; k++)
+            record_buf_printf(buf, "%s%d", k > 1 ? "," : "", x->index[k]);
+        record_buf_append(buf, "]", 1);
+    }
+
+    if (disc->has_crcs && disc->crcs[i].valid) {
+        const track_crc_t *c = &disc->crcs[i];
+        record_buf_printf(buf, ",\"ar_v1\":\"%08X\",\"ar_v2\":\"%08X\",\"crc32\":\"%08X\"",
+                          c->ar_v1, c->ar_v2, c->crc32);
+    }
+
+    if (disc->has_checks && disc->checks[i].expected[0]) {
+        const isrc_check_t *c = &disc->checks[i];
+        json_field(buf, "expected", c->expected);
+        json_field(buf, "verdict", isrc_verdict_name(c->verdict));
+        json_field(buf, "found", c->found);
+    }
+
+    if (disc->has_cdtext && i < disc->cdtext.track_count) {
+        const cdtext_track_t *x = &disc->cdtext.tracks[i];
+        json_field(buf, "title", x->title);
+        json_field(buf, "artist", x->artist);
+        json_field(buf, "lyricist", x->lyricist);
+        json_field(buf, "composer", x->composer);
+        json_field(buf, "arranger", x->arranger);
+        json_field(buf, "comment", x->comment);
+    }
+
+    record_buf_append(buf, "}", 1);
+}
+
+/*
+ * One JSON object on one line: a JSON Lines record
+ */
+static void json_record(record_buf_t *buf, const disc_info_t *disc)
+{
+    const toc_t *toc = &disc->toc;
+
+    record_buf_append(buf, "{", 1);
+    if (disc->slot > 0)
+        record_buf_printf(buf, "\"slot\":%d,", disc->slot);
+    record_buf_printf(buf, "\"type\":\"%s\",\"first_track\":%d,\"last_track\":%d,"
+                      "\"track_count\":%d,\"audio_count\":%d,\"data_count\":%d,"
+                      "\"leadout\":%d",
+                      disc_type_key(disc->type), toc->first_track, toc->last_track,
+                      toc->track_count, toc->audio_count, toc->data_count,
+                      toc->leadout);
+    json_toc(buf, toc);
+
+    record_buf_append(buf, ",\"ids\":{", 8);
+    size_t open = buf->len;
+    json_field_or_null(buf, "musicbrainz", disc->ids.musicbrainz);
+    json_field_or_null(buf, "freedb", disc->ids.freedb);
+    json_field_or_null(buf, "accuraterip", disc->ids.accuraterip);
+    memmove(buf->data + open, buf->data + open + 1, buf->len - open - 1);
+    buf->len--;
+    record_buf_append(buf, "}", 1);
+
+    if (disc->ids.musicbrainz[0]) {
+        char *url = get_musicbrainz_url(disc->ids.musicbrainz);
+        json_field(buf, "url", url);
+        free(url);
+    }
+    json_field_or_null(buf, "mcn", disc->has_mcn ? disc->ids.mcn : NULL);
+    if (disc->has_indexes)
+        record_buf_printf(buf, ",\"htoa_length\":%d", disc->indexes.htoa_length);
+    if (disc->has_cdtext)
+        json_cdtext_album(buf, &disc->cdtext.album);
+
+    record_buf_append(buf, ",\"tracks\":[", 11);
+    for (int i = 0; i < toc->track_count; i++)
+        json_track(buf, disc, i);
+    record_buf_append(buf, "]}\n", 3);
+}
+
+/*
+ * TSV
+ */
+
+/* Field with tab, newline, carriage return and backslash escaped */
+static void tsv_field(record_buf_t *buf, const char *s)
+{
+    reserve(buf, 1 + 2 * strlen(s));
+    char *p = buf->data + buf->len;
+
+    *p++ = '\t';
+    for (; *s; s++) {
+        switch (*s) {
+        case '\t': *p++ = '\\'; *p++ = 't';  break;
+        case '\n': *p++ = '\\'; *p++ = 'n';  break;
+        case '\r': *p++ = '\\'; *p++ = 'r';  break;
+        case '\\': *p++ = '\\'; *p++ = '\\'; break;
+        default:   *p++ = *s;                break;
+        }
+    }
+    buf->len = (size_t)(p - buf->data);
+}
+
+static void tsv_optional(record_buf_t *buf, const char *s)
+{
+    tsv_field(buf, s ? s : "");
+}
+
+/*
+ * One disc row, then one row per track; the first column names the row.
+ * A slot row leads each disc of a changer batch
+ */
+static void tsv_record(record_buf_t *buf, const disc_info_t *disc)
+{
+    const toc_t *toc = &disc->toc;
+    const cdtext_album_t *album = disc->has_cdtext ? &disc->cdtext.album : NULL;
+
+    if (disc->slot > 0)
+        record_buf_printf(buf, "slot\t%d\n", disc->slot);
+    record_buf_printf(buf, "disc\t%s\t%d\t%d\t%d\t%d", disc_type_key(disc->type),
+                      toc->track_count, toc->audio_count, toc->data_count, toc->leadout);
+    tsv_field(buf, disc->ids.musicbrainz);
+    tsv_field(buf, disc->ids.freedb);
+    tsv_field(buf, disc->ids.accuraterip);
+    tsv_field(buf, disc->has_mcn ? disc->ids.mcn : "");
+
+    char *raw = toc_format_raw(toc);
+    tsv_optional(buf, raw);
+    free(raw);
+
+    tsv_optional(buf, album ? album->album : NULL);
+    tsv_optional(buf, album ? album->albumartist : NULL);
+    record_buf_append(buf, "\n", 1);
+
+    for (int i = 0; i < toc->track_count; i++) {
+        const track_t *t = &toc->tracks[i];
+        const cdtext_track_t *text = disc->has_cdtext && i < disc->cdtext.track_count ?
+                                     &disc->cdtext.tracks[i] : NULL;
+
+        record_buf_printf(buf, "track\t%d\t%d\t%s\t%d\t%d", t->number, t->session,
+                          t->type == TRACK_TYPE_DATA ? "data" : "audio",
+                          t->offset, t->length);
+        tsv_field(buf, t->isrc);
+
+        if (disc->has_indexes && disc->indexes.tracks[i].mapped)
+            record_buf_printf(buf, "\t%d", disc->indexes.tracks[i].pregap);
+        else
+            record_buf_append(buf, "\t", 1);
+
+        if (disc->has_crcs && disc->crcs[i].valid)
+            record_buf_printf(buf, "\t%08X", disc->crcs[i].crc32);
+        else
+            record_buf_append(buf, "\t", 1);
+
+        const isrc_check_t *check = disc->has_checks && disc->checks[i].expected[0] ?
+                                    &disc->checks[i] : NULL;
+        tsv_field(buf, check ? isrc_verdict_name(check->verdict) : "");
+
+        tsv_optional(buf, text ? text->title : NULL);
+        tsv_optional(buf, text ? text->artist : NULL);
+        record_buf_append(buf, "\n", 1);
+    }
+}
+
+int record_output(const disc_info_t *disc, output_format_t format)
+{
+    record_buf_t buf;
+    record_buf_init(&buf, record_estimate(disc));
+
+    if (format == OUTPUT_TSV)
+        tsv_record(&buf, disc);
+    else
+        json_record(&buf, disc);
+
+    int ret = record_buf_write(&buf);
+    record_buf_free(&buf);
+    return ret;
+}
@@ -0,0 +1,54 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * record.h - Structured output records (--output)
+ */
+
+#ifndef MBDISCID_RECORD_H
+#define MBDISCID_RECORD_H
+
+#include "types.h"
+#include <stddef.h>
+
+/* Output buffer: a whole record, written with a single write() */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} record_buf_t;
+
+/*
+ * Allocate a buffer of cap bytes; appends grow it if the estimate was short
+ */
+void record_buf_init(record_buf_t *buf, size_t cap);
+
+void record_buf_append(record_buf_t *buf, const char *s, size_t len);
+void record_buf_printf(record_buf_t *buf, const char *fmt, ...);
+
+/*
+ * Write the buffer to stdout (stdio is flushed first so ordering holds)
+ * Returns 0 on success, EX_IOERR on error
+ */
+int record_buf_write(const record_buf_t *buf);
+
+void record_buf_free(record_buf_t *buf);
+
+/* Verdict and disc type keys, shared by every output format */
+const char *isrc_verdict_name(isrc_verdict_t verdict);
+const char *disc_type_key(disc_type_t type);
+
+/*
+ * Bytes a record of disc is expected to need, so the buffer is
+ * allocated once
+ */
+size_t record_estimate(const disc_info_t *disc);
+
+/*
+ * Serialize disc as one record in format (OUTPUT_JSON or OUTPUT_TSV) and
+ * write it to stdout
+ * Returns 0 on success, EX_IOERR on error
+ */
+int record_output(const disc_info_t *disc, output_format_t format);
+
+#endif /* MBDISCID_RECORD_H */
@@ -0,0 +1,342 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * repeat.c - Run-to-run consistency and timing (--repeat)
+ */
+
+#include "device.h"
+#include "isrc.h"
+#include "record.h"
+#include "scsi.h"
+#include "subq.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Audio sectors read to evict the drive's read cache (about 4.7 MB) */
+#define FLUSH_SECTORS   2000
+#define FLUSH_CHUNK     25
+
+/* Longest per-run summary of a track or of the disc */
+#define SIGNATURE_SIZE  128
+
+static const char *const phase_names[PHASE_COUNT] = {
+    "toc", "mcn", "isrc", "cdtext", "indexes", "audio", "verify"
+};
+
+/* What each run produced and how long it took */
+typedef struct {
+    int runs;               /* Runs completed */
+    int failed;             /* Run that failed after the first, -1 if none */
+    int failed_ret;         /* Its exit code */
+    char *disc;             /* runs x SIGNATURE_SIZE */
+    char *tracks;           /* runs x MAX_TRACKS x SIGNATURE_SIZE */
+    double *seconds;        /* runs x (PHASE_COUNT + 1), last is the whole run */
+} record_t;
+
+static char *disc_signature(record_t *r, int run)
+{
+    return &r->disc[(size_t)run * SIGNATURE_SIZE];
+}
+
+static char *track_signature(record_t *r, int run, int track)
+{
+    return &r->tracks[((size_t)run * MAX_TRACKS + (size_t)track) * SIGNATURE_SIZE];
+}
+
+/*
+ * Summarize a run: the TOC and MCN for the disc, and per track whatever
+ * the mode read (ISRC, index map, checksum, verification verdict)
+ */
+static void record_run(record_t *r, int run, const disc_info_t *disc, int flags)
+{
+    const toc_t *toc = &disc->toc;
+
+    /* FNV-1a over the track offsets stands in for the whole TOC */
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < toc->track_count; i++)
+        hash = (hash ^ (uint32_t)toc->tracks[i].offset) * 16777619u;
+    snprintf(disc_signature(r, run), SIGNATURE_SIZE, " toc=%d/%d/%08x%s%s",
+             toc->track_count, toc->leadout, hash,
+             (flags & READ_MCN) ? " mcn=" : "",
+             (flags & READ_MCN) ? (disc->has_mcn ? disc->ids.mcn : "-") : "");
+
+    for (int i = 0; i < toc->track_count && i < MAX_TRACKS; i++) {
+        char *sig = track_signature(r, run, i);
+        size_t len = 0;
+        sig[0] = '\0';
+
+        if (flags & READ_ISRC)
+            len += snprintf(sig + len, SIGNATURE_SIZE - len, " isrc=%s",
+                            toc->tracks[i].isrc[0] ? toc->tracks[i].isrc : "-");
+        if (disc->has_indexes && len < SIGNATURE_SIZE) {
+            const track_index_t *t = &disc->indexes.tracks[i];
+            len += snprintf(sig + len, SIGNATURE_SIZE - len, " pregap=%d",
+                            t->mapped ? t->pregap : -1);
+            for (int x = 2; x <= t->index_count && len < SIGNATURE_SIZE; x++)
+                len += snprintf(sig + len, SIGNATURE_SIZE - len, " index%02d=%d",
+                                x, t->index[x]);
+        }
+        if (disc->has_crcs && disc->crcs[i].valid && len < SIGNATURE_SIZE)
+            len += snprintf(sig + len, SIGNATURE_SIZE - len, " crc=%08X",
+                            disc->crcs[i].crc32);
+        if (disc->has_checks && disc->checks[i].expected[0] && len < SIGNATURE_SIZE)
+            snprintf(sig + len, SIGNATURE_SIZE - len, " %s",
+                     isrc_verdict_name(disc->checks[i].verdict));
+    }
+
+    double *seconds = &r->seconds[(size_t)run * (PHASE_COUNT + 1)];
+    device_phase_times(seconds);
+}
+
+/*
+ * Print how many runs agree with the most common value, listing the
+ * values when they differ
+ * Returns true if every run agreed
+ */
+static bool report_agreement(const char *what, char *const *values, int runs)
+{
+    int best = 0, best_count = 0;
+    for (int i = 0; i < runs; i++) {
+        int n = 0;
+        for (int j = 0; j < runs; j++)
+            n += strcmp(values[i], values[j]) == 0;
+        if (n > best_count) {
+            best = i;
+            best_count = n;
+        }
+    }
+
+    if (best_count == runs) {
+        fprintf(stderr, "repeat: %s: %d/%d agree:%s\n", what, runs, runs, values[best]);
+        return true;
+    }
+
+    fprintf(stderr, "repeat: %s: %d/%d agree:", what, best_count, runs);
+    for (int i = 0; i < runs; i++) {
+        bool seen = false;
+        for (int j = 0; j < i && !seen; j++)
+            seen = strcmp(values[i], values[j]) == 0;
+        if (seen)
+            continue;
+
+        int n = 0;
+        for (int j = 0; j < runs; j++)
+            n += strcmp(values[i], values[j]) == 0;
+        fprintf(stderr, "%s%s x%d", i == 0 ? "" : ",", values[i], n);
+    }
+    fprintf(stderr, "\n");
+    return false;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Nearest-rank percentile of sorted[0..n)
+ */
+static double percentile(const double *sorted, int n, int p)
+{
+    int rank = (p * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static const char *opcode_name(uint8_t opcode)
+{
+    switch (opcode) {
+    case 0x00: return "TEST UNIT READY";
+    case 0x12: return "INQUIRY";
+    case 0x42: return "READ SUB-CHANNEL";
+    case 0x43: return "READ TOC";
+    case 0x46: return "GET CONFIGURATION";
+    case 0x4A: return "GET EVENT STATUS";
+    case 0xBE: return "READ CD";
+    default:   return "command";
+    }
+}
+
+static void report_latency(void)
+{
+    const scsi_latency_t *log;
+    int count = scsi_latencies(&log);
+
+    if (count == 0) {
+        fprintf(stderr, "repeat: no SCSI commands (disc image)\n");
+        return;
+    }
+
+    double *ms = xmalloc((size_t)count * sizeof(*ms));
+    bool done[256] = { false };
+    for (int i = 0; i < count; i++) {
+        uint8_t op = log[i].opcode;
+        if (done[op])
+            continue;
+        done[op] = true;
+
+        int n = 0;
+        double sum = 0.0;
+        for (int j = i; j < count; j++) {
+            if (log[j].opcode == op) {
+                ms[n++] = log[j].ms;
+                sum += log[j].ms;
+            }
+        }
+        qsort(ms, (size_t)n, sizeof(*ms), compare_double);
+        fprintf(stderr, "repeat: %s (%02X): %d commands, mean %.2f ms, "
+                "p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                opcode_name(op), op, n, sum / n,
+                percentile(ms, n, 50), percentile(ms, n, 99), ms[n - 1]);
+    }
+    free(ms);
+}
+
+static void report(record_t *r, const toc_t *toc, const options_t *opts)
+{
+    char **values = xmalloc((size_t)r->runs * sizeof(*values));
+    double *sorted = xmalloc((size_t)r->runs * sizeof(*sorted));
+
+    /* The report goes straight to stderr; keep it after the run's log */
+    verbose_flush();
+    fprintf(stderr, "repeat: %d runs (between runs: %s)\n", r->runs,
+            opts->repeat_reset == REPEAT_RESET_FLUSH ? "session reset, drive cache flushed" :
+            opts->repeat_reset == REPEAT_RESET_SEEK ? "session reset, seek to end" :
+            "session reset");
+    if (r->failed >= 0)
+        fprintf(stderr, "repeat: run %d failed: exit %d\n", r->failed + 1, r->failed_ret);
+
+    for (int run = 0; run < r->runs; run++)
+        values[run] = disc_signature(r, run);
+    report_agreement("disc", values, r->runs);
+
+    int checked = 0, consistent = 0;
+    for (int i = 0; i < toc->track_count; i++) {
+        if (track_signature(r, 0, i)[0] == '\0')
+            continue;
+
+        char what[16];
+        snprintf(what, sizeof(what), "track %d", toc->tracks[i].number);
+        for (int run = 0; run < r->runs; run++)
+            values[run] = track_signature(r, run, i);
+        checked++;
+        consistent += report_agreement(what, values, r->runs);
+    }
+    if (checked > 0)
+        fprintf(stderr, "repeat: %d of %d tracks consistent\n", consistent, checked);
+
+    for (int p = 0; p <= PHASE_COUNT; p++) {
+        double sum = 0.0;
+        for (int run = 0; run < r->runs; run++) {
+            sorted[run] = r->seconds[(size_t)run * (PHASE_COUNT + 1) + p];
+            sum += sorted[run];
+        }
+        if (sum == 0.0 && p < PHASE_COUNT)
+            continue;
+
+        qsort(sorted, (size_t)r->runs, sizeof(*sorted), compare_double);
+        fprintf(stderr, "repeat: %s%s: mean %.3fs, p50 %.3fs, p99 %.3fs\n",
+                p < PHASE_COUNT ? "phase " : "", p < PHASE_COUNT ? phase_names[p] : "run",
+                sum / r->runs, percentile(sorted, r->runs, 50),
+                percentile(sorted, r->runs, 99));
+    }
+
+    report_latency();
+    free(sorted);
+    free(values);
+}
+
+/*
+ * Start the next run from a clean slate: nothing learned by earlier
+ * runs, and with seek or flush the drive moved away from where the
+ * last run left it
+ */
+static void reset_between_runs(const char *device, const toc_t *toc,
+                               repeat_reset_t how, int verbosity)
+{
+    subq_session_reset();
+    isrc_session_reset();
+    if (how == REPEAT_RESET_NONE)
+        return;
+
+    char *dev_path = device_normalize_path(device);
+    scsi_device_t *dev = scsi_open(dev_path);
+    free(dev_path);
+    if (!dev)
+        return;
+
+    int32_t end = toc->audio_leadout > 0 ? toc->audio_leadout : toc->leadout;
+    if (how == REPEAT_RESET_FLUSH) {
+        uint8_t *buf = xmalloc((size_t)FLUSH_CHUNK * 2352);
+        int32_t lba = end - FLUSH_SECTORS > 0 ? end - FLUSH_SECTORS : 0;
+        int read = 0;
+        for (; lba + FLUSH_CHUNK <= end; lba += FLUSH_CHUNK)
+            read += scsi_read_cd_audio(dev, lba, FLUSH_CHUNK, buf);
+        free(buf);
+        verbose(2, verbosity, "repeat: flushed drive cache (%d sectors read)", read);
+    } else {
+        q_subchannel_t q;
+        scsi_read_q_subchannel_batch(dev, end - 1, 1, &q);
+        verbose(2, verbosity, "repeat: moved to LBA %d", end - 1);
+    }
+    scsi_close(dev);
+}
+
+int device_read_repeated(const char *device, disc_info_t *disc, int flags,
+                         const options_t *opts, device_acquire_fn acquire)
+{
+    record_t r;
+    r.runs = opts->repeat;
+    r.failed = -1;
+    r.failed_ret = 0;
+    r.disc = xcalloc((size_t)r.runs, SIGNATURE_SIZE);
+    r.tracks = xcalloc((size_t)r.runs * MAX_TRACKS, SIGNATURE_SIZE);
+    r.seconds = xcalloc((size_t)r.runs * (PHASE_COUNT + 1), sizeof(double));
+    disc_info_t *run_disc = xmalloc(sizeof(*run_disc));
+
+    int ret = 0;
+    scsi_record_latency(true);
+    for (int run = 0; run < r.runs; run++) {
+        disc_info_t *d = run == 0 ? disc : run_disc;
+        if (run > 0) {
+            scsi_record_latency(false);
+            reset_between_runs(device, &disc->toc, opts->repeat_reset, opts->verbosity);
+            scsi_record_latency(true);
+        }
+
+        double start = monotonic_seconds();
+        int run_ret = acquire(device, d, flags, opts);
+        double seconds = monotonic_seconds() - start;
+        if (run_ret != 0) {
+            /* The first run's output stands; the report covers the runs before */
+            if (run == 0) {
+                ret = run_ret;
+            } else {
+                r.failed = run;
+                r.failed_ret = run_ret;
+                r.runs = run;
+                cdtext_free(&run_disc->cdtext);
+            }
+            break;
+        }
+
+        record_run(&r, run, d, flags);
+        r.seconds[(size_t)run * (PHASE_COUNT + 1) + PHASE_COUNT] = seconds;
+        verbose(1, opts->verbosity, "repeat: run %d of %d: %.2fs", run + 1, r.runs, seconds);
+        if (run > 0)
+            cdtext_free(&run_disc->cdtext);
+    }
+    scsi_record_latency(false);
+
+    if (ret == 0 && !opts->quiet)
+        report(&r, &disc->toc, opts);
+
+    free(run_disc);
+    free(r.seconds);
+    free(r.tracks);
+    free(r.disc);
+    return ret;
+}
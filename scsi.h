@@ -24,8 +24,9 @@ typedef struct {
 typedef struct {
     uint8_t control;      /* Control nibble (4 bits) */
     uint8_t adr;          /* ADR nibble (4 bits) */
-    uint8_t track;        /* Track number */
-    uint8_t index;        /* Index */
+    uint8_t track;        /* Track number (ADR=1, decoded from BCD) */
+    uint8_t index;        /* Index (ADR=1, decoded from BCD) */
+    int32_t lba;          /* Absolute position if ADR=1 (AMIN/ASEC/AFRAME - 150) */
     char isrc[13];        /* ISRC if ADR=3, null-terminated */
     char mcn[14];         /* MCN if ADR=2, null-terminated */
     bool crc_valid;       /* True if CRC passed */
@@ -33,6 +34,22 @@ typedef struct {
     bool has_mcn;         /* True if ADR=2 and valid MCN present */
 } q_subchannel_t;
 
+/* Media changer element types, as numbered by READ ELEMENT STATUS */
+typedef enum {
+    CHANGER_TRANSPORT = 1,  /* Medium transport (picker) */
+    CHANGER_SLOT = 2,       /* Storage element */
+    CHANGER_PORT = 3,       /* Import/export element */
+    CHANGER_DRIVE = 4       /* Data transfer element */
+} changer_element_type_t;
+
+/* One media changer element */
+typedef struct {
+    int address;            /* Element address, as MOVE MEDIUM takes it */
+    changer_element_type_t type;
+    bool full;              /* Holds a disc */
+    int source;             /* Element the disc was moved from, -1 if unknown */
+} changer_element_t;
+
 /* Opaque SCSI device handle */
 typedef struct scsi_device scsi_device_t;
 
@@ -77,6 +94,40 @@ bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q);
  */
 int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t lba, int count, q_subchannel_t *q);
 
+/* One timed SCSI command */
+typedef struct {
+    uint8_t opcode;
+    float ms;
+} scsi_latency_t;
+
+/*
+ * Log every command's latency for the rest of the process (off by
+ * default; --repeat turns it on). scsi_latencies returns the log in
+ * command order and its length.
+ */
+void scsi_record_latency(bool on);
+int scsi_latencies(const scsi_latency_t **log);
+
+/*
+ * Read Q frames for planned ranges (ascending by lba) into the session
+ * cache ahead of scsi_read_q_subchannel_batch(), merging neighbouring
+ * ranges into one command where the drive's measured cost model says
+ * that is cheaper. Ranges not merged are left to the caller's reads.
+ * Does nothing until the drive's Q skew is known.
+ */
+void scsi_prefetch_q_subchannel(scsi_device_t *dev, const int32_t *lba,
+                                const int *count, int n);
+
+/*
+ * Q subchannel skew of the drive: some drives return Q data from a few
+ * frames after (or before) the requested LBA. The first batch read with
+ * enough position (ADR 1) frames measures it, and every later Q read on
+ * this drive in the session is corrected by it.
+ *
+ * Returns true with *skew (frames) once measured
+ */
+bool scsi_get_q_skew(scsi_device_t *dev, int *skew);
+
 /*
  * Read ISRC for a specific track using READ SUB-CHANNEL command
  * (High-level interface - drive handles subchannel reading internally)
@@ -154,4 +205,84 @@ bool scsi_read_full_toc(scsi_device_t *dev, int *first_track, int *last_track,
  */
 bool scsi_read_cdtext_raw(scsi_device_t *dev, uint8_t **data, size_t *len);
 
+/*
+ * Read CD-DA main channel data using READ CD (expected sector type CD-DA)
+ *
+ * lba: starting logical block address
+ * count: number of sectors to read (callers keep this to a few dozen;
+ *        larger transfers may exceed the host adapter limit)
+ * buf: output, must hold count * 2352 bytes of little-endian 16-bit stereo
+ *
+ * Returns number of sectors read (0 on error)
+ */
+int scsi_read_cd_audio(scsi_device_t *dev, int32_t lba, int count, uint8_t *buf);
+
+/*
+ * Report tray and media state using GET EVENT STATUS NOTIFICATION
+ * (polled, media class) and the current profile from GET CONFIGURATION
+ *
+ * present: output, true if a disc is loaded
+ * tray_open: output, true if the tray is open
+ * profile: output, MMC current profile (0x0008 = CD-ROM, 0 = none)
+ *
+ * Returns true on success, false if the drive rejected both commands
+ */
+bool scsi_get_media(scsi_device_t *dev, bool *present, bool *tray_open, int *profile);
+
+/*
+ * Unlock the tray (PREVENT ALLOW MEDIUM REMOVAL) and eject the disc
+ * (START STOP UNIT with LoEj and Immed). Returns as soon as the drive
+ * accepts the command, while the tray is still moving.
+ *
+ * Returns true on success, and for disc images (nothing to eject)
+ */
+bool scsi_eject(scsi_device_t *dev);
+
+/*
+ * Open a media changer: a SCSI generic node (/dev/sgN), read-write so
+ * that MOVE MEDIUM is allowed, or a simulated changer (.changer file,
+ * see changer_sim.h). MOVE MEDIUM waits for the move, so commands on
+ * this handle get a longer timeout. Hardware changers are supported on
+ * Linux only.
+ * Returns NULL on failure (simulator parse errors are reported)
+ */
+scsi_device_t *scsi_changer_open(const char *device);
+
+/*
+ * List the changer's elements with READ ELEMENT STATUS (all types)
+ * Returns the number of elements stored (at most max), -1 on error
+ */
+int scsi_read_element_status(scsi_device_t *dev, changer_element_t *elements, int max);
+
+/*
+ * Move a disc from one element to another with MOVE MEDIUM, using the
+ * given medium transport. Returns once the move is complete.
+ * Returns true on success
+ */
+bool scsi_move_medium(scsi_device_t *dev, int transport, int source, int destination);
+
+/*
+ * For a simulated changer, the disc image in the element at address
+ * (NULL if it is empty). NULL for hardware, whose drives are read
+ * through their own device nodes.
+ */
+const char *scsi_changer_medium(scsi_device_t *dev, int address);
+
+/*
+ * Quiesce a drive for the rest of the session (until scsi_resume):
+ * - Later scsi_open() calls open the SCSI generic node exclusively and
+ *   fail if another process holds it
+ * - In-kernel media event polling (events_poll_msecs) is suspended; the
+ *   old value is restored by scsi_resume(), at exit, or on a fatal signal
+ *
+ * Returns false if polling could not be suspended (e.g. no permission);
+ * exclusive opens still apply
+ */
+bool scsi_quiesce(const char *device, int verbosity);
+
+/*
+ * Restore media polling and end exclusive opens
+ */
+void scsi_resume(void);
+
 #endif /* MBDISCID_SCSI_H */
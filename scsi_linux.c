@@ -8,18 +8,38 @@
 #ifdef PLATFORM_LINUX
 
 #include "scsi.h"
+#include "image.h"
+#include "changer_sim.h"
+#include "subq.h"
+#include "util.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <scsi/sg.h>
+#include <dirent.h>
 
 /* SCSI commands */
 #define READ_SUBCHANNEL 0x42
 #define READ_CD         0xBE
 #define READ_TOC        0x43
+#define GET_CONFIGURATION 0x46
+#define GET_EVENT_STATUS  0x4A
+#define START_STOP_UNIT   0x1B
+#define PREVENT_ALLOW     0x1E
+#define MOVE_MEDIUM       0xA5
+#define READ_ELEMENT_STATUS 0xB8
+
+/* MMC profile reported for disc images */
+#define MMC_PROFILE_CD_ROM 0x0008
 
 /* Subchannel data format codes */
 #define SUB_Q_CHANNEL_DATA  0x00
@@ -33,24 +53,151 @@
 
 /* Timeout in milliseconds */
 #define SCSI_TIMEOUT 30000
+#define CHANGER_TIMEOUT 300000  /* MOVE MEDIUM runs until the disc is moved */
+
+/* READ ELEMENT STATUS allocation length */
+#define ELEMENT_STATUS_SIZE 65536
 
 struct scsi_device {
     int fd;
+    image_t *image;     /* Disc image backend, NULL for a drive */
+    changer_sim_t *changer; /* Simulated changer backend, NULL otherwise */
+    int timeout;        /* Command timeout in ms, 0 for SCSI_TIMEOUT */
     int verbosity;
     char error[256];
+    char path[PATH_MAX]; /* Node commands are sent to; Q cache and skew key */
+
+    /* Command latency (Welford's running mean and variance) */
+    int cmds;
+    double mean_ms;
+    double m2;
+    double max_ms;
+    double last_ms;
+
+    /* Q subchannel skew in frames, once measured or recalled */
+    bool skew_known;
+    int skew;
+
+    /* Session Q frame cache and its counts when this handle was opened */
+    subq_cache_t *cache;
+    long cache_hits, cache_misses;
 };
 
 /*
- * Decode 6-bit packed character to ASCII
- * Q-subchannel uses 6-bit encoding: 0='0', 1-9='1'-'9', 17-42='A'-'Z'
+ * Session-wide quiesce state (scsi_quiesce)
+ * Kept in static storage so the signal handler can restore it
+ */
+static struct {
+    char attr[PATH_MAX];            /* events_poll_msecs of the drive */
+    char saved[16];                 /* Value to restore */
+    size_t saved_len;
+    volatile sig_atomic_t active;   /* Polling currently suspended */
+    bool exclusive;                 /* Open the sg node with O_EXCL */
+    bool handlers;                  /* atexit/signal handlers installed */
+} quiesce;
+
+/*
+ * Command latency log (scsi_record_latency)
+ */
+static struct {
+    bool on;
+    scsi_latency_t *log;
+    int count, cap;
+} latency;
+
+static void log_latency(uint8_t opcode, double ms)
+{
+    if (!latency.on)
+        return;
+    if (latency.count == latency.cap) {
+        int cap = latency.cap ? latency.cap * 2 : 1024;
+        scsi_latency_t *log = realloc(latency.log, (size_t)cap * sizeof(*log));
+        if (!log)
+            return;
+        latency.log = log;
+        latency.cap = cap;
+    }
+    latency.log[latency.count].opcode = opcode;
+    latency.log[latency.count++].ms = (float)ms;
+}
+
+void scsi_record_latency(bool on)
+{
+    latency.on = on;
+}
+
+int scsi_latencies(const scsi_latency_t **log)
+{
+    *log = latency.log;
+    return latency.count;
+}
+
+/*
+ * Kernel name (sr0) of the block device behind a path
+ * Returns false if device is not a block device
+ */
+static bool block_name(const char *device, char *name, size_t size)
+{
+    struct stat st;
+    if (stat(device, &st) < 0 || !S_ISBLK(st.st_mode))
+        return false;
+
+    /* The sysfs link ends in the kernel name: ../../devices/.../block/sr0 */
+    char link[64], target[PATH_MAX];
+    snprintf(link, sizeof(link), "/sys/dev/block/%u:%u",
+             major(st.st_rdev), minor(st.st_rdev));
+    ssize_t len = readlink(link, target, sizeof(target) - 1);
+    if (len < 0)
+        return false;
+    target[len] = '\0';
+
+    const char *base = strrchr(target, '/');
+    base = base ? base + 1 : target;
+    return (size_t)snprintf(name, size, "%s", base) < size;
+}
+
+/*
+ * Open the SCSI generic node of a block device (/dev/sr0 -> /dev/sg0)
+ * The sr driver shares its queue with the block layer and media event
+ * polling; the sg node carries only our commands.
+ * Returns fd, or -1 (errno set) if there is no usable sg node
+ */
+static int open_sg(const char *device, char *path, size_t size)
+{
+    char name[NAME_MAX + 1], dir[NAME_MAX + 64];
+    if (!block_name(device, name, sizeof(name))) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    snprintf(dir, sizeof(dir), "/sys/class/block/%s/device/scsi_generic", name);
+    DIR *d = opendir(dir);
+    if (!d)
+        return -1;
+
+    struct dirent *e;
+    int fd = -1;
+    errno = ENOENT;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.')
+            continue;
+        if ((size_t)snprintf(path, size, "/dev/%s", e->d_name) >= size)
+            continue;
+        fd = open(path, O_RDWR | O_NONBLOCK | (quiesce.exclusive ? O_EXCL : 0));
+        break;
+    }
+    closedir(d);
+    return fd;
+}
+
+/*
+ * Pick up what earlier handles on this drive learned: Q skew and cached frames
  */
-static char decode_isrc_char(uint8_t c)
+static void attach_session(scsi_device_t *dev)
 {
-    c &= 0x3F;  /* Mask to 6 bits */
-    if (c == 0) return '0';
-    if (c >= 1 && c <= 9) return '0' + c;
-    if (c >= 17 && c <= 42) return 'A' + (c - 17);
-    return '?';  /* Invalid */
+    dev->skew_known = subq_skew_recall(dev->path, &dev->skew);
+    dev->cache = subq_cache_for(dev->path);
+    subq_cache_stats(dev->cache, &dev->cache_hits, &dev->cache_misses);
 }
 
 scsi_device_t *scsi_open(const char *device)
@@ -60,7 +207,32 @@ scsi_device_t *scsi_open(const char *device)
         return NULL;
     }
 
-    dev->fd = open(device, O_RDONLY | O_NONBLOCK);
+    /* Disc images are served from memory-mapped files */
+    if (image_is_image_path(device)) {
+        dev->fd = -1;
+        dev->image = image_open(device);
+        if (!dev->image) {
+            free(dev);
+            return NULL;
+        }
+        snprintf(dev->path, sizeof(dev->path), "%s", device);
+        attach_session(dev);
+        return dev;
+    }
+
+    /* An exclusive session must not fall back to a shared node */
+    dev->fd = open_sg(device, dev->path, sizeof(dev->path));
+    if (dev->fd < 0 && quiesce.exclusive && errno == EBUSY) {
+        snprintf(dev->error, sizeof(dev->error),
+                 "device busy: %s", device);
+        free(dev);
+        return NULL;
+    }
+
+    if (dev->fd < 0) {
+        snprintf(dev->path, sizeof(dev->path), "%s", device);
+        dev->fd = open(device, O_RDONLY | O_NONBLOCK);
+    }
     if (dev->fd < 0) {
         snprintf(dev->error, sizeof(dev->error),
                  "cannot open device: %s", device);
@@ -68,15 +240,46 @@ scsi_device_t *scsi_open(const char *device)
         return NULL;
     }
 
+    attach_session(dev);
     return dev;
 }
 
 void scsi_close(scsi_device_t *dev)
 {
+    if (dev && dev->cmds > 0 && dev->verbosity >= 1) {
+        double stddev = dev->cmds > 1 ? sqrt(dev->m2 / (dev->cmds - 1)) : 0.0;
+        char skew[32] = "";
+        if (dev->skew_known)
+            snprintf(skew, sizeof(skew), ", Q skew %+d", dev->skew);
+        verbose_log("scsi: %s: %d commands, latency mean %.2f ms, "
+                "stddev %.2f ms, max %.2f ms (media polling %s%s)",
+                dev->path, dev->cmds, dev->mean_ms, stddev, dev->max_ms,
+                quiesce.active ? "suspended" : "active", skew);
+    }
+
+    long hits, misses;
+    subq_cache_stats(dev ? dev->cache : NULL, &hits, &misses);
+    hits -= dev ? dev->cache_hits : 0;
+    misses -= dev ? dev->cache_misses : 0;
+    if (dev && dev->verbosity >= 1 && hits + misses > 0) {
+        verbose_log("scsi: %s: Q cache %ld hits, %ld misses (%.0f%%)",
+                dev->path, hits, misses, 100.0 * hits / (hits + misses));
+    }
+
+    subq_cost_t cost;
+    if (dev && dev->verbosity >= 1 && subq_cache_cost(dev->cache, &cost)) {
+        verbose_log("scsi: %s: Q read cost %.2f ms per command, %.3f ms per frame, "
+                "%.3f ms per 100 frames seek (%d reads, %d ranges coalesced)",
+                dev->path, cost.command_ms, cost.frame_ms, cost.seek_ms,
+                cost.reads, cost.coalesced);
+    }
+
     if (dev) {
         if (dev->fd >= 0) {
             close(dev->fd);
         }
+        image_close(dev->image);
+        changer_sim_close(dev->changer);
         free(dev);
     }
 }
@@ -107,14 +310,27 @@ static int scsi_cmd(scsi_device_t *dev,
     io_hdr.interface_id = 'S';
     io_hdr.cmd_len = cdb_len;
     io_hdr.mx_sb_len = sense_len;
-    io_hdr.dxfer_direction = SG_DXFER_FROM_DEV;
+    io_hdr.dxfer_direction = buf_len > 0 ? SG_DXFER_FROM_DEV : SG_DXFER_NONE;
     io_hdr.dxfer_len = buf_len;
     io_hdr.dxferp = buf;
     io_hdr.cmdp = cdb;
     io_hdr.sbp = sense;
-    io_hdr.timeout = SCSI_TIMEOUT;
-
-    if (ioctl(dev->fd, SG_IO, &io_hdr) < 0) {
+    io_hdr.timeout = dev->timeout > 0 ? dev->timeout : SCSI_TIMEOUT;
+
+    double start = monotonic_seconds();
+    int rc = ioctl(dev->fd, SG_IO, &io_hdr);
+    double ms = (monotonic_seconds() - start) * 1e3;
+
+    double delta = ms - dev->mean_ms;
+    dev->cmds++;
+    dev->mean_ms += delta / dev->cmds;
+    dev->m2 += delta * (ms - dev->mean_ms);
+    if (ms > dev->max_ms)
+        dev->max_ms = ms;
+    dev->last_ms = ms;
+    log_latency(cdb[0], ms);
+
+    if (rc < 0) {
         snprintf(dev->error, sizeof(dev->error), "SG_IO ioctl failed");
         return -1;
     }
@@ -133,12 +349,16 @@ static int scsi_cmd(scsi_device_t *dev,
 /*
  * Read raw Q-subchannel data at a specific LBA using READ CD command
  */
-bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
+static bool read_q_frame(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
 {
     unsigned char cdb[12];
     unsigned char buf[16];  /* Formatted Q subchannel = 16 bytes */
     unsigned char sense[32];
 
+    if (dev && dev->image) {
+        return image_read_q_batch(dev->image, lba, 1, q) == 1;
+    }
+
     memset(q, 0, sizeof(*q));
 
     if (!dev || dev->fd < 0) {
@@ -165,150 +385,23 @@ bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
         return false;
     }
 
-    /* Extract control and ADR */
-    q->control = (buf[0] >> 4) & 0x0F;
-    q->adr = buf[0] & 0x0F;
-
-    /* For formatted Q, there's no CRC - assume valid if we got data */
-    q->crc_valid = (buf[0] != 0 || buf[1] != 0);
-
-    /* Decode based on ADR mode */
-    switch (q->adr) {
-    case 1:
-        /* Mode 1: Position data */
-        q->track = buf[1];
-        q->index = buf[2];
-        q->has_isrc = false;
-        q->has_mcn = false;
-        break;
-
-    case 2:
-        /* Mode 2: MCN - decode from BCD in bytes 1-7 */
-        q->mcn[0] = '0' + ((buf[1] >> 4) & 0x0F);
-        q->mcn[1] = '0' + (buf[1] & 0x0F);
-        q->mcn[2] = '0' + ((buf[2] >> 4) & 0x0F);
-        q->mcn[3] = '0' + (buf[2] & 0x0F);
-        q->mcn[4] = '0' + ((buf[3] >> 4) & 0x0F);
-        q->mcn[5] = '0' + (buf[3] & 0x0F);
-        q->mcn[6] = '0' + ((buf[4] >> 4) & 0x0F);
-        q->mcn[7] = '0' + (buf[4] & 0x0F);
-        q->mcn[8] = '0' + ((buf[5] >> 4) & 0x0F);
-        q->mcn[9] = '0' + (buf[5] & 0x0F);
-        q->mcn[10] = '0' + ((buf[6] >> 4) & 0x0F);
-        q->mcn[11] = '0' + (buf[6] & 0x0F);
-        q->mcn[12] = '0' + ((buf[7] >> 4) & 0x0F);
-        q->mcn[13] = '\0';
-        q->has_mcn = true;
-        q->has_isrc = false;
-        break;
-
-    case 3:
-        /* Mode 3: ISRC - decode from 6-bit packed + BCD */
-        q->isrc[0] = decode_isrc_char(buf[1] >> 2);
-        q->isrc[1] = decode_isrc_char(((buf[1] & 0x03) << 4) | (buf[2] >> 4));
-        q->isrc[2] = decode_isrc_char(((buf[2] & 0x0F) << 2) | (buf[3] >> 6));
-        q->isrc[3] = decode_isrc_char(buf[3] & 0x3F);
-        q->isrc[4] = decode_isrc_char(buf[4] >> 2);
-        q->isrc[5] = '0' + ((buf[5] >> 4) & 0x0F);
-        q->isrc[6] = '0' + (buf[5] & 0x0F);
-        q->isrc[7] = '0' + ((buf[6] >> 4) & 0x0F);
-        q->isrc[8] = '0' + (buf[6] & 0x0F);
-        q->isrc[9] = '0' + ((buf[7] >> 4) & 0x0F);
-        q->isrc[10] = '0' + (buf[7] & 0x0F);
-        q->isrc[11] = '0' + ((buf[8] >> 4) & 0x0F);
-        q->isrc[12] = '\0';
-        q->has_isrc = true;
-        q->has_mcn = false;
-        break;
-
-    default:
-        q->has_isrc = false;
-        q->has_mcn = false;
-        break;
-    }
-
+    subq_decode_formatted(buf, q);
     return true;
 }
 
-/*
- * Decode a single 16-byte formatted Q-subchannel buffer into q_subchannel_t
- */
-static void decode_q_buffer(const uint8_t *buf, q_subchannel_t *q)
-{
-    memset(q, 0, sizeof(*q));
-
-    /* Extract control and ADR */
-    q->control = (buf[0] >> 4) & 0x0F;
-    q->adr = buf[0] & 0x0F;
-
-    /* For formatted Q, there's no CRC - assume valid if we got data */
-    q->crc_valid = (buf[0] != 0 || buf[1] != 0);
-
-    /* Decode based on ADR mode */
-    switch (q->adr) {
-    case 1:
-        /* Mode 1: Position data */
-        q->track = buf[1];
-        q->index = buf[2];
-        q->has_isrc = false;
-        q->has_mcn = false;
-        break;
-
-    case 2:
-        /* Mode 2: MCN - decode from BCD in bytes 1-7 */
-        q->mcn[0] = '0' + ((buf[1] >> 4) & 0x0F);
-        q->mcn[1] = '0' + (buf[1] & 0x0F);
-        q->mcn[2] = '0' + ((buf[2] >> 4) & 0x0F);
-        q->mcn[3] = '0' + (buf[2] & 0x0F);
-        q->mcn[4] = '0' + ((buf[3] >> 4) & 0x0F);
-        q->mcn[5] = '0' + (buf[3] & 0x0F);
-        q->mcn[6] = '0' + ((buf[4] >> 4) & 0x0F);
-        q->mcn[7] = '0' + (buf[4] & 0x0F);
-        q->mcn[8] = '0' + ((buf[5] >> 4) & 0x0F);
-        q->mcn[9] = '0' + (buf[5] & 0x0F);
-        q->mcn[10] = '0' + ((buf[6] >> 4) & 0x0F);
-        q->mcn[11] = '0' + (buf[6] & 0x0F);
-        q->mcn[12] = '0' + ((buf[7] >> 4) & 0x0F);
-        q->mcn[13] = '\0';
-        q->has_mcn = true;
-        q->has_isrc = false;
-        break;
-
-    case 3:
-        /* Mode 3: ISRC - decode from 6-bit packed + BCD */
-        q->isrc[0] = decode_isrc_char(buf[1] >> 2);
-        q->isrc[1] = decode_isrc_char(((buf[1] & 0x03) << 4) | (buf[2] >> 4));
-        q->isrc[2] = decode_isrc_char(((buf[2] & 0x0F) << 2) | (buf[3] >> 6));
-        q->isrc[3] = decode_isrc_char(buf[3] & 0x3F);
-        q->isrc[4] = decode_isrc_char(buf[4] >> 2);
-        q->isrc[5] = '0' + ((buf[5] >> 4) & 0x0F);
-        q->isrc[6] = '0' + (buf[5] & 0x0F);
-        q->isrc[7] = '0' + ((buf[6] >> 4) & 0x0F);
-        q->isrc[8] = '0' + (buf[6] & 0x0F);
-        q->isrc[9] = '0' + ((buf[7] >> 4) & 0x0F);
-        q->isrc[10] = '0' + (buf[7] & 0x0F);
-        q->isrc[11] = '0' + ((buf[8] >> 4) & 0x0F);
-        q->isrc[12] = '\0';
-        q->has_isrc = true;
-        q->has_mcn = false;
-        break;
-
-    default:
-        q->has_isrc = false;
-        q->has_mcn = false;
-        break;
-    }
-}
-
 /*
  * Read multiple Q-subchannel frames in a single SCSI command
  * Returns number of frames successfully read
  */
-int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t lba, int count, q_subchannel_t *q)
+static int read_q_batch(scsi_device_t *dev, int32_t lba, int count, q_subchannel_t *q)
 {
     unsigned char cdb[12];
     unsigned char sense[32];
 
+    if (dev && dev->image) {
+        return image_read_q_batch(dev->image, lba, count, q);
+    }
+
     if (!dev || dev->fd < 0 || count <= 0) {
         return 0;
     }
@@ -348,10 +441,121 @@ int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t lba, int count, q_s
 
     /* Decode each frame */
     for (int i = 0; i < count; i++) {
-        decode_q_buffer(&buf[i * 16], &q[i]);
+        subq_decode_formatted(&buf[i * 16], &q[i]);
     }
 
     free(buf);
+    subq_cache_observe(dev->cache, lba, count, dev->last_ms);
+    return count;
+}
+
+/*
+ * Cache reader: frames for logical lba, corrected by the known skew
+ */
+static int read_q_corrected(void *ctx, int32_t lba, int count, q_subchannel_t *q)
+{
+    scsi_device_t *dev = ctx;
+    return read_q_batch(dev, lba - dev->skew, count, q);
+}
+
+bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
+{
+    if (dev && dev->skew_known) {
+        return subq_cache_read(dev->cache, lba, 1, q, read_q_corrected, dev) == 1;
+    }
+    return read_q_frame(dev, lba, q);
+}
+
+/*
+ * Batch reads are corrected by the drive's Q skew and served from the
+ * session cache. Until the skew is known, each batch is measured and
+ * bypasses the cache; a batch that reveals a skew is read again from
+ * the corrected position.
+ */
+int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t lba, int count, q_subchannel_t *q)
+{
+    if (!dev) {
+        return 0;
+    }
+    if (dev->skew_known) {
+        return subq_cache_read(dev->cache, lba, count, q, read_q_corrected, dev);
+    }
+
+    int got = read_q_batch(dev, lba, count, q);
+    int skew, votes, frames;
+    if (got <= 0 || !subq_measure_skew(lba, q, got, &skew, &votes, &frames)) {
+        return got;
+    }
+
+    dev->skew_known = true;
+    dev->skew = skew;
+    subq_skew_remember(dev->path, skew);
+    if (dev->verbosity >= 1) {
+        verbose_log("scsi: %s: Q skew %+d frames (%d of %d position frames)",
+                dev->path, skew, votes, frames);
+    }
+
+    if (skew != 0) {
+        return subq_cache_read(dev->cache, lba, count, q, read_q_corrected, dev);
+    }
+    subq_cache_store(dev->cache, lba, got, q);
+    return got;
+}
+
+void scsi_prefetch_q_subchannel(scsi_device_t *dev, const int32_t *lba,
+                                const int *count, int n)
+{
+    if (dev && dev->skew_known) {
+        subq_cache_prefetch(dev->cache, lba, count, n, read_q_corrected, dev);
+    }
+}
+
+bool scsi_get_q_skew(scsi_device_t *dev, int *skew)
+{
+    if (!dev || !dev->skew_known) {
+        return false;
+    }
+    *skew = dev->skew;
+    return true;
+}
+
+/*
+ * Read CD-DA sectors using READ CD
+ * Returns number of sectors read
+ */
+int scsi_read_cd_audio(scsi_device_t *dev, int32_t lba, int count, uint8_t *buf)
+{
+    unsigned char cdb[12];
+    unsigned char sense[32];
+
+    if (dev && dev->image) {
+        return image_read_cd_audio(dev->image, lba, count, buf);
+    }
+
+    if (!dev || dev->fd < 0 || count <= 0) {
+        return 0;
+    }
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = READ_CD;
+    cdb[1] = 0x04;            /* Expected sector type = CD-DA */
+    cdb[2] = (lba >> 24) & 0xFF;
+    cdb[3] = (lba >> 16) & 0xFF;
+    cdb[4] = (lba >> 8) & 0xFF;
+    cdb[5] = lba & 0xFF;
+    cdb[6] = (count >> 16) & 0xFF;  /* Transfer length MSB */
+    cdb[7] = (count >> 8) & 0xFF;
+    cdb[8] = count & 0xFF;          /* Transfer length LSB */
+    cdb[9] = 0x10;            /* User data only (2352 bytes for CD-DA) */
+    cdb[10] = 0x00;           /* No subchannel */
+
+    memset(sense, 0, sizeof(sense));
+
+    if (scsi_cmd(dev, cdb, sizeof(cdb), buf, count * RAW_SECTOR_SIZE,
+                 sense, sizeof(sense)) < 0) {
+        return 0;
+    }
+
     return count;
 }
 
@@ -364,6 +568,10 @@ bool scsi_read_isrc(scsi_device_t *dev, int track, char *isrc)
     unsigned char buf[24];  /* Response is 24 bytes for ISRC */
     unsigned char sense[32];
 
+    if (dev && dev->image) {
+        return image_read_isrc(dev->image, track, isrc);
+    }
+
     isrc[0] = '\0';
 
     if (!dev || dev->fd < 0 || track < 1 || track > 99) {
@@ -421,6 +629,10 @@ bool scsi_read_mcn(scsi_device_t *dev, char *mcn)
     unsigned char buf[24];  /* Response is 24 bytes for MCN */
     unsigned char sense[32];
 
+    if (dev && dev->image) {
+        return image_read_mcn(dev->image, mcn);
+    }
+
     mcn[0] = '\0';
 
     if (!dev || dev->fd < 0) {
@@ -479,6 +691,10 @@ bool scsi_read_toc_control(scsi_device_t *dev, int *first_track, int *last_track
     unsigned char buf[804];  /* Max: 4 header + 100 tracks * 8 bytes */
     unsigned char sense[32];
 
+    if (dev && dev->image) {
+        return image_read_toc_control(dev->image, first_track, last_track, control);
+    }
+
     if (!dev || dev->fd < 0) {
         return false;
     }
@@ -557,6 +773,11 @@ bool scsi_read_full_toc(scsi_device_t *dev, int *first_track, int *last_track,
     unsigned char buf[1104];  /* 4-byte header + up to 100 descriptors * 11 bytes */
     unsigned char sense[32];
 
+    if (dev && dev->image) {
+        return image_read_full_toc(dev->image, first_track, last_track, control,
+                                   session, offsets, session_leadouts, last_session);
+    }
+
     if (!dev || dev->fd < 0) {
         return false;
     }
@@ -676,6 +897,10 @@ bool scsi_read_cdtext_raw(scsi_device_t *dev, uint8_t **data, size_t *len)
     *data = NULL;
     *len = 0;
 
+    if (dev && dev->image) {
+        return image_read_cdtext_raw(dev->image, data, len);
+    }
+
     if (!dev || dev->fd < 0) {
         return false;
     }
@@ -764,4 +989,328 @@ bool scsi_read_cdtext_raw(scsi_device_t *dev, uint8_t **data, size_t *len)
     return true;
 }
 
+/*
+ * Read tray and media state using GET EVENT STATUS NOTIFICATION and
+ * GET CONFIGURATION
+ */
+bool scsi_get_media(scsi_device_t *dev, bool *present, bool *tray_open, int *profile)
+{
+    unsigned char cdb[10];
+    unsigned char sense[32];
+    unsigned char buf[8];
+    bool ok = false;
+
+    *present = false;
+    *tray_open = false;
+    *profile = 0;
+
+    if (dev && dev->image) {
+        *present = true;
+        *profile = MMC_PROFILE_CD_ROM;
+        return true;
+    }
+
+    if (!dev || dev->fd < 0) {
+        return false;
+    }
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = GET_EVENT_STATUS;
+    cdb[1] = 0x01;            /* Polled */
+    cdb[4] = 0x10;            /* Media event class */
+    cdb[8] = sizeof(buf);
+    memset(buf, 0, sizeof(buf));
+    memset(sense, 0, sizeof(sense));
+
+    if (scsi_cmd(dev, cdb, sizeof(cdb), buf, sizeof(buf),
+                 sense, sizeof(sense)) == 0 && !(buf[2] & 0x80)) {
+        *tray_open = (buf[5] & 0x01) != 0;
+        *present = (buf[5] & 0x02) != 0;
+        ok = true;
+    }
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = GET_CONFIGURATION;
+    cdb[8] = sizeof(buf);     /* Feature header only */
+    memset(buf, 0, sizeof(buf));
+    memset(sense, 0, sizeof(sense));
+
+    if (scsi_cmd(dev, cdb, sizeof(cdb), buf, sizeof(buf),
+                 sense, sizeof(sense)) == 0) {
+        *profile = (buf[6] << 8) | buf[7];
+        ok = true;
+    }
+
+    return ok;
+}
+
+bool scsi_eject(scsi_device_t *dev)
+{
+    unsigned char cdb[6];
+    unsigned char sense[32];
+
+    if (dev && dev->image) {
+        return true;
+    }
+
+    if (!dev || dev->fd < 0) {
+        return false;
+    }
+
+    /* Allow removal; a drive that never locked the tray may reject this */
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = PREVENT_ALLOW;
+    memset(sense, 0, sizeof(sense));
+    scsi_cmd(dev, cdb, sizeof(cdb), NULL, 0, sense, sizeof(sense));
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = START_STOP_UNIT;
+    cdb[1] = 0x01;            /* Immed: return before the tray moves */
+    cdb[4] = 0x02;            /* LoEj, Start = 0: eject */
+    memset(sense, 0, sizeof(sense));
+
+    return scsi_cmd(dev, cdb, sizeof(cdb), NULL, 0, sense, sizeof(sense)) == 0;
+}
+
+scsi_device_t *scsi_changer_open(const char *device)
+{
+    scsi_device_t *dev = calloc(1, sizeof(*dev));
+    if (!dev) {
+        return NULL;
+    }
+    dev->fd = -1;
+    snprintf(dev->path, sizeof(dev->path), "%s", device);
+
+    if (changer_sim_is_path(device)) {
+        dev->changer = changer_sim_open(device);
+        if (!dev->changer) {
+            free(dev);
+            return NULL;
+        }
+        return dev;
+    }
+
+    /* The sg driver only passes MOVE MEDIUM on a read-write handle */
+    dev->fd = open(device, O_RDWR | O_NONBLOCK);
+    if (dev->fd < 0) {
+        free(dev);
+        return NULL;
+    }
+    dev->timeout = CHANGER_TIMEOUT;
+    return dev;
+}
+
+static int be16(const unsigned char *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+int scsi_read_element_status(scsi_device_t *dev, changer_element_t *elements, int max)
+{
+    unsigned char cdb[12];
+    unsigned char sense[32];
+
+    if (dev && dev->changer) {
+        return changer_sim_read_element_status(dev->changer, elements, max);
+    }
+
+    if (!dev || dev->fd < 0) {
+        return -1;
+    }
+
+    /* Every element from address 0, all types, no volume tags */
+    unsigned char *buf = xcalloc(1, ELEMENT_STATUS_SIZE);
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = READ_ELEMENT_STATUS;
+    cdb[4] = 0xFF;
+    cdb[5] = 0xFF;
+    cdb[7] = (ELEMENT_STATUS_SIZE >> 16) & 0xFF;
+    cdb[8] = (ELEMENT_STATUS_SIZE >> 8) & 0xFF;
+    cdb[9] = ELEMENT_STATUS_SIZE & 0xFF;
+    memset(sense, 0, sizeof(sense));
+
+    if (scsi_cmd(dev, cdb, sizeof(cdb), buf, ELEMENT_STATUS_SIZE,
+                 sense, sizeof(sense)) != 0) {
+        free(buf);
+        return -1;
+    }
+
+    /* 8-byte header, then one page per element type: an 8-byte page
+     * header and fixed-length descriptors */
+    size_t avail = 8 + (((size_t)buf[5] << 16) | ((size_t)buf[6] << 8) | buf[7]);
+    const unsigned char *end = buf + (avail < ELEMENT_STATUS_SIZE ? avail : ELEMENT_STATUS_SIZE);
+    const unsigned char *page = buf + 8;
+    int n = 0;
+
+    while (page + 8 <= end && n < max) {
+        int type = page[0] & 0x0F;
+        int desc_len = be16(page + 2);
+        size_t bytes = ((size_t)page[5] << 16) | ((size_t)page[6] << 8) | page[7];
+        const unsigned char *page_end = page + 8 + bytes < end ? page + 8 + bytes : end;
+
+        if (desc_len < 12) {
+            break;
+        }
+        for (const unsigned char *d = page + 8; d + desc_len <= page_end && n < max;
+             d += desc_len) {
+            elements[n].address = be16(d);
+            elements[n].type = (changer_element_type_t)type;
+            elements[n].full = (d[2] & 0x01) != 0;
+            elements[n].source = (d[9] & 0x80) ? be16(d + 10) : -1;  /* SValid */
+            n++;
+        }
+        page = page_end;
+    }
+
+    free(buf);
+    return n;
+}
+
+bool scsi_move_medium(scsi_device_t *dev, int transport, int source, int destination)
+{
+    unsigned char cdb[12];
+    unsigned char sense[32];
+
+    if (dev && dev->changer) {
+        return changer_sim_move_medium(dev->changer, transport, source, destination,
+                                       dev->error, sizeof(dev->error));
+    }
+
+    if (!dev || dev->fd < 0) {
+        return false;
+    }
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = MOVE_MEDIUM;
+    cdb[2] = (transport >> 8) & 0xFF;
+    cdb[3] = transport & 0xFF;
+    cdb[4] = (source >> 8) & 0xFF;
+    cdb[5] = source & 0xFF;
+    cdb[6] = (destination >> 8) & 0xFF;
+    cdb[7] = destination & 0xFF;
+    memset(sense, 0, sizeof(sense));
+
+    return scsi_cmd(dev, cdb, sizeof(cdb), NULL, 0, sense, sizeof(sense)) == 0;
+}
+
+const char *scsi_changer_medium(scsi_device_t *dev, int address)
+{
+    return dev && dev->changer ? changer_sim_medium(dev->changer, address) : NULL;
+}
+
+/*
+ * Put the saved events_poll_msecs back
+ * Async-signal-safe: called from fatal signal handlers
+ */
+static void restore_polling(void)
+{
+    if (!quiesce.active)
+        return;
+    quiesce.active = 0;
+
+    int fd = open(quiesce.attr, O_WRONLY);
+    if (fd >= 0) {
+        ssize_t n = write(fd, quiesce.saved, quiesce.saved_len);
+        (void)n;
+        close(fd);
+    }
+}
+
+static void fatal_signal(int sig)
+{
+    restore_polling();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/*
+ * Restore polling on normal exit, interruption and crashes
+ * (SIGKILL cannot be caught)
+ */
+static void install_handlers(void)
+{
+    static const int sigs[] = {
+        SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGPIPE,
+        SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV
+    };
+
+    if (quiesce.handlers)
+        return;
+    quiesce.handlers = true;
+
+    atexit(restore_polling);
+    for (size_t i = 0; i < sizeof(sigs) / sizeof(sigs[0]); i++) {
+        struct sigaction sa, old;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = fatal_signal;
+        sigemptyset(&sa.sa_mask);
+        /* Leave ignored signals ignored */
+        if (sigaction(sigs[i], NULL, &old) == 0 && old.sa_handler != SIG_IGN)
+            sigaction(sigs[i], &sa, NULL);
+    }
+}
+
+bool scsi_quiesce(const char *device, int verbosity)
+{
+    char name[32];
+
+    quiesce.exclusive = true;
+
+    if (image_is_image_path(device) || !block_name(device, name, sizeof(name)))
+        return true;
+
+    snprintf(quiesce.attr, sizeof(quiesce.attr),
+             "/sys/class/block/%s/events_poll_msecs", name);
+
+    int fd = open(quiesce.attr, O_RDONLY);
+    ssize_t n = fd >= 0 ? read(fd, quiesce.saved, sizeof(quiesce.saved) - 1) : -1;
+    if (fd >= 0)
+        close(fd);
+    if (n <= 0) {
+        if (verbosity >= 1)
+            verbose_log("scsi: %s: no media polling control", name);
+        return false;
+    }
+    quiesce.saved_len = (size_t)n;
+    quiesce.saved[n] = '\0';
+
+    /* Already disabled: nothing to suspend or restore */
+    if (atoi(quiesce.saved) == 0)
+        return true;
+
+    fd = open(quiesce.attr, O_WRONLY);
+    if (fd < 0) {
+        if (verbosity >= 1)
+            verbose_log("scsi: %s: cannot suspend media polling: %s",
+                    name, strerror(errno));
+        return false;
+    }
+
+    install_handlers();
+    quiesce.active = 1;
+    if (write(fd, "0", 1) != 1) {
+        quiesce.active = 0;
+        close(fd);
+        if (verbosity >= 1)
+            verbose_log("scsi: %s: cannot suspend media polling: %s",
+                    name, strerror(errno));
+        return false;
+    }
+    close(fd);
+
+    if (verbosity >= 1) {
+        while (n > 0 && quiesce.saved[n - 1] == '\n')
+            n--;
+        verbose_log("scsi: %s: media polling suspended (was %.*s ms)",
+                name, (int)n, quiesce.saved);
+    }
+    return true;
+}
+
+void scsi_resume(void)
+{
+    restore_polling();
+    quiesce.exclusive = false;
+}
+
 #endif /* PLATFORM_LINUX */
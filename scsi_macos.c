@@ -12,11 +12,17 @@
  * - READ CD (0xBE) with formatted Q subchannel (mode 0x02)
  * - READ SUB-CHANNEL (0x42) for ISRC/MCN queries
  * - READ TOC (0x43) for CD-Text
+ *
+ * Disc images (see image.h) are served without touching IOKit.
  */
 
 #ifdef PLATFORM_MACOS
 
 #include "scsi.h"
+#include "image.h"
+#include "changer_sim.h"
+#include "subq.h"
+#include "util.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +41,13 @@
 #define READ_CD         0xBE
 #define READ_SUBCHANNEL 0x42
 #define READ_TOC        0x43
+#define GET_CONFIGURATION 0x46
+#define GET_EVENT_STATUS  0x4A
+#define START_STOP_UNIT   0x1B
+#define PREVENT_ALLOW     0x1E
+
+/* MMC profile reported for disc images */
+#define MMC_PROFILE_CD_ROM 0x0008
 
 /* Timeout in milliseconds */
 #define SCSI_TIMEOUT 30000
@@ -58,6 +71,21 @@ struct scsi_device {
     char bsd_name[64];  /* For polling on close */
     int verbosity;
 
+    /* Disc image backend, NULL for a drive */
+    image_t *image;
+
+    /* Simulated changer backend, NULL otherwise */
+    changer_sim_t *changer;
+
+    /* Q subchannel skew in frames, once measured or recalled */
+    bool skew_recalled;
+    bool skew_known;
+    int skew;
+
+    /* Session Q frame cache and its counts when this handle first used it */
+    subq_cache_t *cache;
+    long cache_hits, cache_misses;
+
     char error[256];
 };
 
@@ -136,6 +164,17 @@ scsi_device_t *scsi_open(const char *device)
     }
     dev->fd = -1;
 
+    /* Disc images are served from memory-mapped files */
+    if (image_is_image_path(device)) {
+        dev->image = image_open(device);
+        if (!dev->image) {
+            free(dev);
+            return NULL;
+        }
+        snprintf(dev->bsd_name, sizeof(dev->bsd_name), "%s", device);
+        return dev;
+    }
+
     const char *bsd_name = get_bsd_name(device);
     snprintf(dev->bsd_name, sizeof(dev->bsd_name), "/dev/%s", bsd_name);
 
@@ -387,6 +426,30 @@ void scsi_close(scsi_device_t *dev)
 {
     if (!dev) return;
 
+    long hits, misses;
+    subq_cache_stats(dev->cache, &hits, &misses);
+    hits -= dev->cache_hits;
+    misses -= dev->cache_misses;
+    if (dev->verbosity >= 1 && hits + misses > 0) {
+        verbose_log("scsi: %s: Q cache %ld hits, %ld misses (%.0f%%)",
+                dev->bsd_name, hits, misses, 100.0 * hits / (hits + misses));
+    }
+
+    subq_cost_t cost;
+    if (dev->verbosity >= 1 && subq_cache_cost(dev->cache, &cost)) {
+        verbose_log("scsi: %s: Q read cost %.2f ms per command, %.3f ms per frame, "
+                "%.3f ms per 100 frames seek (%d reads, %d ranges coalesced)",
+                dev->bsd_name, cost.command_ms, cost.frame_ms, cost.seek_ms,
+                cost.reads, cost.coalesced);
+    }
+
+    if (dev->image || dev->changer) {
+        image_close(dev->image);
+        changer_sim_close(dev->changer);
+        free(dev);
+        return;
+    }
+
     if (dev->exclusive_access && dev->taskIf) {
         (*dev->taskIf)->ReleaseExclusiveAccess(dev->taskIf);
     }
@@ -442,10 +505,10 @@ void scsi_close(scsi_device_t *dev)
         }
         if (dev->verbosity >= 1) {
             if (wait_count > 0) {
-                fprintf(stderr, "scsi: waited %d.%ds for device release\n",
+                verbose_log("scsi: waited %d.%ds for device release",
                         wait_count / 10, wait_count % 10);
             } else {
-                fprintf(stderr, "scsi: device released immediately\n");
+                verbose_log("scsi: device released immediately");
             }
         }
     }
@@ -465,6 +528,42 @@ void scsi_set_verbosity(scsi_device_t *dev, int verbosity)
     }
 }
 
+/*
+ * Command latency log (scsi_record_latency)
+ */
+static struct {
+    bool on;
+    scsi_latency_t *log;
+    int count, cap;
+} latency;
+
+static void log_latency(uint8_t opcode, double ms)
+{
+    if (!latency.on)
+        return;
+    if (latency.count == latency.cap) {
+        int cap = latency.cap ? latency.cap * 2 : 1024;
+        scsi_latency_t *log = realloc(latency.log, (size_t)cap * sizeof(*log));
+        if (!log)
+            return;
+        latency.log = log;
+        latency.cap = cap;
+    }
+    latency.log[latency.count].opcode = opcode;
+    latency.log[latency.count++].ms = (float)ms;
+}
+
+void scsi_record_latency(bool on)
+{
+    latency.on = on;
+}
+
+int scsi_latencies(const scsi_latency_t **log)
+{
+    *log = latency.log;
+    return latency.count;
+}
+
 /*
  * Execute a SCSI command
  */
@@ -496,8 +595,13 @@ static int scsi_cmd(scsi_device_t *dev,
     range.address = (IOVirtualAddress)buf;
     range.length = buf_len;
 
-    kr = (*task)->SetScatterGatherEntries(task, &range, 1, buf_len,
-                                           kSCSIDataTransfer_FromTargetToInitiator);
+    if (buf_len > 0) {
+        kr = (*task)->SetScatterGatherEntries(task, &range, 1, buf_len,
+                                               kSCSIDataTransfer_FromTargetToInitiator);
+    } else {
+        kr = (*task)->SetScatterGatherEntries(task, NULL, 0, 0,
+                                               kSCSIDataTransfer_NoDataTransfer);
+    }
     if (kr != KERN_SUCCESS) {
         (*task)->Release(task);
         snprintf(dev->error, sizeof(dev->error), "SetScatterGatherEntries failed: %d", kr);
@@ -515,7 +619,9 @@ static int scsi_cmd(scsi_device_t *dev,
     SCSI_Sense_Data senseData;
     UInt64 bytesTransferred = 0;
 
+    double start = monotonic_seconds();
     kr = (*task)->ExecuteTaskSync(task, &senseData, &taskStatus, &bytesTransferred);
+    log_latency(cdb[0], (monotonic_seconds() - start) * 1e3);
 
     (*task)->Release(task);
 
@@ -535,17 +641,18 @@ static int scsi_cmd(scsi_device_t *dev,
     return (int)bytesTransferred;
 }
 
-/* Forward declaration */
-static void parse_q_subchannel(const unsigned char *buf, q_subchannel_t *q);
-
 /*
  * Read Q subchannel at specific LBA using READ CD with formatted Q (mode 0x02)
  */
-bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
+static bool read_q_frame(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
 {
     unsigned char cdb[12];
     unsigned char buf[16];  /* Formatted Q is 16 bytes */
 
+    if (dev && dev->image) {
+        return image_read_q_batch(dev->image, lba, 1, q) == 1;
+    }
+
     memset(q, 0, sizeof(*q));
 
     if (!dev) {
@@ -571,107 +678,27 @@ bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
         return false;
     }
 
-    parse_q_subchannel(buf, q);
+    subq_decode_formatted(buf, q);
     return true;
 }
 
-/*
- * Parse a single Q subchannel frame (16 bytes) into q_subchannel_t structure
- */
-static void parse_q_subchannel(const unsigned char *buf, q_subchannel_t *q)
-{
-    memset(q, 0, sizeof(*q));
-
-    /* Extract control and ADR */
-    q->control = (buf[0] >> 4) & 0x0F;
-    q->adr = buf[0] & 0x0F;
-
-    /* For formatted Q, drive validates CRC - assume valid if we got data */
-    q->crc_valid = (buf[0] != 0 || buf[1] != 0);
-
-    /* Decode based on ADR mode */
-    switch (q->adr) {
-    case 1:
-        /* Mode 1: Position data */
-        q->track = buf[1];
-        q->index = buf[2];
-        q->has_isrc = false;
-        q->has_mcn = false;
-        break;
-
-    case 2:
-        /* Mode 2: MCN - decode from BCD in bytes 1-7 */
-        q->mcn[0] = '0' + ((buf[1] >> 4) & 0x0F);
-        q->mcn[1] = '0' + (buf[1] & 0x0F);
-        q->mcn[2] = '0' + ((buf[2] >> 4) & 0x0F);
-        q->mcn[3] = '0' + (buf[2] & 0x0F);
-        q->mcn[4] = '0' + ((buf[3] >> 4) & 0x0F);
-        q->mcn[5] = '0' + (buf[3] & 0x0F);
-        q->mcn[6] = '0' + ((buf[4] >> 4) & 0x0F);
-        q->mcn[7] = '0' + (buf[4] & 0x0F);
-        q->mcn[8] = '0' + ((buf[5] >> 4) & 0x0F);
-        q->mcn[9] = '0' + (buf[5] & 0x0F);
-        q->mcn[10] = '0' + ((buf[6] >> 4) & 0x0F);
-        q->mcn[11] = '0' + (buf[6] & 0x0F);
-        q->mcn[12] = '0' + ((buf[7] >> 4) & 0x0F);
-        q->mcn[13] = '\0';
-        q->has_mcn = true;
-        q->has_isrc = false;
-        break;
-
-    case 3:
-        /* Mode 3: ISRC - first 5 chars are 6-bit packed, rest is BCD */
-        {
-            /* Bytes 1-4 contain 5 characters in 6-bit encoding (30 bits) */
-            uint8_t c1 = (buf[1] >> 2) & 0x3F;
-            uint8_t c2 = ((buf[1] & 0x03) << 4) | ((buf[2] >> 4) & 0x0F);
-            uint8_t c3 = ((buf[2] & 0x0F) << 2) | ((buf[3] >> 6) & 0x03);
-            uint8_t c4 = buf[3] & 0x3F;
-            uint8_t c5 = (buf[4] >> 2) & 0x3F;
-
-            /* Decode 6-bit chars: 0='0', 1-9='1'-'9', 17-42='A'-'Z' */
-            #define DECODE6(c) ((c) == 0 ? '0' : ((c) <= 9 ? '0' + (c) : ((c) >= 17 && (c) <= 42 ? 'A' + (c) - 17 : '?')))
-            q->isrc[0] = DECODE6(c1);
-            q->isrc[1] = DECODE6(c2);
-            q->isrc[2] = DECODE6(c3);
-            q->isrc[3] = DECODE6(c4);
-            q->isrc[4] = DECODE6(c5);
-            #undef DECODE6
-
-            /* Remaining 7 digits are BCD */
-            q->isrc[5] = '0' + ((buf[5] >> 4) & 0x0F);
-            q->isrc[6] = '0' + (buf[5] & 0x0F);
-            q->isrc[7] = '0' + ((buf[6] >> 4) & 0x0F);
-            q->isrc[8] = '0' + (buf[6] & 0x0F);
-            q->isrc[9] = '0' + ((buf[7] >> 4) & 0x0F);
-            q->isrc[10] = '0' + (buf[7] & 0x0F);
-            q->isrc[11] = '0' + ((buf[8] >> 4) & 0x0F);
-            q->isrc[12] = '\0';
-            q->has_isrc = true;
-            q->has_mcn = false;
-        }
-        break;
-
-    default:
-        q->has_isrc = false;
-        q->has_mcn = false;
-        break;
-    }
-}
-
 /*
  * Read multiple Q subchannels in a TRUE batch using READ CD
  * This reads multiple sectors in a single SCSI command for efficiency
  */
 #define MAX_BATCH_SECTORS 75  /* ~1 second of audio, 1200 bytes of Q data */
 
-int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t start_lba,
-                                  int count, q_subchannel_t *q_array)
+static int read_q_batch(scsi_device_t *dev, int32_t start_lba,
+                        int count, q_subchannel_t *q_array)
 {
     if (!dev || count <= 0 || !q_array) {
         return 0;
     }
 
+    if (dev->image) {
+        return image_read_q_batch(dev->image, start_lba, count, q_array);
+    }
+
     int total_success = 0;
     int remaining = count;
     int32_t current_lba = start_lba;
@@ -702,14 +729,19 @@ int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t start_lba,
 
         memset(buf, 0, buf_size);
 
+        double start = monotonic_seconds();
         int result = scsi_cmd(dev, cdb, sizeof(cdb), buf, buf_size);
+        if (result >= 0) {
+            subq_cache_observe(dev->cache, current_lba, batch_count,
+                               (monotonic_seconds() - start) * 1e3);
+        }
         if (result < 0) {
             free(buf);
             /* Try to continue with smaller batches or single reads */
             if (batch_count > 1) {
                 /* Fall back to single-sector reads for this batch */
                 for (int i = 0; i < batch_count && remaining > 0; i++) {
-                    if (scsi_read_q_subchannel(dev, current_lba + i, &q_array[array_offset + i])) {
+                    if (read_q_frame(dev, current_lba + i, &q_array[array_offset + i])) {
                         total_success++;
                     }
                     remaining--;
@@ -724,7 +756,7 @@ int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t start_lba,
         /* Parse the batch results */
         int frames_returned = result / 16;
         for (int i = 0; i < frames_returned && i < batch_count; i++) {
-            parse_q_subchannel(&buf[i * 16], &q_array[array_offset + i]);
+            subq_decode_formatted(&buf[i * 16], &q_array[array_offset + i]);
             if (q_array[array_offset + i].crc_valid) {
                 total_success++;
             }
@@ -740,6 +772,146 @@ int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t start_lba,
     return total_success;
 }
 
+/*
+ * Skew and cached frames from an earlier open of the same drive
+ */
+static void recall_skew(scsi_device_t *dev)
+{
+    if (!dev->skew_recalled) {
+        dev->skew_known = subq_skew_recall(dev->bsd_name, &dev->skew);
+        dev->skew_recalled = true;
+        dev->cache = subq_cache_for(dev->bsd_name);
+        subq_cache_stats(dev->cache, &dev->cache_hits, &dev->cache_misses);
+    }
+}
+
+/*
+ * Cache reader: frames for logical lba, corrected by the known skew.
+ * read_q_batch counts CRC-valid frames, so a drive batch that returned
+ * anything fills all count frames (unread ones zeroed, CRC invalid).
+ */
+static int read_q_corrected(void *ctx, int32_t lba, int count, q_subchannel_t *q)
+{
+    scsi_device_t *dev = ctx;
+
+    if (dev->image) {
+        return image_read_q_batch(dev->image, lba - dev->skew, count, q);
+    }
+    memset(q, 0, (size_t)count * sizeof(*q));
+    return read_q_batch(dev, lba - dev->skew, count, q) > 0 ? count : 0;
+}
+
+bool scsi_read_q_subchannel(scsi_device_t *dev, int32_t lba, q_subchannel_t *q)
+{
+    if (dev) {
+        recall_skew(dev);
+    }
+    if (dev && dev->skew_known) {
+        return subq_cache_read(dev->cache, lba, 1, q, read_q_corrected, dev) == 1 &&
+               q->crc_valid;
+    }
+    return read_q_frame(dev, lba, q);
+}
+
+/*
+ * Batch reads are corrected by the drive's Q skew and served from the
+ * session cache. Until the skew is known, each batch is measured and
+ * bypasses the cache; a batch that reveals a skew is read again from
+ * the corrected position.
+ */
+int scsi_read_q_subchannel_batch(scsi_device_t *dev, int32_t start_lba,
+                                  int count, q_subchannel_t *q_array)
+{
+    if (!dev) {
+        return 0;
+    }
+    recall_skew(dev);
+    if (dev->skew_known) {
+        return subq_cache_read(dev->cache, start_lba, count, q_array,
+                               read_q_corrected, dev);
+    }
+
+    int got = read_q_batch(dev, start_lba, count, q_array);
+    int skew, votes, frames;
+    if (got <= 0 || !subq_measure_skew(start_lba, q_array, count, &skew, &votes, &frames)) {
+        return got;
+    }
+
+    dev->skew_known = true;
+    dev->skew = skew;
+    subq_skew_remember(dev->bsd_name, skew);
+    if (dev->verbosity >= 1) {
+        verbose_log("scsi: %s: Q skew %+d frames (%d of %d position frames)",
+                dev->bsd_name, skew, votes, frames);
+    }
+
+    if (skew != 0) {
+        return subq_cache_read(dev->cache, start_lba, count, q_array,
+                               read_q_corrected, dev);
+    }
+    if (got == count || dev->image) {
+        subq_cache_store(dev->cache, start_lba, got, q_array);
+    }
+    return got;
+}
+
+void scsi_prefetch_q_subchannel(scsi_device_t *dev, const int32_t *lba,
+                                const int *count, int n)
+{
+    if (!dev) {
+        return;
+    }
+    recall_skew(dev);
+    if (dev->skew_known) {
+        subq_cache_prefetch(dev->cache, lba, count, n, read_q_corrected, dev);
+    }
+}
+
+bool scsi_get_q_skew(scsi_device_t *dev, int *skew)
+{
+    if (!dev || !dev->skew_known) {
+        return false;
+    }
+    *skew = dev->skew;
+    return true;
+}
+
+/*
+ * Read CD-DA sectors using READ CD
+ * Returns number of sectors read
+ */
+int scsi_read_cd_audio(scsi_device_t *dev, int32_t lba, int count, uint8_t *buf)
+{
+    if (!dev || count <= 0 || !buf) {
+        return 0;
+    }
+
+    if (dev->image) {
+        return image_read_cd_audio(dev->image, lba, count, buf);
+    }
+
+    unsigned char cdb[12];
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = READ_CD;
+    cdb[1] = 0x04;            /* Expected sector type = CD-DA */
+    cdb[2] = (lba >> 24) & 0xFF;
+    cdb[3] = (lba >> 16) & 0xFF;
+    cdb[4] = (lba >> 8) & 0xFF;
+    cdb[5] = lba & 0xFF;
+    cdb[6] = (count >> 16) & 0xFF;  /* Transfer length MSB */
+    cdb[7] = (count >> 8) & 0xFF;
+    cdb[8] = count & 0xFF;          /* Transfer length LSB */
+    cdb[9] = 0x10;            /* User data only (2352 bytes for CD-DA) */
+    cdb[10] = 0x00;           /* No subchannel */
+
+    int result = scsi_cmd(dev, cdb, sizeof(cdb), buf, count * RAW_SECTOR_SIZE);
+    if (result < 0) {
+        return 0;
+    }
+
+    return result / RAW_SECTOR_SIZE;
+}
+
 /*
  * Read ISRC using READ SUB-CHANNEL command (0x42)
  */
@@ -752,6 +924,10 @@ bool scsi_read_isrc(scsi_device_t *dev, int track, char *isrc)
         return false;
     }
 
+    if (dev->image) {
+        return image_read_isrc(dev->image, track, isrc);
+    }
+
     isrc[0] = '\0';
 
     memset(cdb, 0, sizeof(cdb));
@@ -793,6 +969,10 @@ bool scsi_read_mcn(scsi_device_t *dev, char *mcn)
         return false;
     }
 
+    if (dev->image) {
+        return image_read_mcn(dev->image, mcn);
+    }
+
     mcn[0] = '\0';
 
     memset(cdb, 0, sizeof(cdb));
@@ -837,6 +1017,10 @@ bool scsi_read_cdtext_raw(scsi_device_t *dev, uint8_t **data, size_t *len)
         return false;
     }
 
+    if (dev->image) {
+        return image_read_cdtext_raw(dev->image, data, len);
+    }
+
     /* First, get the header to find total length */
     memset(cdb, 0, sizeof(cdb));
     cdb[0] = READ_TOC;
@@ -915,6 +1099,10 @@ bool scsi_read_toc_control(scsi_device_t *dev, int *first_track, int *last_track
         return false;
     }
 
+    if (dev->image) {
+        return image_read_toc_control(dev->image, first_track, last_track, control);
+    }
+
     memset(cdb, 0, sizeof(cdb));
     cdb[0] = READ_TOC;
     cdb[1] = 0x00;            /* LBA format */
@@ -953,4 +1141,162 @@ bool scsi_read_toc_control(scsi_device_t *dev, int *first_track, int *last_track
     return true;
 }
 
+/*
+ * Read Full TOC (format 2)
+ * Drives are read via the BSD ioctl in device.c; only images are served here.
+ */
+bool scsi_read_full_toc(scsi_device_t *dev, int *first_track, int *last_track,
+                        uint8_t *control, uint8_t *session, int32_t *offsets,
+                        int32_t *session_leadouts, int *last_session)
+{
+    if (!dev) {
+        return false;
+    }
+
+    if (dev->image) {
+        return image_read_full_toc(dev->image, first_track, last_track, control,
+                                   session, offsets, session_leadouts, last_session);
+    }
+
+    snprintf(dev->error, sizeof(dev->error), "full TOC not supported via SCSI");
+    return false;
+}
+
+/*
+ * Read tray and media state using GET EVENT STATUS NOTIFICATION and
+ * GET CONFIGURATION
+ */
+bool scsi_get_media(scsi_device_t *dev, bool *present, bool *tray_open, int *profile)
+{
+    unsigned char cdb[10];
+    unsigned char buf[8];
+    bool ok = false;
+
+    *present = false;
+    *tray_open = false;
+    *profile = 0;
+
+    if (dev && dev->image) {
+        *present = true;
+        *profile = MMC_PROFILE_CD_ROM;
+        return true;
+    }
+
+    if (!dev) {
+        return false;
+    }
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = GET_EVENT_STATUS;
+    cdb[1] = 0x01;            /* Polled */
+    cdb[4] = 0x10;            /* Media event class */
+    cdb[8] = sizeof(buf);
+    memset(buf, 0, sizeof(buf));
+
+    if (scsi_cmd(dev, cdb, sizeof(cdb), buf, sizeof(buf)) >= 0 && !(buf[2] & 0x80)) {
+        *tray_open = (buf[5] & 0x01) != 0;
+        *present = (buf[5] & 0x02) != 0;
+        ok = true;
+    }
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = GET_CONFIGURATION;
+    cdb[8] = sizeof(buf);     /* Feature header only */
+    memset(buf, 0, sizeof(buf));
+
+    if (scsi_cmd(dev, cdb, sizeof(cdb), buf, sizeof(buf)) >= 0) {
+        *profile = (buf[6] << 8) | buf[7];
+        ok = true;
+    }
+
+    return ok;
+}
+
+bool scsi_eject(scsi_device_t *dev)
+{
+    unsigned char cdb[6];
+
+    if (dev && dev->image) {
+        return true;
+    }
+
+    if (!dev) {
+        return false;
+    }
+
+    /* Allow removal; a drive that never locked the tray may reject this */
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = PREVENT_ALLOW;
+    scsi_cmd(dev, cdb, sizeof(cdb), NULL, 0);
+
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = START_STOP_UNIT;
+    cdb[1] = 0x01;            /* Immed: return before the tray moves */
+    cdb[4] = 0x02;            /* LoEj, Start = 0: eject */
+
+    return scsi_cmd(dev, cdb, sizeof(cdb), NULL, 0) >= 0;
+}
+
+/*
+ * Media changers are not MMC devices and get no authoring interface, so
+ * only the simulator is available here
+ */
+scsi_device_t *scsi_changer_open(const char *device)
+{
+    if (!changer_sim_is_path(device)) {
+        return NULL;
+    }
+
+    scsi_device_t *dev = calloc(1, sizeof(*dev));
+    if (!dev) {
+        return NULL;
+    }
+    dev->fd = -1;
+    snprintf(dev->bsd_name, sizeof(dev->bsd_name), "%s", device);
+
+    dev->changer = changer_sim_open(device);
+    if (!dev->changer) {
+        free(dev);
+        return NULL;
+    }
+    return dev;
+}
+
+int scsi_read_element_status(scsi_device_t *dev, changer_element_t *elements, int max)
+{
+    if (dev && dev->changer) {
+        return changer_sim_read_element_status(dev->changer, elements, max);
+    }
+    return -1;
+}
+
+bool scsi_move_medium(scsi_device_t *dev, int transport, int source, int destination)
+{
+    if (dev && dev->changer) {
+        return changer_sim_move_medium(dev->changer, transport, source, destination,
+                                       dev->error, sizeof(dev->error));
+    }
+    return false;
+}
+
+const char *scsi_changer_medium(scsi_device_t *dev, int address)
+{
+    return dev && dev->changer ? changer_sim_medium(dev->changer, address) : NULL;
+}
+
+/*
+ * Disk Arbitration already claims the disc exclusively and keeps other
+ * clients from polling it while a device is open
+ */
+bool scsi_quiesce(const char *device, int verbosity)
+{
+    (void)device;
+    (void)verbosity;
+    return true;
+}
+
+void scsi_resume(void)
+{
+}
+
 #endif /* PLATFORM_MACOS */
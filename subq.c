@@ -0,0 +1,572 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * subq.c - Q-subchannel frame encoding and decoding
+ */
+
+#include "subq.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Drives whose skew is remembered (one session rarely opens more) */
+#define SKEW_MEMO_SIZE 4
+
+static struct {
+    char path[256];
+    int skew;
+} skew_memo[SKEW_MEMO_SIZE];
+static int skew_memo_count;
+
+/* Cache page: frames [first, first + SUBQ_CACHE_PAGE_FRAMES) */
+typedef struct {
+    int32_t first;
+    uint64_t valid;         /* Bit per cached frame */
+    uint64_t used;          /* Last use, for eviction */
+    q_subchannel_t frames[SUBQ_CACHE_PAGE_FRAMES];
+} cache_page_t;
+
+/* Normal equations for the read cost fit (x1 = frames, x2 = distance / 100) */
+typedef struct {
+    double n, s1, s2, s11, s12, s22, sy, s1y, s2y;
+    int32_t last_end;       /* End of the previous drive read */
+    bool have_last;
+    int coalesced;
+} cost_fit_t;
+
+struct subq_cache {
+    char path[256];
+    cache_page_t *pages[SUBQ_CACHE_PAGES];
+    int page_count;
+    cache_page_t *last;     /* Most recently found page */
+    uint64_t clock;
+    long hits, misses;
+    cost_fit_t fit;
+};
+
+/* Drives with a Q frame cache */
+static subq_cache_t *caches[SKEW_MEMO_SIZE];
+static int cache_count;
+
+/*
+ * CRC-16 CCITT, bit at a time (frames are only 10 bytes)
+ */
+uint16_t subq_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc <<= 1;
+        }
+    }
+
+    return crc;
+}
+
+int subq_bcd_to_int(uint8_t bcd)
+{
+    return ((bcd >> 4) & 0x0F) * 10 + (bcd & 0x0F);
+}
+
+uint8_t subq_int_to_bcd(int value)
+{
+    if (value < 0 || value > 99)
+        return 0;
+    return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+int32_t subq_msf_to_lba(const uint8_t *msf)
+{
+    return (subq_bcd_to_int(msf[0]) * 60 + subq_bcd_to_int(msf[1])) * 75 +
+           subq_bcd_to_int(msf[2]) - 150;
+}
+
+/*
+ * Decode 6-bit packed ISRC character: 0-9 = '0'-'9', 17-42 = 'A'-'Z'
+ */
+static char decode_isrc_char(uint8_t c)
+{
+    c &= 0x3F;
+    if (c <= 9) return '0' + c;
+    if (c >= 17 && c <= 42) return 'A' + (c - 17);
+    return '?';
+}
+
+static uint8_t encode_isrc_char(char c)
+{
+    if (c >= '0' && c <= '9') return (uint8_t)(c - '0');
+    if (c >= 'A' && c <= 'Z') return (uint8_t)(c - 'A' + 17);
+    return 0;
+}
+
+/*
+ * Store the inverted CRC of the 10 data bytes in bytes 10-11
+ */
+static void finish_frame(uint8_t *raw)
+{
+    uint16_t crc = (uint16_t)~subq_crc16(raw, 10);
+    raw[10] = (crc >> 8) & 0xFF;
+    raw[11] = crc & 0xFF;
+}
+
+/*
+ * Store AFRAME (byte 9) for ADR 2/3 frames
+ */
+static void set_aframe(uint8_t *raw, int32_t abs_lba)
+{
+    int32_t msf = abs_lba + 150;
+    raw[9] = subq_int_to_bcd(msf < 0 ? 0 : msf % 75);
+}
+
+void subq_decode_raw(const uint8_t *raw, q_subchannel_t *q)
+{
+    memset(q, 0, sizeof(*q));
+
+    q->control = (raw[0] >> 4) & 0x0F;
+    q->adr = raw[0] & 0x0F;
+
+    uint16_t stored = ((uint16_t)raw[10] << 8) | raw[11];
+    uint16_t calc = (uint16_t)~subq_crc16(raw, 10);
+    q->crc_valid = (calc == stored);
+
+    switch (q->adr) {
+    case 1:
+        q->track = (uint8_t)subq_bcd_to_int(raw[1]);
+        q->index = (uint8_t)subq_bcd_to_int(raw[2]);
+        q->lba = subq_msf_to_lba(&raw[7]);
+        break;
+
+    case 2:
+        /* 13 BCD digits in bytes 1-7 (low nibble of byte 7 unused) */
+        for (int i = 0; i < 13; i++) {
+            uint8_t b = raw[1 + i / 2];
+            q->mcn[i] = '0' + ((i % 2 == 0) ? (b >> 4) : (b & 0x0F));
+        }
+        q->mcn[13] = '\0';
+        q->has_mcn = true;
+        break;
+
+    case 3:
+        q->isrc[0] = decode_isrc_char(raw[1] >> 2);
+        q->isrc[1] = decode_isrc_char(((raw[1] & 0x03) << 4) | (raw[2] >> 4));
+        q->isrc[2] = decode_isrc_char(((raw[2] & 0x0F) << 2) | (raw[3] >> 6));
+        q->isrc[3] = decode_isrc_char(raw[3] & 0x3F);
+        q->isrc[4] = decode_isrc_char(raw[4] >> 2);
+        for (int i = 0; i < 7; i++) {
+            uint8_t b = raw[5 + i / 2];
+            q->isrc[5 + i] = '0' + ((i % 2 == 0) ? (b >> 4) : (b & 0x0F));
+        }
+        q->isrc[12] = '\0';
+        q->has_isrc = true;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void subq_decode_formatted(const uint8_t *buf, q_subchannel_t *q)
+{
+    subq_decode_raw(buf, q);
+    q->crc_valid = (buf[0] != 0 || buf[1] != 0);
+}
+
+void subq_encode_position(uint8_t *raw, uint8_t control, int track, int index,
+                          int32_t rel_frames, int32_t abs_lba)
+{
+    memset(raw, 0, SUBQ_RAW_SIZE);
+
+    /* Running time counts down through a pregap, so encode its magnitude */
+    int32_t rel = rel_frames < 0 ? -rel_frames : rel_frames;
+    int32_t abs = abs_lba + 150;
+    if (abs < 0) abs = 0;
+
+    raw[0] = (uint8_t)((control << 4) | 1);
+    raw[1] = subq_int_to_bcd(track);
+    raw[2] = subq_int_to_bcd(index);
+    raw[3] = subq_int_to_bcd(rel / (60 * 75));
+    raw[4] = subq_int_to_bcd((rel / 75) % 60);
+    raw[5] = subq_int_to_bcd(rel % 75);
+    raw[7] = subq_int_to_bcd(abs / (60 * 75));
+    raw[8] = subq_int_to_bcd((abs / 75) % 60);
+    raw[9] = subq_int_to_bcd(abs % 75);
+
+    finish_frame(raw);
+}
+
+void subq_encode_mcn(uint8_t *raw, uint8_t control, const char *mcn, int32_t abs_lba)
+{
+    memset(raw, 0, SUBQ_RAW_SIZE);
+
+    raw[0] = (uint8_t)((control << 4) | 2);
+    for (int i = 0; i < 13 && mcn[i]; i++) {
+        uint8_t d = (uint8_t)(mcn[i] - '0') & 0x0F;
+        raw[1 + i / 2] |= (i % 2 == 0) ? (uint8_t)(d << 4) : d;
+    }
+    set_aframe(raw, abs_lba);
+
+    finish_frame(raw);
+}
+
+void subq_encode_isrc(uint8_t *raw, uint8_t control, const char *isrc, int32_t abs_lba)
+{
+    memset(raw, 0, SUBQ_RAW_SIZE);
+
+    uint8_t c[5];
+    for (int i = 0; i < 5; i++) {
+        c[i] = encode_isrc_char(isrc[i]);
+    }
+
+    raw[0] = (uint8_t)((control << 4) | 3);
+    raw[1] = (uint8_t)((c[0] << 2) | (c[1] >> 4));
+    raw[2] = (uint8_t)(((c[1] & 0x0F) << 4) | (c[2] >> 2));
+    raw[3] = (uint8_t)(((c[2] & 0x03) << 6) | c[3]);
+    raw[4] = (uint8_t)(c[4] << 2);
+    for (int i = 0; i < 7; i++) {
+        uint8_t d = (uint8_t)(isrc[5 + i] - '0') & 0x0F;
+        raw[5 + i / 2] |= (i % 2 == 0) ? (uint8_t)(d << 4) : d;
+    }
+    set_aframe(raw, abs_lba);
+
+    finish_frame(raw);
+}
+
+bool subq_measure_skew(int32_t lba, const q_subchannel_t *q, int count,
+                       int *skew, int *votes, int *frames)
+{
+    int hist[2 * SUBQ_MAX_SKEW + 1] = {0};
+    int total = 0, best = SUBQ_MAX_SKEW;
+
+    for (int i = 0; i < count; i++) {
+        if (!q[i].crc_valid || q[i].adr != 1)
+            continue;
+        total++;
+
+        int32_t d = q[i].lba - (lba + i);
+        if (d < -SUBQ_MAX_SKEW || d > SUBQ_MAX_SKEW)
+            continue;
+        if (++hist[d + SUBQ_MAX_SKEW] > hist[best])
+            best = (int)d + SUBQ_MAX_SKEW;
+    }
+
+    *skew = best - SUBQ_MAX_SKEW;
+    *votes = hist[best];
+    *frames = total;
+    return total >= 8 && hist[best] * 4 >= total * 3;
+}
+
+void subq_skew_remember(const char *path, int skew)
+{
+    int i = 0;
+    while (i < skew_memo_count && strcmp(skew_memo[i].path, path) != 0)
+        i++;
+    if (i == SKEW_MEMO_SIZE)
+        return;
+    if (i == skew_memo_count)
+        skew_memo_count++;
+
+    snprintf(skew_memo[i].path, sizeof(skew_memo[i].path), "%s", path);
+    skew_memo[i].skew = skew;
+}
+
+bool subq_skew_recall(const char *path, int *skew)
+{
+    for (int i = 0; i < skew_memo_count; i++) {
+        if (strcmp(skew_memo[i].path, path) == 0) {
+            *skew = skew_memo[i].skew;
+            return true;
+        }
+    }
+    return false;
+}
+
+subq_cache_t *subq_cache_for(const char *path)
+{
+    for (int i = 0; i < cache_count; i++) {
+        if (strcmp(caches[i]->path, path) == 0)
+            return caches[i];
+    }
+    if (cache_count == SKEW_MEMO_SIZE)
+        return NULL;
+
+    subq_cache_t *cache = calloc(1, sizeof(*cache));
+    if (!cache)
+        return NULL;
+    snprintf(cache->path, sizeof(cache->path), "%s", path);
+    caches[cache_count++] = cache;
+    return cache;
+}
+
+/* Start LBA of the page holding lba (rounds toward minus infinity) */
+static int32_t page_first(int32_t lba)
+{
+    int32_t r = lba % SUBQ_CACHE_PAGE_FRAMES;
+    return lba - (r < 0 ? r + SUBQ_CACHE_PAGE_FRAMES : r);
+}
+
+static cache_page_t *find_page(subq_cache_t *cache, int32_t first)
+{
+    if (cache->last && cache->last->first == first) {
+        cache->last->used = ++cache->clock;
+        return cache->last;
+    }
+    for (int i = 0; i < cache->page_count; i++) {
+        if (cache->pages[i]->first == first) {
+            cache->last = cache->pages[i];
+            cache->last->used = ++cache->clock;
+            return cache->last;
+        }
+    }
+    return NULL;
+}
+
+/* Page for first, reusing the least recently used one when full */
+static cache_page_t *add_page(subq_cache_t *cache, int32_t first)
+{
+    cache_page_t *page;
+
+    if (cache->page_count < SUBQ_CACHE_PAGES) {
+        page = malloc(sizeof(*page));
+        if (!page)
+            return NULL;
+        cache->pages[cache->page_count++] = page;
+    } else {
+        page = cache->pages[0];
+        for (int i = 1; i < cache->page_count; i++) {
+            if (cache->pages[i]->used < page->used)
+                page = cache->pages[i];
+        }
+    }
+
+    page->first = first;
+    page->valid = 0;
+    page->used = ++cache->clock;
+    return page;
+}
+
+/* Cached frame at lba, or NULL */
+static const q_subchannel_t *cache_lookup(subq_cache_t *cache, int32_t lba)
+{
+    cache_page_t *page = find_page(cache, page_first(lba));
+    int slot = lba - page_first(lba);
+
+    if (!page || !(page->valid & (UINT64_C(1) << slot)))
+        return NULL;
+    return &page->frames[slot];
+}
+
+void subq_cache_store(subq_cache_t *cache, int32_t lba, int count,
+                      const q_subchannel_t *q)
+{
+    cache_page_t *page = NULL;
+
+    if (!cache)
+        return;
+
+    cache->misses += count;
+    for (int i = 0; i < count; i++) {
+        /* A frame that failed its CRC is read again next time */
+        if (!q[i].crc_valid)
+            continue;
+
+        int32_t first = page_first(lba + i);
+        if (!page || page->first != first) {
+            page = find_page(cache, first);
+            if (!page)
+                page = add_page(cache, first);
+            if (!page)
+                return;
+        }
+
+        int slot = lba + i - first;
+        page->frames[slot] = q[i];
+        page->valid |= UINT64_C(1) << slot;
+    }
+}
+
+void subq_cache_observe(subq_cache_t *cache, int32_t lba, int count, double ms)
+{
+    if (!cache)
+        return;
+
+    cost_fit_t *f = &cache->fit;
+    if (f->have_last) {
+        double x1 = count;
+        double x2 = fabs((double)(lba - f->last_end)) / 100.0;
+        f->n += 1.0;
+        f->s1 += x1;
+        f->s2 += x2;
+        f->s11 += x1 * x1;
+        f->s12 += x1 * x2;
+        f->s22 += x2 * x2;
+        f->sy += ms;
+        f->s1y += x1 * ms;
+        f->s2y += x2 * ms;
+    }
+    f->last_end = lba + count;
+    f->have_last = true;
+}
+
+static double det3(double a, double b, double c, double d, double e, double f,
+                   double g, double h, double i)
+{
+    return a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+}
+
+bool subq_cache_cost(const subq_cache_t *cache, subq_cost_t *cost)
+{
+    memset(cost, 0, sizeof(*cost));
+    if (!cache)
+        return false;
+
+    const cost_fit_t *f = &cache->fit;
+    cost->reads = (int)f->n;
+    cost->coalesced = f->coalesced;
+    if (f->n < SUBQ_COST_MIN_READS)
+        return false;
+
+    /* All three terms when the reads varied in both size and distance */
+    double d = det3(f->n, f->s1, f->s2, f->s1, f->s11, f->s12, f->s2, f->s12, f->s22);
+    if (fabs(d) > 1e-9 * f->n * f->s11 * (f->s22 > 1.0 ? f->s22 : 1.0)) {
+        cost->command_ms = det3(f->sy, f->s1, f->s2, f->s1y, f->s11, f->s12,
+                                f->s2y, f->s12, f->s22) / d;
+        cost->frame_ms = det3(f->n, f->sy, f->s2, f->s1, f->s1y, f->s12,
+                              f->s2, f->s2y, f->s22) / d;
+        cost->seek_ms = det3(f->n, f->s1, f->sy, f->s1, f->s11, f->s1y,
+                             f->s2, f->s12, f->s2y) / d;
+    } else {
+        /* Command and frame terms only */
+        double d2 = f->n * f->s11 - f->s1 * f->s1;
+        if (fabs(d2) <= 1e-9 * f->n * f->s11)
+            return false;
+        cost->command_ms = (f->sy * f->s11 - f->s1 * f->s1y) / d2;
+        cost->frame_ms = (f->n * f->s1y - f->s1 * f->sy) / d2;
+    }
+
+    if (cost->command_ms < 0.0)
+        cost->command_ms = 0.0;
+    if (cost->frame_ms < 0.0)
+        cost->frame_ms = 0.0;
+    if (cost->seek_ms < 0.0)
+        cost->seek_ms = 0.0;
+    return true;
+}
+
+/*
+ * True if reading through gap frames beats a separate command and seek
+ */
+static bool merge_pays(const subq_cache_t *cache, int32_t gap)
+{
+    subq_cost_t cost;
+
+    if (gap <= 0)
+        return true;
+    if (!subq_cache_cost(cache, &cost))
+        return false;
+    return cost.frame_ms * gap < cost.command_ms + cost.seek_ms * gap / 100.0;
+}
+
+int subq_cache_read(subq_cache_t *cache, int32_t lba, int count,
+                    q_subchannel_t *q, subq_read_fn read, void *ctx)
+{
+    if (!cache)
+        return read(ctx, lba, count, q);
+
+    int i = 0;
+    while (i < count) {
+        const q_subchannel_t *hit = cache_lookup(cache, lba + i);
+        if (hit) {
+            q[i++] = *hit;
+            cache->hits++;
+            continue;
+        }
+
+        /* The uncached run, and any later ones worth reading through to */
+        int end = i + 1;
+        while (end < count && !cache_lookup(cache, lba + end))
+            end++;
+        while (end < count) {
+            int next = end;
+            while (next < count && cache_lookup(cache, lba + next))
+                next++;
+            if (next == count || !merge_pays(cache, next - end))
+                break;
+            end = next + 1;
+            while (end < count && !cache_lookup(cache, lba + end))
+                end++;
+        }
+
+        for (int at = i; at < end; ) {
+            int n = end - at;
+            if (n > SUBQ_MAX_READ_FRAMES)
+                n = SUBQ_MAX_READ_FRAMES;
+
+            int got = read(ctx, lba + at, n, q + at);
+            if (got > 0)
+                subq_cache_store(cache, lba + at, got, q + at);
+            if (got < n)
+                return at + (got > 0 ? got : 0);
+            at += n;
+        }
+        i = end;
+    }
+
+    return count;
+}
+
+void subq_cache_prefetch(subq_cache_t *cache, const int32_t *lba, const int *count,
+                         int n, subq_read_fn read, void *ctx)
+{
+    if (!cache)
+        return;
+
+    for (int i = 0; i < n; ) {
+        int32_t start = lba[i];
+        int32_t end = lba[i] + count[i];
+        int ranges = 1;
+        while (i + ranges < n && merge_pays(cache, lba[i + ranges] - end)) {
+            if (lba[i + ranges] + count[i + ranges] > end)
+                end = lba[i + ranges] + count[i + ranges];
+            ranges++;
+        }
+
+        bool cached = true;
+        for (int32_t at = start; at < end && cached; at++)
+            cached = cache_lookup(cache, at) != NULL;
+
+        q_subchannel_t *q = NULL;
+        if (ranges > 1 && !cached && (q = malloc((size_t)(end - start) * sizeof(*q)))) {
+            /* Only the drive reads count; the caller's reads will hit */
+            long hits = cache->hits;
+            subq_cache_read(cache, start, end - start, q, read, ctx);
+            cache->hits = hits;
+            cache->fit.coalesced += ranges - 1;
+            free(q);
+        }
+        i += ranges;
+    }
+}
+
+void subq_cache_stats(const subq_cache_t *cache, long *hits, long *misses)
+{
+    *hits = cache ? cache->hits : 0;
+    *misses = cache ? cache->misses : 0;
+}
+
+void subq_session_reset(void)
+{
+    for (int i = 0; i < cache_count; i++) {
+        for (int j = 0; j < caches[i]->page_count; j++)
+            free(caches[i]->pages[j]);
+        free(caches[i]);
+    }
+    cache_count = 0;
+    skew_memo_count = 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * subq.h - Q-subchannel frame encoding and decoding
+ *
+ * A raw Q-subchannel frame is 12 bytes: 10 data bytes followed by an
+ * inverted CRC-16 CCITT (big-endian). The data layout depends on ADR:
+ *
+ *   ADR 1 (position): CTRL/ADR TNO INDEX MIN SEC FRAME ZERO AMIN ASEC AFRAME
+ *   ADR 2 (MCN):      CTRL/ADR N1..N13 (BCD, 52 bits) ZERO AFRAME
+ *   ADR 3 (ISRC):     CTRL/ADR I1..I5 (6-bit) I6..I12 (BCD) ZERO AFRAME
+ *
+ * Time and track/index fields are BCD. This module is shared by the
+ * platform SCSI layers and the disc image backend.
+ */
+
+#ifndef MBDISCID_SUBQ_H
+#define MBDISCID_SUBQ_H
+
+#include "scsi.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* Raw Q frame size (10 data bytes + 2 CRC bytes) */
+#define SUBQ_RAW_SIZE 12
+
+/*
+ * CRC-16 CCITT (polynomial 0x1021, initial value 0) as used by the
+ * Q-subchannel and CD-Text. The stored value is the inverted CRC.
+ */
+uint16_t subq_crc16(const uint8_t *data, size_t len);
+
+/*
+ * BCD conversion helpers
+ */
+int subq_bcd_to_int(uint8_t bcd);
+uint8_t subq_int_to_bcd(int value);
+
+/*
+ * Convert a 3-byte BCD MSF (e.g. AMIN ASEC AFRAME) to an LBA
+ */
+int32_t subq_msf_to_lba(const uint8_t *msf);
+
+/*
+ * Decode a raw 12-byte Q frame, verifying its CRC
+ */
+void subq_decode_raw(const uint8_t *raw, q_subchannel_t *q);
+
+/*
+ * Decode a 16-byte formatted Q frame from READ CD (subchannel 2); drives
+ * return no trusted CRC, so any non-blank frame counts as valid
+ */
+void subq_decode_formatted(const uint8_t *buf, q_subchannel_t *q);
+
+/* Largest subchannel skew believed, in frames */
+#define SUBQ_MAX_SKEW 10
+
+/*
+ * Measure how far a batch of Q frames read from lba is shifted: the
+ * most common difference between each CRC-valid ADR 1 frame's absolute
+ * time and the LBA it was requested for (positive when the drive
+ * returns Q from later frames)
+ *
+ * Returns true with *skew set if at least 8 position frames were read
+ * and three quarters of them agree; *votes and *frames give the count
+ */
+bool subq_measure_skew(int32_t lba, const q_subchannel_t *q, int count,
+                       int *skew, int *votes, int *frames);
+
+/*
+ * Per-drive skew kept for the rest of the session, so a drive reopened
+ * for a later pass (index map, verification) starts corrected
+ * subq_skew_recall returns false if path has no recorded skew
+ */
+void subq_skew_remember(const char *path, int skew);
+bool subq_skew_recall(const char *path, int *skew);
+
+/*
+ * Q frame cache: decoded frames keyed by (skew-corrected) LBA, kept per
+ * drive for the whole session so a later pass or a re-read of the same
+ * frames does not go back to the drive. Held in pages of
+ * SUBQ_CACHE_PAGE_FRAMES; past SUBQ_CACHE_PAGES the least recently used
+ * page is dropped. Failed reads are not cached.
+ */
+#define SUBQ_CACHE_PAGE_FRAMES 64
+#define SUBQ_CACHE_PAGES       1024
+
+typedef struct subq_cache subq_cache_t;
+
+/* Reader for frames missing from the cache; returns frames read from lba */
+typedef int (*subq_read_fn)(void *ctx, int32_t lba, int count, q_subchannel_t *q);
+
+/*
+ * Cache for the drive at path, created on first use (NULL if out of memory
+ * or too many drives, in which case reads go straight to the drive)
+ */
+subq_cache_t *subq_cache_for(const char *path);
+
+/*
+ * Fill q[0..count) from the cache, reading each uncached run with read
+ * (through short cached stretches when the cost model says one command
+ * is cheaper, in reads of at most SUBQ_MAX_READ_FRAMES)
+ * Returns the number of leading frames filled, as a batch read would
+ */
+int subq_cache_read(subq_cache_t *cache, int32_t lba, int count,
+                    q_subchannel_t *q, subq_read_fn read, void *ctx);
+
+/*
+ * Add frames read from the drive outside subq_cache_read
+ * Frames that failed their CRC are not kept, so they are read again
+ */
+void subq_cache_store(subq_cache_t *cache, int32_t lba, int count,
+                      const q_subchannel_t *q);
+
+/* Frames served from the cache and stored after a drive read so far */
+void subq_cache_stats(const subq_cache_t *cache, long *hits, long *misses);
+
+/* Largest Q read issued as one command; longer runs are split */
+#define SUBQ_MAX_READ_FRAMES 256
+
+/*
+ * Drive read cost model, fitted by least squares to the drive's own Q
+ * reads once SUBQ_COST_MIN_READS are timed:
+ *   ms = command_ms + frame_ms * frames + seek_ms * distance / 100
+ * where distance is how far the read starts from the end of the one
+ * before. USB bridges show a large command_ms, internal drives a small one.
+ */
+#define SUBQ_COST_MIN_READS 8
+
+typedef struct {
+    double command_ms;      /* Fixed cost per command */
+    double frame_ms;        /* Per frame transferred */
+    double seek_ms;         /* Per 100 frames moved */
+    int reads;              /* Reads fitted */
+    int coalesced;          /* Ranges merged into a neighbour's read */
+} subq_cost_t;
+
+/* Record a drive Q read of count frames at lba that took ms */
+void subq_cache_observe(subq_cache_t *cache, int32_t lba, int count, double ms);
+
+/* Current model; false until SUBQ_COST_MIN_READS reads are fitted */
+bool subq_cache_cost(const subq_cache_t *cache, subq_cost_t *cost);
+
+/*
+ * Read planned ranges (ascending by lba) into the cache ahead of use,
+ * merging neighbours into one read where the model says reading through
+ * the gap is cheaper than another command and seek. Adjacent ranges
+ * always merge; before the model is fitted, nothing else does. Ranges
+ * left on their own are not read here.
+ */
+void subq_cache_prefetch(subq_cache_t *cache, const int32_t *lba, const int *count,
+                         int n, subq_read_fn read, void *ctx);
+
+/*
+ * Forget every drive's skew, cached frames and cost model; no device may
+ * be open (--repeat runs start from scratch)
+ */
+void subq_session_reset(void);
+
+/*
+ * Encode raw Q frames (used to synthesize subchannel for images that
+ * carry only a cue sheet). abs_lba is the absolute position of the frame;
+ * rel_frames is the running time within the track (negative in a pregap).
+ */
+void subq_encode_position(uint8_t *raw, uint8_t control, int track, int index,
+                          int32_t rel_frames, int32_t abs_lba);
+void subq_encode_mcn(uint8_t *raw, uint8_t control, const char *mcn, int32_t abs_lba);
+void subq_encode_isrc(uint8_t *raw, uint8_t control, const char *isrc, int32_t abs_lba);
+
+#endif /* MBDISCID_SUBQ_H */
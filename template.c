@@ -0,0 +1,263 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * template.c - Output templates (--format)
+ */
+
+#include "template.h"
+#include "toc.h"
+#include "discid.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    /* Disc fields */
+    F_MB_ID, F_FREEDB_ID, F_AR_ID, F_URL, F_MCN, F_TYPE,
+    F_FIRST, F_LAST, F_TRACKS, F_AUDIO_TRACKS, F_DATA_TRACKS, F_LEADOUT,
+    F_TOC_RAW, F_TOC_MB, F_TOC_AR, F_TOC_FREEDB, F_HTOA,
+    F_ALBUM, F_ALBUMARTIST, F_GENRE, F_SLOT,
+    /* Track fields */
+    F_TRACK_FIRST,
+    F_T_NUMBER = F_TRACK_FIRST, F_T_SESSION, F_T_TYPE, F_T_OFFSET, F_T_LENGTH,
+    F_T_ISRC, F_T_PREGAP, F_T_AR_V1, F_T_AR_V2, F_T_CRC32, F_T_VERDICT,
+    F_T_TITLE, F_T_ARTIST, F_T_COMPOSER,
+    F_COUNT
+} field_t;
+
+static const char *const field_names[F_COUNT] = {
+    "mb_id", "freedb_id", "ar_id", "url", "mcn", "type",
+    "first", "last", "tracks", "audio_tracks", "data_tracks", "leadout",
+    "toc_raw", "toc_mb", "toc_ar", "toc_freedb", "htoa",
+    "album", "albumartist", "genre", "slot",
+    "track.number", "track.session", "track.type", "track.offset", "track.length",
+    "track.isrc", "track.pregap", "track.ar_v1", "track.ar_v2", "track.crc32",
+    "track.verdict", "track.title", "track.artist", "track.composer"
+};
+
+/* Append a literal byte, merging with the previous literal op */
+static void add_literal(template_t *tpl, int *cap, char c, int *text_len)
+{
+    template_op_t *last = tpl->op_count ? &tpl->ops[tpl->op_count - 1] : NULL;
+
+    tpl->text[(*text_len)++] = c;
+    if (last && last->field < 0 && last->offset + last->length == *text_len - 1) {
+        last->length++;
+        return;
+    }
+
+    if (tpl->op_count == *cap) {
+        *cap *= 2;
+        tpl->ops = xrealloc(tpl->ops, (size_t)*cap * sizeof(*tpl->ops));
+    }
+    tpl->ops[tpl->op_count++] = (template_op_t){ -1, *text_len - 1, 1 };
+}
+
+static void add_field(template_t *tpl, int *cap, int field)
+{
+    if (tpl->op_count == *cap) {
+        *cap *= 2;
+        tpl->ops = xrealloc(tpl->ops, (size_t)*cap * sizeof(*tpl->ops));
+    }
+    tpl->ops[tpl->op_count++] = (template_op_t){ field, 0, 0 };
+    if (field >= F_TRACK_FIRST)
+        tpl->per_track = true;
+}
+
+int template_compile(template_t *tpl, const char *spec, bool quiet)
+{
+    int cap = 16, text_len = 0;
+
+    memset(tpl, 0, sizeof(*tpl));
+    tpl->ops = xmalloc((size_t)cap * sizeof(*tpl->ops));
+    tpl->text = xmalloc(strlen(spec) + 1);
+
+    for (const char *p = spec; *p; p++) {
+        if (*p == '\\' && p[1]) {
+            p++;
+            add_literal(tpl, &cap, *p == 't' ? '\t' : *p == 'n' ? '\n' : *p, &text_len);
+        } else if ((*p == '{' || *p == '}') && p[1] == *p) {
+            add_literal(tpl, &cap, *p++, &text_len);
+        } else if (*p == '{') {
+            const char *end = strchr(p, '}');
+            if (!end) {
+                error_quiet(quiet, "format: unterminated field: %s", p);
+                template_free(tpl);
+                return EX_USAGE;
+            }
+
+            size_t len = (size_t)(end - p - 1);
+            int field = 0;
+            while (field < F_COUNT &&
+                   !(strlen(field_names[field]) == len &&
+                     strncmp(field_names[field], p + 1, len) == 0))
+                field++;
+            if (field == F_COUNT) {
+                error_quiet(quiet, "format: unknown field: %.*s", (int)len, p + 1);
+                template_free(tpl);
+                return EX_USAGE;
+            }
+            add_field(tpl, &cap, field);
+            p = end;
+        } else if (*p == '}') {
+            error_quiet(quiet, "format: unmatched }");
+            template_free(tpl);
+            return EX_USAGE;
+        } else {
+            add_literal(tpl, &cap, *p, &text_len);
+        }
+    }
+    return 0;
+}
+
+void template_free(template_t *tpl)
+{
+    free(tpl->ops);
+    free(tpl->text);
+    tpl->ops = NULL;
+    tpl->text = NULL;
+    tpl->op_count = 0;
+}
+
+/* TOC strings and URL, formatted only if the template uses them */
+typedef struct {
+    char *toc[4];
+    char *url;
+} derived_t;
+
+static const char *toc_string(derived_t *d, const toc_t *toc, int which)
+{
+    if (!d->toc[which]) {
+        switch (which) {
+        case 0:  d->toc[0] = toc_format_raw(toc); break;
+        case 1:  d->toc[1] = toc_format_musicbrainz(toc); break;
+        case 2:  d->toc[2] = toc_format_accuraterip(toc); break;
+        default: d->toc[3] = toc_format_freedb(toc); break;
+        }
+    }
+    return d->toc[which];
+}
+
+static void append_string(record_buf_t *buf, const char *s)
+{
+    if (s)
+        record_buf_append(buf, s, strlen(s));
+}
+
+static void append_field(record_buf_t *buf, int field, const disc_info_t *disc, int i,
+                         derived_t *d)
+{
+    const toc_t *toc = &disc->toc;
+    const track_t *t = &toc->tracks[i];
+    const cdtext_album_t *album = disc->has_cdtext ? &disc->cdtext.album : NULL;
+    const cdtext_track_t *text = disc->has_cdtext && i < disc->cdtext.track_count ?
+                                 &disc->cdtext.tracks[i] : NULL;
+    const track_crc_t *crc = disc->has_crcs && disc->crcs[i].valid ? &disc->crcs[i] : NULL;
+    const track_index_t *index = disc->has_indexes && disc->indexes.tracks[i].mapped ?
+                                 &disc->indexes.tracks[i] : NULL;
+
+    switch ((field_t)field) {
+    case F_MB_ID:       append_string(buf, disc->ids.musicbrainz); break;
+    case F_FREEDB_ID:   append_string(buf, disc->ids.freedb); break;
+    case F_AR_ID:       append_string(buf, disc->ids.accuraterip); break;
+    case F_URL:
+        if (!d->url && disc->ids.musicbrainz[0])
+            d->url = get_musicbrainz_url(disc->ids.musicbrainz);
+        append_string(buf, d->url);
+        break;
+    case F_MCN:         append_string(buf, disc->has_mcn ? disc->ids.mcn : NULL); break;
+    case F_TYPE:        append_string(buf, disc_type_key(disc->type)); break;
+    case F_FIRST:        record_buf_printf(buf, "%d", toc->first_track); break;
+    case F_LAST:         record_buf_printf(buf, "%d", toc->last_track); break;
+    case F_TRACKS:       record_buf_printf(buf, "%d", toc->track_count); break;
+    case F_AUDIO_TRACKS: record_buf_printf(buf, "%d", toc->audio_count); break;
+    case F_DATA_TRACKS:  record_buf_printf(buf, "%d", toc->data_count); break;
+    case F_LEADOUT:      record_buf_printf(buf, "%d", toc->leadout); break;
+    case F_TOC_RAW:      append_string(buf, toc_string(d, toc, 0)); break;
+    case F_TOC_MB:       append_string(buf, toc_string(d, toc, 1)); break;
+    case F_TOC_AR:       append_string(buf, toc_string(d, toc, 2)); break;
+    case F_TOC_FREEDB:   append_string(buf, toc_string(d, toc, 3)); break;
+    case F_HTOA:
+        if (disc->has_indexes)
+            record_buf_printf(buf, "%d", disc->indexes.htoa_length);
+        break;
+    case F_ALBUM:        append_string(buf, album ? album->album : NULL); break;
+    case F_ALBUMARTIST:  append_string(buf, album ? album->albumartist : NULL); break;
+    case F_GENRE:        append_string(buf, album ? album->genre : NULL); break;
+    case F_SLOT:
+        if (disc->slot > 0)
+            record_buf_printf(buf, "%d", disc->slot);
+        break;
+
+    case F_T_NUMBER:     record_buf_printf(buf, "%d", t->number); break;
+    case F_T_SESSION:    record_buf_printf(buf, "%d", t->session); break;
+    case F_T_TYPE:
+        append_string(buf, t->type == TRACK_TYPE_DATA ? "data" : "audio");
+        break;
+    case F_T_OFFSET:     record_buf_printf(buf, "%d", t->offset); break;
+    case F_T_LENGTH:     record_buf_printf(buf, "%d", t->length); break;
+    case F_T_ISRC:       append_string(buf, t->isrc); break;
+    case F_T_PREGAP:
+        if (index)
+            record_buf_printf(buf, "%d", index->pregap);
+        break;
+    case F_T_AR_V1:
+        if (crc)
+            record_buf_printf(buf, "%08X", crc->ar_v1);
+        break;
+    case F_T_AR_V2:
+        if (crc)
+            record_buf_printf(buf, "%08X", crc->ar_v2);
+        break;
+    case F_T_CRC32:
+        if (crc)
+            record_buf_printf(buf, "%08X", crc->crc32);
+        break;
+    case F_T_VERDICT:
+        if (disc->has_checks && disc->checks[i].expected[0])
+            append_string(buf, isrc_verdict_name(disc->checks[i].verdict));
+        break;
+    case F_T_TITLE:      append_string(buf, text ? text->title : NULL); break;
+    case F_T_ARTIST:     append_string(buf, text ? text->artist : NULL); break;
+    case F_T_COMPOSER:   append_string(buf, text ? text->composer : NULL); break;
+    default:
+        break;
+    }
+}
+
+void template_execute(const template_t *tpl, const disc_info_t *disc, record_buf_t *buf)
+{
+    derived_t d = { { NULL } , NULL };
+    int lines = tpl->per_track ? disc->toc.track_count : 1;
+
+    for (int i = 0; i < lines; i++) {
+        for (int k = 0; k < tpl->op_count; k++) {
+            const template_op_t *op = &tpl->ops[k];
+            if (op->field < 0)
+                record_buf_append(buf, tpl->text + op->offset, (size_t)op->length);
+            else
+                append_field(buf, op->field, disc, i, &d);
+        }
+        record_buf_append(buf, "\n", 1);
+    }
+
+    for (int k = 0; k < 4; k++)
+        free(d.toc[k]);
+    free(d.url);
+}
+
+int template_output(const template_t *tpl, const disc_info_t *disc)
+{
+    record_buf_t buf;
+    int lines = tpl->per_track ? disc->toc.track_count : 1;
+
+    /* Literals plus room for the widest fields, per line */
+    record_buf_init(&buf, (size_t)lines * ((size_t)tpl->op_count * 32 + 128));
+    template_execute(tpl, disc, &buf);
+
+    int ret = record_buf_write(&buf);
+    record_buf_free(&buf);
+    return ret;
+}
@@ -0,0 +1,50 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * template.h - Output templates (--format)
+ */
+
+#ifndef MBDISCID_TEMPLATE_H
+#define MBDISCID_TEMPLATE_H
+
+#include "types.h"
+#include "record.h"
+
+/* One step of a compiled template */
+typedef struct {
+    int field;              /* Field to print, or -1 for literal text */
+    int offset;             /* Literal: start in template_t.text */
+    int length;             /* Literal: byte count */
+} template_op_t;
+
+/* Compiled template: literals unescaped into text, fields resolved */
+typedef struct {
+    template_op_t *ops;
+    int op_count;
+    char *text;
+    bool per_track;         /* References a track field: one line per track */
+} template_t;
+
+/*
+ * Compile spec: {field} or {track.field} placeholders, \t, \n and \\
+ * escapes, {{ and }} for literal braces
+ * Returns 0 on success, EX_USAGE (reported) if spec is invalid
+ */
+int template_compile(template_t *tpl, const char *spec, bool quiet);
+
+/*
+ * Append the lines tpl produces for disc (one per disc, or one per track
+ * if per_track) to buf
+ */
+void template_execute(const template_t *tpl, const disc_info_t *disc, record_buf_t *buf);
+
+/*
+ * Execute tpl for disc and write the result to stdout in one write()
+ * Returns 0 on success, EX_IOERR on error
+ */
+int template_output(const template_t *tpl, const disc_info_t *disc);
+
+void template_free(template_t *tpl);
+
+#endif /* MBDISCID_TEMPLATE_H */
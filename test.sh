@@ -468,6 +468,31 @@ test_raw_ar_id() {
     fi
 }
 
+# Write a CUE sheet and sparse BIN for an audio disc from its AR TOC,
+# carrying the disc's MCN and ISRCs
+make_cue_image() {
+    local -n disc=$1
+    local cue="$2"
+    local -a toc=(${disc[ar_toc]})
+    local count=${toc[0]}
+    local leadout=${toc[$((count + 3))]}
+    local bin="${cue%.cue}.bin"
+
+    truncate -s $((leadout * 2352)) "$bin"
+    {
+        [[ -n "${disc[mcn]}" ]] && echo "CATALOG ${disc[mcn]}"
+        echo "FILE \"$(basename "$bin")\" BINARY"
+        for ((i = 1; i <= count; i++)); do
+            local lba=${toc[$((i + 2))]}
+            local isrc
+            isrc=$(sed -n "s/^$i: //p" <<< "${disc[isrc_expected]}")
+            printf '  TRACK %02d AUDIO\n' "$i"
+            [[ -n "$isrc" ]] && echo "    ISRC $isrc"
+            printf '    INDEX 01 %02d:%02d:%02d\n' $((lba / 4500)) $((lba / 75 % 60)) $((lba % 75))
+        done
+    } > "$cue"
+}
+
 # =============================================================================
 # TEST CATEGORIES
 # =============================================================================
@@ -497,6 +522,7 @@ run_test_exit "--help exits 0" 0 "$MBDISCID" --help
 run_test_exit "-V exits 0" 0 "$MBDISCID" -V
 run_test_exit "--version exits 0" 0 "$MBDISCID" --version
 run_test_exit "-L exits 0" 0 "$MBDISCID" -L
+run_test_exit "-L --media exits 0" 0 "$MBDISCID" -L --media
 run_test_exit "no args fails" 64 "$MBDISCID"
 run_test_contains "-h shows Usage" "Usage:" "$MBDISCID" -h
 run_test_match "-V shows version" 'mbdiscid [0-9]+\.[0-9]+' "$MBDISCID" -V
@@ -581,6 +607,9 @@ echo -e "${YELLOW}=== Invalid Option Combinations ===${NC}"
 run_test_exit_contains "-Cc requires disc" 64 "cli: -C requires a disc" "$MBDISCID" -Cc
 run_test_exit_contains "-Ic requires disc" 64 "cli: -I requires a disc" "$MBDISCID" -Ic
 run_test_exit_contains "-Tc requires disc" 64 "cli: -T requires a disc" "$MBDISCID" -Tc
+run_test_exit_contains "-Gc requires disc" 64 "cli: -G requires a disc" "$MBDISCID" -Gc
+run_test_exit_contains "--cue -c requires disc" 64 "cli: --cue requires a disc" "$MBDISCID" --cue -c
+run_test_exit_contains "--text-files with -c" 64 "cli: -c and --text-files are mutually exclusive" "$MBDISCID" --text-files -c
 run_test_exit_contains "-Rc invalid" 64 "mutually exclusive" "$MBDISCID" -Rc 1 2 3000 150 1000
 run_test_exit_contains "-ac invalid" 64 "mutually exclusive" "$MBDISCID" -ac 1 2 3000 150 1000
 run_test_exit_contains "-Au invalid" 64 "not supported" "$MBDISCID" -Auc
@@ -597,6 +626,37 @@ run_test_exit_contains "--assume-audio without -A" 64 "cli: --assume-audio requi
 run_test_exit_contains "--assume-audio without -c" 64 "cli: --assume-audio requires -Ac" "$MBDISCID" --assume-audio -A /dev/cdrom
 run_test_exit_contains "--assume-audio with -Fc" 64 "cli: --assume-audio requires -Ac" "$MBDISCID" --assume-audio -Fc "3 150 1000 2000 45"
 
+# --read-offset requires --crc and a bounded integer
+run_test_exit_contains "--read-offset without --crc" 64 "cli: --read-offset requires --crc" "$MBDISCID" --read-offset=6 -A /dev/cdrom
+run_test_exit_contains "--read-offset not a number" 64 "cli: invalid read offset: 6x" "$MBDISCID" --crc --read-offset=6x /dev/cdrom
+run_test_exit_contains "--read-offset out of range" 64 "cli: invalid read offset: 9999" "$MBDISCID" --crc --read-offset=9999 /dev/cdrom
+run_test_exit_contains "--ar-db without -A or --crc" 64 "cli: --ar-db requires -A or --crc" "$MBDISCID" -F --ar-db=/tmp /dev/cdrom
+run_test_exit_contains "--media without -L" 64 "cli: --media requires -L" "$MBDISCID" --media /dev/cdrom
+run_test_exit_contains "--expect without -I" 64 "cli: --expect requires -I" "$MBDISCID" -M --expect=USWB19800782 /dev/cdrom
+run_test_exit_contains "--fail-fast without --expect" 64 "cli: --fail-fast requires --expect" "$MBDISCID" -I --fail-fast /dev/cdrom
+run_test_exit_contains "--isrc-profile without ISRCs" 64 "cli: --isrc-profile requires -I, -a or --cue" "$MBDISCID" -M --isrc-profile=fast /dev/cdrom
+run_test_exit_contains "--exclusive with -c" 64 "cli: --exclusive requires a device" "$MBDISCID" -M --exclusive -c "1 1 1000 150"
+run_test_exit_contains "--repeat with -c" 64 "cli: --repeat requires a device" "$MBDISCID" -M --repeat=3 -c "1 1 1000 150"
+run_test_exit_contains "--repeat count out of range" 64 "cli: invalid repeat count: 0" "$MBDISCID" -I --repeat=0 /dev/cdrom
+run_test_exit_contains "--output unknown format" 64 "cli: invalid output format: xml" "$MBDISCID" --output=xml /dev/cdrom
+run_test_exit_contains "--output with -o" 64 "cli: --output and -o are mutually exclusive" "$MBDISCID" -Mo --output=json /dev/cdrom
+run_test "--output=json with -c" '{"type":"audio","first_track":1,"last_track":1,"track_count":1,"audio_count":1,"data_count":0,"leadout":850,"toc":{"raw":"1 1 150 1000","musicbrainz":"1 1 1000 150","accuraterip":"1 1 1 0 850","freedb":"1 150 13"},"ids":{"musicbrainz":"pDvflfR79_Mmnb6n14OYq6LKs_U-","freedb":"02000b01","accuraterip":"001-00000352-000006a5-02000b01"},"url":"https://musicbrainz.org/cdtoc/pDvflfR79_Mmnb6n14OYq6LKs_U-","mcn":null,"tracks":[{"number":1,"session":1,"type":"audio","offset":0,"length":850}]}' \
+    "$MBDISCID" -c --output=json 1 1 1000 150
+run_test "--format disc template" "pDvflfR79_Mmnb6n14OYq6LKs_U- {1} 1 1 1 0 850" \
+    "$MBDISCID" -c --format='{mb_id} {{{tracks}}} {toc_ar}' 1 1 1000 150
+run_test "--format per-track template" "$(printf '0e008302\t1\t0\n0e008302\t2\t4850')" \
+    "$MBDISCID" -c --format='{freedb_id}\t{track.number}\t{track.offset}' 1 2 10000 150 5000
+run_test_exit_contains "--format unknown field" 64 "format: unknown field: isrc" "$MBDISCID" -c --format='{isrc}' 1 1 1000 150
+run_test_exit_contains "--format with --output" 64 "cli: --format and --output are mutually exclusive" \
+    "$MBDISCID" -c --format='{mb_id}' --output=json 1 1 1000 150
+run_test_exit_contains "--repeat unknown reset" 64 "cli: invalid repeat reset: park (not seek or flush)" "$MBDISCID" -I --repeat=3,park /dev/cdrom
+run_test_exit_contains "--eject-when-done with -c" 64 "cli: --eject-when-done requires a device" \
+    "$MBDISCID" --eject-when-done -c "1 1 1000 150"
+run_test_exit_contains "--drive without --changer" 64 "cli: --drive requires --changer" \
+    "$MBDISCID" --drive=/dev/sr0 /dev/cdrom
+run_test_exit_contains "--changer with a device" 64 "cli: --changer and a device argument are mutually exclusive" \
+    "$MBDISCID" --changer=/dev/sg3 /dev/cdrom
+
 # --assume-audio with raw TOC produces correct result (using Sublime)
 run_test "--assume-audio produces correct AR ID" "${SUBLIME[ar_id]}" \
     sh -c "echo '${SUBLIME[raw_toc]}' | '$MBDISCID' -Ac --assume-audio"
@@ -734,6 +794,358 @@ run_test "Here-string input" "${CRANBERRIES[ar_id]}" bash -c "'$MBDISCID' -Aic <
 # Command line arguments
 run_test "Args input" "${DADA[ar_id]}" "$MBDISCID" -Aic ${DADA[ar_toc]}
 
+# -----------------------------------------------------------------------------
+echo ""
+echo -e "${YELLOW}=== Disc Images ===${NC}"
+# -----------------------------------------------------------------------------
+
+IMAGE_DIR=$(mktemp -d)
+trap 'rm -rf "$IMAGE_DIR"' EXIT
+
+make_cue_image GGD "$IMAGE_DIR/ggd.cue"
+make_cue_image SUBLIME "$IMAGE_DIR/sublime.cue"
+
+run_test "GGD: CUE AccurateRip ID" "${GGD[ar_id]}" "$MBDISCID" -Ai "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE MusicBrainz ID" "${GGD[mb_id]}" "$MBDISCID" -Mi "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE MCN" "${GGD[mcn]}" "$MBDISCID" -C "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs" "${GGD[isrc_expected]}" "$MBDISCID" -I "$IMAGE_DIR/ggd.cue"
+run_test "Sublime: CUE FreeDB ID" "${SUBLIME[fb_id]}" "$MBDISCID" -Fi "$IMAGE_DIR/sublime.cue"
+run_test "Sublime: CUE ISRCs" "${SUBLIME[isrc_expected]}" "$MBDISCID" -I "$IMAGE_DIR/sublime.cue"
+echo "${GGD[isrc_expected]}" > "$IMAGE_DIR/ggd.isrc"
+run_test "GGD: CUE ISRCs verified" "$(sed 's/$/ match/' <<< "${GGD[isrc_expected]}")" \
+    "$MBDISCID" -I --expect="$IMAGE_DIR/ggd.isrc" "$IMAGE_DIR/ggd.cue"
+run_test_exit_contains "GGD: CUE ISRC mismatch" 65 "3: USWB19800799 mismatch USWB19800783" \
+    "$MBDISCID" -I --expect="USWB19800782 - USWB19800799" "$IMAGE_DIR/ggd.cue"
+run_test_exit_contains "GGD: CUE ISRC --fail-fast" 65 "3: USWB19800783 unchecked" \
+    "$MBDISCID" -I --fail-fast --expect="1: USWB19800799 3: USWB19800783" "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs with --exclusive" "${GGD[isrc_expected]}" "$MBDISCID" -I --exclusive "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs, fast profile" "${GGD[isrc_expected]}" "$MBDISCID" -I --isrc-profile=fast "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs, paranoid profile" "${GGD[isrc_expected]}" "$MBDISCID" -I --isrc-profile=paranoid "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs, tuned profile" "${GGD[isrc_expected]}" \
+    "$MBDISCID" -I --isrc-profile=fast,tranches=3,early-stop=0 "$IMAGE_DIR/ggd.cue"
+run_test_contains "GGD: CUE Q skew measured" "Q skew +0 frames" "$MBDISCID" -I -v "$IMAGE_DIR/ggd.cue"
+run_test_contains "GGD: CUE index map probes served from Q cache" "Q cache 48 hits, 53 misses" \
+    "$MBDISCID" --cue -v "$IMAGE_DIR/ggd.cue"
+run_test_contains "GGD: CUE --repeat runs agree" "repeat: 13 of 13 tracks consistent" \
+    "$MBDISCID" -I --repeat=3,seek "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE --repeat keeps the first run's output" "${GGD[isrc_expected]}" \
+    "$MBDISCID" -I -q --repeat=2 "$IMAGE_DIR/ggd.cue"
+run_test_contains "GGD: CUE --eject-when-done logs the cycle" "device: cycle" \
+    "$MBDISCID" -v --eject-when-done "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs, fixed tranches" "${GGD[isrc_expected]}" \
+    "$MBDISCID" -I --isrc-profile=balanced,adaptive=0 "$IMAGE_DIR/ggd.cue"
+run_test "GGD: CUE ISRCs, contiguous reads only" "${GGD[isrc_expected]}" \
+    "$MBDISCID" -I --isrc-profile=cadence=0 "$IMAGE_DIR/ggd.cue"
+run_test_exit_contains "GGD: unknown ISRC profile" 64 "isrc: unknown profile: quick" \
+    "$MBDISCID" -I --isrc-profile=quick "$IMAGE_DIR/ggd.cue"
+run_test_exit_contains "GGD: ISRC profile value out of range" 64 "isrc: invalid profile setting: frames=512" \
+    "$MBDISCID" -I --isrc-profile=balanced,frames=512 "$IMAGE_DIR/ggd.cue"
+
+# cdrdao TOC file with disc-level CD-Text, reusing the GGD main channel
+read -ra ggd_toc <<< "${GGD[ar_toc]}"
+{
+    echo "CD_DA"
+    echo "CATALOG \"${GGD[mcn]}\""
+    echo "CD_TEXT {"
+    echo "  LANGUAGE_MAP { 0 : EN }"
+    echo "  LANGUAGE 0 { TITLE \"Dizzy up the Girl\" PERFORMER \"Goo Goo Dolls\" }"
+    echo "}"
+    for ((i = 1; i <= ggd_toc[0]; i++)); do
+        echo "TRACK AUDIO"
+        if ((i == 1)); then
+            echo "SILENCE $((ggd_toc[3] * 588))"
+            echo "START"
+        fi
+        echo "FILE \"ggd.bin\" $((ggd_toc[i + 2] * 588)) $(((ggd_toc[i + 3] - ggd_toc[i + 2]) * 588))"
+    done
+} > "$IMAGE_DIR/ggd.toc"
+
+run_test "GGD: TOC file AccurateRip ID" "${GGD[ar_id]}" "$MBDISCID" -Ai "$IMAGE_DIR/ggd.toc"
+run_test "GGD: TOC file CD-Text" "ALBUM: Dizzy up the Girl
+ALBUMARTIST: Goo Goo Dolls" "$MBDISCID" -X "$IMAGE_DIR/ggd.toc"
+
+# Single-file CD-Extra: session 1 ends where track 3 starts in the file
+truncate -s $((30000 * 2352)) "$IMAGE_DIR/extra.bin"
+cat > "$IMAGE_DIR/extra.cue" <<'CUE'
+FILE "extra.bin" BINARY
+  TRACK 01 AUDIO
+    INDEX 01 00:00:00
+  TRACK 02 AUDIO
+    INDEX 01 02:00:00
+REM SESSION 02
+  TRACK 03 MODE1/2352
+    INDEX 01 05:00:00
+CUE
+
+run_test_contains "Extra: single-file CUE session 1 lead-out" \
+    "toc: multi-session, audio leadout = 22500 (session 1)" "$MBDISCID" -T -vv "$IMAGE_DIR/extra.cue"
+run_test_contains "Extra: single-file CUE data track after the session gap" \
+    " 2   3   07:34:00    33900  01:40:00      7500  data" "$MBDISCID" -T "$IMAGE_DIR/extra.cue"
+
+# Hidden track, pregap and sub-indices mapped from synthesized Q frames
+truncate -s $((30000 * 2352)) "$IMAGE_DIR/gaps.bin"
+cat > "$IMAGE_DIR/gaps.cue" <<'CUE'
+FILE "gaps.bin" BINARY
+  TRACK 01 AUDIO
+    ISRC USABC0000001
+    INDEX 00 00:00:00
+    INDEX 01 00:00:32
+  TRACK 02 AUDIO
+    INDEX 00 02:40:00
+    INDEX 01 02:42:10
+    INDEX 02 03:10:00
+    INDEX 03 03:20:05
+  TRACK 03 AUDIO
+    INDEX 01 04:00:00
+CUE
+
+run_test "Gaps: index map" "T#  I#        MSF      LBA     Length
+ 1  00   00:02:00        0  00:00:32  hidden
+ 1  01   00:02:32       32  02:39:43
+ 2  00   02:42:00    12000  00:02:10
+ 2  01   02:44:10    12160  00:27:65
+ 2  02   03:12:00    14250  00:10:05
+ 2  03   03:22:05    15005  00:39:70
+ 3  01   04:02:00    18000  02:40:00" "$MBDISCID" -G "$IMAGE_DIR/gaps.cue"
+run_test "GGD: track 1 INDEX 00 only" "T#  I#        MSF      LBA     Length
+ 1  00   00:02:00        0  00:00:32  hidden
+$(read -ra t <<< "${GGD[ar_toc]}"
+  for ((i = 1; i <= t[0]; i++)); do
+      s=${t[i + 2]} e=${t[i + 3]}
+      printf '%2d  01   %02d:%02d:%02d  %7d  %02d:%02d:%02d\n' $i \
+          $(((s + 150) / 4500)) $(((s + 150) / 75 % 60)) $(((s + 150) % 75)) $s \
+          $(((e - s) / 4500)) $(((e - s) / 75 % 60)) $(((e - s) % 75))
+  done)" "$MBDISCID" -G "$IMAGE_DIR/ggd.cue"
+run_test "Extra: index map stops at the session 1 lead-out" "T#  I#        MSF      LBA     Length
+ 1  01   00:02:00        0  02:00:00
+ 2  01   02:02:00     9000  03:00:00
+ 3  01   07:34:00    33900  01:40:00" "$MBDISCID" -G "$IMAGE_DIR/extra.cue"
+
+# CUE sheet from MCN, ISRC, CD-Text, flags and index map
+cat > "$IMAGE_DIR/sheet.cue" <<'CUE'
+CATALOG 0602517484016
+PERFORMER "The Band"
+TITLE "Album"
+FILE "gaps.bin" BINARY
+  TRACK 01 AUDIO
+    TITLE "One"
+    ISRC USABC0000001
+    INDEX 00 00:00:00
+    INDEX 01 00:00:32
+  TRACK 02 AUDIO
+    FLAGS DCP PRE
+    TITLE "Two"
+    SONGWRITER "Writer"
+    INDEX 00 02:40:00
+    INDEX 01 02:42:10
+    INDEX 02 03:10:00
+  TRACK 03 AUDIO
+    TITLE "Three"
+    INDEX 01 04:00:00
+CUE
+
+run_test "Sheet: CUE output" "REM DISCID 15019003
+REM COMMENT \"mbdiscid $("$MBDISCID" -V | sed 's/^mbdiscid \([^,]*\),.*/\1/')\"
+CATALOG 0602517484016
+PERFORMER \"The Band\"
+TITLE \"Album\"
+FILE \"CDImage.bin\" BINARY
+  TRACK 01 AUDIO
+    TITLE \"One\"
+    ISRC USABC0000001
+    INDEX 00 00:00:00
+    INDEX 01 00:00:32
+  TRACK 02 AUDIO
+    FLAGS DCP PRE
+    TITLE \"Two\"
+    SONGWRITER \"Writer\"
+    INDEX 00 02:40:00
+    INDEX 01 02:42:10
+    INDEX 02 03:10:00
+  TRACK 03 AUDIO
+    TITLE \"Three\"
+    INDEX 01 04:00:00" "$MBDISCID" --cue "$IMAGE_DIR/sheet.cue"
+run_test_contains "Extra: CUE session 2 placed after session 1 in the image" "  REM SESSION 02
+  TRACK 03 MODE1/2352
+    INDEX 01 05:00:00" "$MBDISCID" --cue "$IMAGE_DIR/extra.cue"
+
+run_test "Sheet: TSV record" "$(printf '%s\t' disc audio 3 3 0 30000 pj5WnYDj2CWQeOWaPxvphpohcRw- 15019003 \
+    003-0000eb20-000306d0-15019003 0602517484016 "1 3 182 12310 18150 30150" Album; echo "The Band"
+printf '%s\t' track 1 1 audio 32 12128 USABC0000001 0 "" "" One; echo
+printf '%s\t' track 2 1 audio 12160 5840 "" 12000 "" "" Two; echo
+printf '%s\t' track 3 1 audio 18000 12000 "" 18000 "" "" Three; echo)" \
+    "$MBDISCID" --cue --output=tsv "$IMAGE_DIR/sheet.cue"
+run_test_contains "Sheet: JSON record CD-Text" '"mcn":"0602517484016","htoa_length":32,"cdtext":{"album":"Album","albumartist":"The Band"}' \
+    "$MBDISCID" --cue --output=json "$IMAGE_DIR/sheet.cue"
+run_test_contains "Sheet: JSON record track" '{"number":2,"session":1,"type":"audio","offset":12160,"length":5840,"isrc":null,"pregap":12000,"indexes":[12160,14250],"title":"Two","lyricist":"Writer"}' \
+    "$MBDISCID" --cue --output=json "$IMAGE_DIR/sheet.cue"
+
+run_test "Sheet: --format per-track template" "$(printf '0602517484016 1 One USABC0000001 0\n0602517484016 2 Two  12000\n0602517484016 3 Three  18000')" \
+    "$MBDISCID" --cue --format='{mcn} {track.number} {track.title} {track.isrc} {track.pregap}' "$IMAGE_DIR/sheet.cue"
+
+# Simulated changer: slots in element order, the empty one skipped
+printf 'move 0.05\nslot ggd.cue\nslot\nslot sublime.cue\n' > "$IMAGE_DIR/batch.changer"
+run_test "Changer: template per slot" "$(printf '1 %s\n3 %s' "${GGD[mb_id]}" "${SUBLIME[mb_id]}")" \
+    "$MBDISCID" --changer="$IMAGE_DIR/batch.changer" --format='{slot} {mb_id}'
+run_test "Changer: text output per slot" "$(printf '===== Slot 1 =====\n%s\n\n===== Slot 3 =====\n%s' \
+    "${GGD[fb_id]}" "${SUBLIME[fb_id]}")" "$MBDISCID" -F --changer="$IMAGE_DIR/batch.changer"
+run_test_contains "Changer: batch timing" "changer: 2 of 2 discs identified" \
+    "$MBDISCID" -v --changer="$IMAGE_DIR/batch.changer"
+printf 'slot missing.cue\nslot ggd.cue\n' > "$IMAGE_DIR/partial.changer"
+run_test_exit_contains "Changer: unreadable slot skipped" 66 "changer: slot 1: cannot identify disc" \
+    "$MBDISCID" --changer="$IMAGE_DIR/partial.changer"
+
+# Generated sheet reads back to the same disc
+"$MBDISCID" --cue "$IMAGE_DIR/ggd.cue" > "$IMAGE_DIR/ggd-rt.cue"
+ln -sf ggd.bin "$IMAGE_DIR/CDImage.bin"
+run_test "GGD: CUE round trip" "$("$MBDISCID" --cue "$IMAGE_DIR/ggd.cue")" \
+    "$MBDISCID" --cue "$IMAGE_DIR/ggd-rt.cue"
+
+# CD-Text values repeated across tracks share storage; Latin-1 becomes UTF-8
+printf 'PERFORMER "Bj\xf6rk"\nTITLE "Album"\nFILE "gaps.bin" BINARY\n  TRACK 01 AUDIO\n    TITLE "  One "\n    PERFORMER "Bj\xf6rk"\n    INDEX 01 00:00:00\n  TRACK 02 AUDIO\n    TITLE "Two"\n    PERFORMER "Bj\xf6rk"\n    INDEX 01 02:42:10\n' \
+    > "$IMAGE_DIR/text.cue"
+run_test "Sheet: shared CD-Text values" "ALBUM: Album
+ALBUMARTIST: Björk
+
+1:
+TITLE: One
+ARTIST: Björk
+
+2:
+TITLE: Two
+ARTIST: Björk" "$MBDISCID" -X "$IMAGE_DIR/text.cue"
+
+# Archived CD-Text blobs: packs built here with their own CRC-16
+cdt_pack() {  # type track seq text ('|' = NUL) -> one 18-byte pack
+    local b=($1 $2 $3 0 $(printf '%s' "$4" | tr '|' '\0' | od -An -tu1 -v) 0 0 0 0 0 0 0 0 0 0 0 0)
+    local crc=0 i j
+    for ((i = 0; i < 16; i++)); do
+        ((crc ^= b[i] << 8))
+        for ((j = 0; j < 8; j++)); do
+            ((crc = crc & 0x8000 ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF))
+        done
+    done
+    b[16]=$((~crc >> 8 & 255)) b[17]=$((~crc & 255))
+    printf "$(printf '\\x%02x' "${b[@]:0:18}")"
+}
+{
+    cdt_pack 128 0 0 "Album|One|Tw"
+    cdt_pack 128 2 1 "o|"
+    cdt_pack 129 0 2 "Band|Band|Gu"
+    cdt_pack 129 2 3 "y|"
+    printf '\0'
+} > "$IMAGE_DIR/a.cdt"
+printf 'garbage' > "$IMAGE_DIR/bad.cdt"
+{ cdt_pack 128 0 0 "Other|"; cdt_pack 128 1 1 "Broken|" | head -c 17; printf 'x'; } > "$IMAGE_DIR/b.cdt"
+CDT_A="ALBUM: Album
+ALBUMARTIST: Band
+
+1:
+TITLE: One
+ARTIST: Band
+
+2:
+TITLE: Two
+ARTIST: Guy"
+run_test "CD-Text file" "$CDT_A" "$MBDISCID" --text-files "$IMAGE_DIR/a.cdt"
+run_test "CD-Text files in order, bad CRC skipped" "----- $IMAGE_DIR/a.cdt -----
+$CDT_A
+----- $IMAGE_DIR/b.cdt -----
+ALBUM: Other" "$MBDISCID" --text-files "$IMAGE_DIR/a.cdt" "$IMAGE_DIR/b.cdt"
+{
+    printf '\x00\x4a\x00\x00'; head -c 72 "$IMAGE_DIR/a.cdt"
+    printf '\x00\x14\x00\x00'; head -c 18 "$IMAGE_DIR/b.cdt"
+} > "$IMAGE_DIR/stream.bin"
+run_test "CD-Text response stream" "----- stdin:1 -----
+$CDT_A
+----- stdin:2 -----
+ALBUM: Other" sh -c "'$MBDISCID' --text-files < '$IMAGE_DIR/stream.bin'"
+run_test_exit_contains "CD-Text stream truncated" 65 "cdtext: stdin: truncated" \
+    sh -c "head -c 60 '$IMAGE_DIR/stream.bin' | '$MBDISCID' --text-files"
+run_test_exit_contains "CD-Text file malformed" 65 "bad.cdt: not a CD-Text file" \
+    "$MBDISCID" --text-files "$IMAGE_DIR/a.cdt" "$IMAGE_DIR/bad.cdt"
+run_test_exit_contains "CD-Text file missing" 66 "cdtext: cannot open" \
+    "$MBDISCID" --text-files "$IMAGE_DIR/none.cdt"
+
+# Audio checksums over a patterned BIN and the same PCM as a WAVE file
+yes mbdiscid | head -c $((3000 * 2352)) > "$IMAGE_DIR/pcm.bin"
+le32() { printf '\\x%02x\\x%02x\\x%02x\\x%02x' $(($1 & 255)) $(($1 >> 8 & 255)) $(($1 >> 16 & 255)) $(($1 >> 24 & 255)); }
+{
+    printf "RIFF$(le32 $((36 + 3000 * 2352)))WAVEfmt $(le32 16)\x01\x00\x02\x00$(le32 44100)$(le32 176400)\x04\x00\x10\x00data$(le32 $((3000 * 2352)))"
+    cat "$IMAGE_DIR/pcm.bin"
+} > "$IMAGE_DIR/pcm.wav"
+for f in bin wav; do
+    {
+        [[ $f == bin ]] && echo "FILE \"pcm.bin\" BINARY" || echo "FILE \"pcm.wav\" WAVE"
+        echo "  TRACK 01 AUDIO"
+        echo "    INDEX 01 00:00:00"
+        echo "  TRACK 02 AUDIO"
+        echo "    INDEX 00 00:10:00"
+        echo "    INDEX 01 00:12:00"
+        echo "  TRACK 03 AUDIO"
+        echo "    INDEX 01 00:30:10"
+    } > "$IMAGE_DIR/pcm-$f.cue"
+done
+
+PCM_CRC="T#  ARv1      ARv2      CRC32
+ 1  E2CA0D74  D5247D5D  58369A8B
+ 2  0D01334C  54DA6FAC  D81265A4
+ 3  FF97DA26  F76879AF  A722769E"
+run_test "PCM: BIN checksums" "$PCM_CRC" "$MBDISCID" --crc "$IMAGE_DIR/pcm-bin.cue"
+run_test "PCM: WAVE checksums" "$PCM_CRC" "$MBDISCID" --crc "$IMAGE_DIR/pcm-wav.cue"
+run_test "PCM: checksums with read offset" "T#  ARv1      ARv2      CRC32
+ 1  29A3135C  1BFEFCA2  CDC19DB3
+ 2  1EF69666  66CEA49D  93F0213E
+ 3  8596DA3A  7D66D681  977BB47E" "$MBDISCID" --crc --read-offset=6 "$IMAGE_DIR/pcm-bin.cue"
+run_test_exit_contains "Missing image file" 66 "image: cannot open" \
+    "$MBDISCID" -A "$IMAGE_DIR/missing.cue"
+
+# Local AccurateRip mirror: two pressings of the PCM disc, one matching
+# v1 and one v2, in the server's a/b/c directory layout
+mkdir -p "$IMAGE_DIR/ardb/0/1/8"
+{
+    printf "\x03$(le32 0x1810)$(le32 0x5065)$(le32 0x0c002803)"
+    printf "\x0c$(le32 0xE2CA0D74)$(le32 0x00ABCDEF)\x0c$(le32 0x0D01334C)$(le32 0)\x0c$(le32 0x12345678)$(le32 0)"
+    printf "\x03$(le32 0x1810)$(le32 0x5065)$(le32 0x0c002803)"
+    printf "\x03$(le32 0xD5247D5D)$(le32 0)\x02$(le32 0x54DA6FAC)$(le32 0)\x05$(le32 0xF76879AF)$(le32 0)"
+} > "$IMAGE_DIR/ardb/0/1/8/dBAR-003-00001810-00005065-0c002803.bin"
+run_test "ARDB: pressings from TOC" "003-00001810-00005065-0c002803
+P#  T#  Conf  CRC       Frame450
+ 1   1    12  E2CA0D74  00ABCDEF
+ 1   2    12  0D01334C  00000000
+ 1   3    12  12345678  00000000
+ 2   1     3  D5247D5D  00000000
+ 2   2     2  54DA6FAC  00000000
+ 2   3     5  F76879AF  00000000" "$MBDISCID" -Ac --ar-db="$IMAGE_DIR/ardb" 3 3 1 0 900 2260 3000
+run_test "ARDB: checksum confidence" "T#  ARv1      ARv2      CRC32     Conf
+ 1  E2CA0D74  D5247D5D  58369A8B    15
+ 2  0D01334C  54DA6FAC  D81265A4    14
+ 3  FF97DA26  F76879AF  A722769E     5" "$MBDISCID" --crc --ar-db="$IMAGE_DIR/ardb" "$IMAGE_DIR/pcm-bin.cue"
+run_test "ARDB: disc not in mirror" "003-00001810-00005065-0c002803" \
+    "$MBDISCID" -Ac --ar-db="$IMAGE_DIR" 3 3 1 0 900 2260 3000
+head -c 20 "$IMAGE_DIR/ardb/0/1/8/dBAR-003-00001810-00005065-0c002803.bin" > "$IMAGE_DIR/dBAR-003-00001810-00005065-0c002803.bin"
+run_test_exit_contains "ARDB: truncated file" 65 "malformed at byte 0" \
+    "$MBDISCID" -Ac --ar-db="$IMAGE_DIR" 3 3 1 0 900 2260 3000
+run_test_exit_contains "ARDB: missing mirror" 66 "ardb: cannot open" \
+    "$MBDISCID" -Ac --ar-db="$IMAGE_DIR/none" 3 3 1 0 900 2260 3000
+
+# -----------------------------------------------------------------------------
+# Calculation-only build (make calc), if present: same IDs, no device access
+MBDISCID_CALC="${MBDISCID_CALC:-./mbdiscid-calc}"
+if [[ -x "$MBDISCID_CALC" ]]; then
+    echo ""
+    echo -e "${YELLOW}=== Calculation-Only Build ===${NC}"
+
+    MBDISCID="$MBDISCID_CALC" test_mb_id GGD
+    MBDISCID="$MBDISCID_CALC" test_mb_id FREEDOM
+    MBDISCID="$MBDISCID_CALC" test_ar_id SUBLIME
+    MBDISCID="$MBDISCID_CALC" test_fb_id RUSH
+    run_test_exit_contains "calc: device rejected" 69 "mbdiscid-calc only calculates from TOC input" \
+        "$MBDISCID_CALC" -M /dev/cdrom
+    run_test_exit_contains "calc: -L rejected" 69 "mbdiscid-calc only calculates from TOC input" \
+        "$MBDISCID_CALC" -L
+fi
+
 # =============================================================================
 # DISC-BASED TESTS (only if device provided)
 # =============================================================================
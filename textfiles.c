@@ -0,0 +1,261 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * textfiles.c - Bulk CD-Text parsing from archived blobs
+ */
+
+#include "textfiles.h"
+#include "cdtext.h"
+#include "device.h"
+#include "output.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* Most worker threads started */
+#define TEXT_MAX_THREADS 16
+
+/* Blobs parsed ahead of the one being printed (bounds memory use) */
+#define TEXT_WINDOW      256
+
+/* One blob to parse */
+typedef struct {
+    char name[64];          /* Section name for stdin blobs */
+    const char *path;       /* File to read, or NULL for a stdin blob */
+    const uint8_t *data;    /* Stdin blob (points into the stream buffer) */
+    size_t len;
+    cdtext_t text;
+    int status;             /* 0, EX_NOINPUT or EX_DATAERR */
+    bool done;
+} text_job_t;
+
+/* Work queue shared by the workers and the printing thread */
+typedef struct {
+    text_job_t *jobs;
+    int count;
+    int next;               /* Next job to hand out */
+    int printed;            /* Jobs printed and freed */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int verbosity;
+} text_queue_t;
+
+/*
+ * Read a whole file or stream into memory
+ * Returns NULL on error
+ */
+static uint8_t *read_all(int fd, size_t *size)
+{
+    size_t cap = 4096, len = 0;
+    uint8_t *buf = xmalloc(cap);
+
+    for (;;) {
+        if (len == cap) {
+            cap *= 2;
+            buf = xrealloc(buf, cap);
+        }
+        ssize_t n = read(fd, buf + len, cap - len);
+        if (n < 0) {
+            free(buf);
+            return NULL;
+        }
+        if (n == 0)
+            break;
+        len += (size_t)n;
+    }
+
+    *size = len;
+    return buf;
+}
+
+/*
+ * Parse one blob into job->text
+ */
+static void parse_job(text_job_t *job, int verbosity)
+{
+    uint8_t *file = NULL;
+    const uint8_t *data = job->data;
+    size_t size = job->len;
+
+    if (job->path) {
+        int fd = open(job->path, O_RDONLY);
+        if (fd < 0) {
+            job->status = EX_NOINPUT;
+            return;
+        }
+        file = read_all(fd, &size);
+        close(fd);
+        if (!file) {
+            job->status = EX_NOINPUT;
+            return;
+        }
+        data = file;
+    }
+
+    size_t start, len;
+    if (!cdtext_locate_packs(size, &start, &len))
+        job->status = EX_DATAERR;
+    else
+        cdtext_parse(data + start, len, &job->text, verbosity);
+
+    free(file);
+}
+
+static void *worker_thread(void *arg)
+{
+    text_queue_t *q = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->next < q->count && q->next >= q->printed + TEXT_WINDOW)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (q->next >= q->count) {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+        text_job_t *job = &q->jobs[q->next++];
+        pthread_mutex_unlock(&q->lock);
+
+        parse_job(job, q->verbosity);
+
+        pthread_mutex_lock(&q->lock);
+        job->done = true;
+        pthread_cond_broadcast(&q->cond);
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    return NULL;
+}
+
+/*
+ * Split stdin into READ TOC format 5 responses
+ * Returns job count, or -1 if the stream is truncated
+ */
+static int split_stream(const uint8_t *buf, size_t size, text_job_t **jobs)
+{
+    int count = 0, cap = 0;
+    size_t pos = 0;
+
+    while (pos < size) {
+        /* Length field counts the bytes after itself */
+        size_t n = size - pos < 4 ? 0 : (((size_t)buf[pos] << 8) | buf[pos + 1]) + 2;
+        if (n < 4 || n > size - pos)
+            return -1;
+
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            *jobs = xrealloc(*jobs, (size_t)cap * sizeof(**jobs));
+        }
+        text_job_t *job = &(*jobs)[count++];
+        memset(job, 0, sizeof(*job));
+        snprintf(job->name, sizeof(job->name), "stdin:%d", count);
+        job->data = buf + pos;
+        job->len = n;
+        pos += n;
+    }
+
+    return count;
+}
+
+int textfiles_run(char **files, int file_count, bool quiet, int verbosity)
+{
+    text_job_t *jobs = NULL;
+    uint8_t *stream = NULL;
+    int count;
+
+    if (file_count > 0) {
+        count = file_count;
+        jobs = xcalloc((size_t)count, sizeof(*jobs));
+        for (int i = 0; i < count; i++)
+            jobs[i].path = files[i];
+    } else {
+        size_t size;
+        stream = read_all(STDIN_FILENO, &size);
+        if (!stream) {
+            error_quiet(quiet, "cdtext: cannot read stdin");
+            return EX_NOINPUT;
+        }
+        count = split_stream(stream, size, &jobs);
+        if (count < 0) {
+            error_quiet(quiet, "cdtext: stdin: truncated CD-Text response");
+            free(jobs);
+            free(stream);
+            return EX_DATAERR;
+        }
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    if (threads > TEXT_MAX_THREADS)
+        threads = TEXT_MAX_THREADS;
+    if (threads > count)
+        threads = count;
+
+    verbose(1, verbosity, "cdtext: %d blobs on %d threads", count, threads);
+
+    text_queue_t q = { .jobs = jobs, .count = count, .verbosity = verbosity };
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.cond, NULL);
+
+    pthread_t tid[TEXT_MAX_THREADS];
+    int started = 0;
+    while (started < threads &&
+           pthread_create(&tid[started], NULL, worker_thread, &q) == 0)
+        started++;
+
+    /* No thread could be started: parse on this one */
+    if (started == 0)
+        worker_thread(&q);
+
+    /* Print in input order as blobs complete */
+    disc_info_t *disc = xmalloc(sizeof(*disc));
+    int ret = 0;
+    for (int i = 0; i < count; i++) {
+        text_job_t *job = &jobs[i];
+
+        pthread_mutex_lock(&q.lock);
+        while (!job->done)
+            pthread_cond_wait(&q.cond, &q.lock);
+        pthread_mutex_unlock(&q.lock);
+
+        const char *name = job->path ? job->path : job->name;
+        if (job->status == EX_NOINPUT) {
+            error_quiet(quiet, "cdtext: cannot open %s", name);
+            ret = job->status;
+        } else if (job->status == EX_DATAERR) {
+            error_quiet(quiet, "cdtext: %s: not a CD-Text file", name);
+            ret = job->status;
+        } else {
+            memset(disc, 0, sizeof(*disc));
+            disc->cdtext = job->text;
+            disc->has_cdtext = cdtext_has_text(&job->text);
+
+            if (count > 1)
+                output_section_header(name);
+            output_text(disc);
+        }
+        cdtext_free(&job->text);
+
+        pthread_mutex_lock(&q.lock);
+        q.printed = i + 1;
+        pthread_cond_broadcast(&q.cond);
+        pthread_mutex_unlock(&q.lock);
+    }
+
+    for (int i = 0; i < started; i++)
+        pthread_join(tid[i], NULL);
+
+    free(disc);
+    pthread_cond_destroy(&q.cond);
+    pthread_mutex_destroy(&q.lock);
+    free(jobs);
+    free(stream);
+
+    return ret;
+}
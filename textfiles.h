@@ -0,0 +1,27 @@
+/*
+ * mbdiscid - Disc ID calculator
+ * Copyright (C) 2025 Ian McNish
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ * textfiles.h - Bulk CD-Text parsing from archived blobs
+ */
+
+#ifndef MBDISCID_TEXTFILES_H
+#define MBDISCID_TEXTFILES_H
+
+#include "types.h"
+
+/*
+ * Parse CD-Text blobs and print each as Text mode (-X) would:
+ * - files: cdrdao .cdt files or saved READ TOC format 5 responses
+ * - With no files, stdin is read as a stream of READ TOC format 5
+ *   responses, each framed by its own length header
+ * - Blobs are parsed on a pool of threads and printed in input order,
+ *   each under a section header when there is more than one
+ *
+ * Returns 0 if every blob was parsed
+ * Returns EX_NOINPUT or EX_DATAERR (the last failure) otherwise; failed
+ * blobs are reported and skipped
+ */
+int textfiles_run(char **files, int file_count, bool quiet, int verbosity);
+
+#endif /* MBDISCID_TEXTFILES_H */
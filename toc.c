@@ -942,6 +942,31 @@ int32_t toc_get_audio_leadout(const toc_t *toc)
     return toc->audio_leadout;
 }
 
+/*
+ * Get where a session's lead-out starts
+ */
+int32_t toc_get_session_leadout(const toc_t *toc, int session)
+{
+    if (session >= 1 && session <= MAX_SESSIONS && toc->session_leadouts[session - 1] > 0)
+        return toc->session_leadouts[session - 1];
+    return session >= toc->last_session ? toc->leadout : 0;
+}
+
+/*
+ * Get where track index i ends
+ */
+int32_t toc_get_track_end(const toc_t *toc, int i)
+{
+    const track_t *t = &toc->tracks[i];
+    int32_t end = t->offset + t->length;
+
+    if (i + 1 < toc->track_count && toc->tracks[i + 1].session == t->session)
+        return end;
+
+    int32_t leadout = toc_get_session_leadout(toc, t->session);
+    return leadout > t->offset && leadout < end ? leadout : end;
+}
+
 /*
  * Get first audio track number
  */
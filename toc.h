@@ -98,6 +98,18 @@ char *toc_format_freedb(const toc_t *toc);
  */
 int32_t toc_get_audio_leadout(const toc_t *toc);
 
+/*
+ * Get where a session's lead-out starts: from the full TOC, or the disc
+ * leadout for the last session; 0 if unknown
+ */
+int32_t toc_get_session_leadout(const toc_t *toc, int session);
+
+/*
+ * Get where track index i ends: its TOC length, or the session lead-out
+ * for a session's last track, whose length runs through the session gap
+ */
+int32_t toc_get_track_end(const toc_t *toc, int i);
+
 /*
  * Get first audio track number
  */
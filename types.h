@@ -16,6 +16,8 @@
 #define MAX_TRACKS      99
 #define ISRC_LENGTH     12
 #define MCN_LENGTH      13
+#define MAX_INDEX       99
+#define MAX_SESSIONS    10  /* Sessions whose lead-out is kept */
 #define MB_ID_LENGTH    28
 #define FREEDB_ID_LENGTH 8
 #define AR_ID_LENGTH    32  /* NNN-XXXXXXXX-XXXXXXXX-XXXXXXXX */
@@ -23,6 +25,14 @@
 /* CD constants */
 #define FRAMES_PER_SECOND   75
 #define PREGAP_FRAMES       150
+#define RAW_SECTOR_SIZE     2352    /* Bytes of CD-DA per frame */
+#define SAMPLES_PER_FRAME   588     /* 16-bit stereo samples per frame */
+#define MAX_READ_OFFSET     (10 * SAMPLES_PER_FRAME)  /* --read-offset limit */
+#define MAX_REPEAT          100     /* --repeat limit */
+#define MAX_CHANGER_ELEMENTS 1024   /* Media changer elements read */
+
+/* Lead-out (6750) + lead-in (4500) + pregap (150) between sessions */
+#define SESSION_GAP_FRAMES  11400
 
 /* Disc types */
 typedef enum {
@@ -50,7 +60,11 @@ typedef enum {
     MODE_ACCURATERIP= (1 << 5),   /* -A */
     MODE_FREEDB     = (1 << 6),   /* -F */
     MODE_MUSICBRAINZ= (1 << 7),   /* -M */
-    MODE_ALL        = (1 << 8)    /* -a */
+    MODE_ALL        = (1 << 8),   /* -a */
+    MODE_GAPS       = (1 << 9),   /* -G */
+    MODE_CUE        = (1 << 10),  /* --cue */
+    MODE_CRC        = (1 << 11),  /* --crc */
+    MODE_TEXT_FILES = (1 << 12)   /* --text-files */
 } cli_mode_t;
 
 /* Action flags (may be combined) */
@@ -84,9 +98,17 @@ typedef struct {
     int32_t leadout;        /* Leadout LBA */
     int32_t audio_leadout;  /* Audio session leadout (for Enhanced CDs) */
     int last_session;       /* Last session number */
+    int32_t session_leadouts[MAX_SESSIONS]; /* From the full TOC, 0 if unknown */
     track_t tracks[MAX_TRACKS];
 } toc_t;
 
+/* Bump allocator: many small allocations released together (util.h) */
+typedef struct arena_block arena_block_t;
+
+typedef struct {
+    arena_block_t *head;    /* Block being filled, NULL if none yet */
+} arena_t;
+
 /* CD-Text tags (album and track level) */
 typedef struct {
     char *album;
@@ -112,8 +134,49 @@ typedef struct {
     cdtext_album_t album;
     cdtext_track_t tracks[MAX_TRACKS];
     int track_count;
+    arena_t arena;          /* Owns every string above; equal strings are shared */
 } cdtext_t;
 
+/* Index map for one track (LBAs, 0-based) */
+typedef struct {
+    bool mapped;            /* False if the track could not be probed */
+    int32_t pregap;         /* INDEX 00 start, equal to index[1] if no pregap */
+    int index_count;        /* Highest index number (1 = INDEX 01 only) */
+    int32_t index[MAX_INDEX + 1];  /* INDEX nn start; index[1] is the TOC offset */
+} track_index_t;
+
+/* Index map (pregaps, sub-indices and hidden track) */
+typedef struct {
+    track_index_t tracks[MAX_TRACKS];   /* Parallel to toc_t.tracks */
+    int32_t htoa_length;    /* Hidden track one audio frames (0 = none) */
+    int probes;             /* Q-subchannel probes issued */
+} index_map_t;
+
+/* Audio checksums for one track */
+typedef struct {
+    bool valid;             /* False for data tracks or unread audio */
+    uint32_t ar_v1;         /* AccurateRip v1 CRC */
+    uint32_t ar_v2;         /* AccurateRip v2 CRC */
+    uint32_t crc32;         /* CRC-32 of the whole track (EAC copy CRC) */
+} track_crc_t;
+
+/* Outcome of checking a track against its expected ISRC (--expect) */
+typedef enum {
+    ISRC_UNCHECKED = 0,     /* No expectation, or skipped by --fail-fast */
+    ISRC_MATCH,             /* Confirmed at the verification confidence */
+    ISRC_MISMATCH,          /* Refuted at the verification confidence */
+    ISRC_MISSING,           /* No ISRC frames within the read budget */
+    ISRC_UNDECIDED          /* Budget spent without a decision */
+} isrc_verdict_t;
+
+/* ISRC verification of one track */
+typedef struct {
+    char expected[ISRC_LENGTH + 1];     /* Empty if the track is not checked */
+    char found[ISRC_LENGTH + 1];        /* Most frequent other ISRC, if any */
+    isrc_verdict_t verdict;
+    int frames;             /* Q frames read */
+} isrc_check_t;
+
 /* Disc identifiers */
 typedef struct {
     char musicbrainz[MB_ID_LENGTH + 1];
@@ -128,11 +191,32 @@ typedef struct {
     toc_t toc;
     cdtext_t cdtext;
     disc_ids_t ids;
+    index_map_t indexes;
+    track_crc_t crcs[MAX_TRACKS];       /* Parallel to toc_t.tracks */
+    isrc_check_t checks[MAX_TRACKS];    /* Parallel to toc_t.tracks */
     bool has_cdtext;
     bool has_mcn;
     bool has_isrc;
+    bool has_indexes;
+    bool has_crcs;
+    bool has_checks;
+    int slot;                           /* Changer slot (--changer), 0 if none */
 } disc_info_t;
 
+/* Drive reset between --repeat runs */
+typedef enum {
+    REPEAT_RESET_NONE,      /* Session state only */
+    REPEAT_RESET_SEEK,      /* Also move the head to the end of the disc */
+    REPEAT_RESET_FLUSH      /* Also evict the drive's read cache */
+} repeat_reset_t;
+
+/* Output format (--output) */
+typedef enum {
+    OUTPUT_TEXT = 0,        /* Per-mode text (default) */
+    OUTPUT_JSON,            /* One JSON object per line */
+    OUTPUT_TSV              /* Tab-separated disc and track rows */
+} output_format_t;
+
 /* Command-line options */
 typedef struct {
     cli_mode_t mode;
@@ -141,9 +225,26 @@ typedef struct {
     bool quiet;             /* -q: suppress errors */
     int verbosity;          /* -v count */
     bool list_drives;       /* -L */
+    bool media;             /* --media: probe media state with -L */
     bool help;              /* -h */
     bool version;           /* -V */
     bool assume_audio;      /* --assume-audio: allow raw TOC in AR mode */
+    int read_offset;        /* --read-offset: drive read offset in samples */
+    bool has_read_offset;
+    const char *ar_db;      /* --ar-db: local AccurateRip mirror or NULL */
+    bool exclusive;         /* --exclusive: quiesce the drive while reading */
+    const char *expect;     /* --expect: expected ISRCs (file or list) or NULL */
+    bool fail_fast;         /* --fail-fast: stop verifying at first mismatch */
+    const char *isrc_profile; /* --isrc-profile: ISRC sampling profile or NULL */
+    int repeat;             /* --repeat: acquisitions to compare (0: off) */
+    repeat_reset_t repeat_reset;
+    output_format_t output; /* --output: record format (text: per-mode output) */
+    const char *format;     /* --format: output template or NULL */
+    bool eject;             /* --eject-when-done: eject once the disc is read */
+    const char *changer;    /* --changer: media changer or .changer file, or NULL */
+    const char *drive;      /* --drive: the changer's drive */
+    char **files;           /* --text-files: CD-Text files (stdin if none) */
+    int file_count;
     const char *device;     /* Device path or NULL */
     const char *cdtoc;      /* CDTOC string or NULL (stdin if -c alone) */
 } options_t;
@@ -6,10 +6,58 @@
  */
 
 #include "util.h"
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Verbose output buffer */
+#define LOG_BUFFER_SIZE     (64 * 1024)
+#define LOG_LINE_MAX        1024
+#define LOG_FLUSH_INTERVAL  0.25
+
+static struct {
+    pthread_mutex_t lock;   /* Probe and audio threads log too */
+    char data[LOG_BUFFER_SIZE];
+    size_t len;
+    bool started;           /* Flusher thread and atexit handler installed */
+} log_buf = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/* Write out the buffer; caller holds the lock */
+static void log_write(void)
+{
+    size_t done = 0;
+    while (done < log_buf.len) {
+        ssize_t n = write(STDERR_FILENO, log_buf.data + done, log_buf.len - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += (size_t)n;
+    }
+    log_buf.len = 0;
+}
+
+/*
+ * Drain the buffer every LOG_FLUSH_INTERVAL, so a line logged before a
+ * stalled command shows while it stalls, without the writes landing
+ * between the commands being timed
+ */
+static void *log_flusher(void *arg)
+{
+    (void)arg;
+    struct timespec interval = { 0, (long)(LOG_FLUSH_INTERVAL * 1e9) };
+    for (;;) {
+        nanosleep(&interval, NULL);
+        verbose_flush();
+    }
+    return NULL;
+}
 
 /*
  * Print error message to stderr with program prefix
@@ -17,6 +65,7 @@
 void error(const char *fmt, ...)
 {
     va_list ap;
+    verbose_flush();
     fprintf(stderr, "mbdiscid: ");
     va_start(ap, fmt);
     vfprintf(stderr, fmt, ap);
@@ -33,6 +82,7 @@ void error_quiet(bool quiet, const char *fmt, ...)
         return;
 
     va_list ap;
+    verbose_flush();
     fprintf(stderr, "mbdiscid: ");
     va_start(ap, fmt);
     vfprintf(stderr, fmt, ap);
@@ -41,18 +91,47 @@ void error_quiet(bool quiet, const char *fmt, ...)
 }
 
 /*
- * Print verbose message if verbosity level is sufficient
+ * Append a verbose message to the log buffer (see verbose() in util.h)
  */
-void verbose(int level, int current_verbosity, const char *fmt, ...)
+void verbose_log(const char *fmt, ...)
 {
-    if (current_verbosity < level)
-        return;
-
+    char line[LOG_LINE_MAX];
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(stderr, fmt, ap);
+    int n = vsnprintf(line, sizeof(line) - 1, fmt, ap);
     va_end(ap);
-    fprintf(stderr, "\n");
+    if (n < 0)
+        return;
+    if ((size_t)n > sizeof(line) - 2)
+        n = (int)sizeof(line) - 2;
+    line[n++] = '\n';
+
+    pthread_mutex_lock(&log_buf.lock);
+    if (!log_buf.started) {
+        /* Without the thread, output still goes out when the buffer
+         * fills, before errors and at exit */
+        log_buf.started = true;
+        atexit(verbose_flush);
+        pthread_t flusher;
+        if (pthread_create(&flusher, NULL, log_flusher, NULL) == 0)
+            pthread_detach(flusher);
+    }
+    if (log_buf.len + (size_t)n > sizeof(log_buf.data))
+        log_write();
+    memcpy(log_buf.data + log_buf.len, line, (size_t)n);
+    log_buf.len += (size_t)n;
+    pthread_mutex_unlock(&log_buf.lock);
+}
+
+/*
+ * Write out buffered verbose messages
+ */
+void verbose_flush(void)
+{
+    pthread_mutex_lock(&log_buf.lock);
+    if (log_buf.len > 0)
+        log_write();
+    pthread_mutex_unlock(&log_buf.lock);
 }
 
 /*
@@ -94,6 +173,81 @@ void *xrealloc(void *ptr, size_t size)
     return new_ptr;
 }
 
+/* Smallest block an arena allocates */
+#define ARENA_BLOCK_SIZE 4096
+
+struct arena_block {
+    arena_block_t *next;    /* Previous (full) block */
+    size_t size;            /* Usable bytes */
+    size_t used;
+    size_t last;            /* Offset of the most recent allocation */
+    max_align_t data[];
+};
+
+/*
+ * Allocate from an arena or exit on failure
+ * Allocations are aligned for any type and live until arena_free()
+ */
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    arena_block_t *b = arena->head;
+    size_t align = _Alignof(max_align_t);
+    size_t offset = b ? (b->used + align - 1) & ~(align - 1) : 0;
+
+    if (!b || size > b->size - offset) {
+        size_t block = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        b = xmalloc(sizeof(*b) + block);
+        b->next = arena->head;
+        b->size = block;
+        arena->head = b;
+        offset = 0;
+    }
+
+    b->last = offset;
+    b->used = offset + size;
+    return (unsigned char *)b->data + offset;
+}
+
+/*
+ * Shrink the most recent allocation to size bytes (0 returns it all)
+ * Lets a caller reserve a worst case and give back what it did not use
+ */
+void arena_shrink(arena_t *arena, void *ptr, size_t size)
+{
+    arena_block_t *b = arena->head;
+
+    if (b && ptr == (unsigned char *)b->data + b->last && b->last + size <= b->used)
+        b->used = b->last + size;
+}
+
+/*
+ * Release every allocation of an arena at once
+ */
+void arena_free(arena_t *arena)
+{
+    arena_block_t *b = arena->head;
+
+    while (b) {
+        arena_block_t *next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head = NULL;
+}
+
+/*
+ * Free CD-Text structure
+ */
+void cdtext_free(cdtext_t *cdtext)
+{
+    if (!cdtext)
+        return;
+
+    /* Every string lives in the arena */
+    arena_free(&cdtext->arena);
+    memset(cdtext, 0, sizeof(*cdtext));
+}
+
 /*
  * Duplicate string or exit on failure
  */
@@ -231,3 +385,13 @@ void lba_to_msf(int32_t lba, int *m, int *s, int *f)
     *s = total_seconds % 60;
     *m = total_seconds / 60;
 }
+
+/*
+ * Seconds on the monotonic clock (arbitrary epoch)
+ */
+double monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
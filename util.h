@@ -15,8 +15,24 @@
 void error(const char *fmt, ...);
 void error_quiet(bool quiet, const char *fmt, ...);
 
-/* Verbose output (to stderr) */
-void verbose(int level, int current_verbosity, const char *fmt, ...);
+/*
+ * Verbose output (to stderr), buffered in memory and written in batches:
+ * when the buffer fills, before an error message, at exit, and by a
+ * background thread every LOG_FLUSH_INTERVAL seconds. Output still
+ * buffered when the process crashes is lost. The level check is
+ * inline, so a disabled message costs one branch and its arguments are
+ * not evaluated.
+ */
+#define verbose(level, current_verbosity, ...) \
+    do { \
+        if ((current_verbosity) >= (level)) \
+            verbose_log(__VA_ARGS__); \
+    } while (0)
+
+void verbose_log(const char *fmt, ...);
+
+/* Write buffered verbose output now (before other direct stderr output) */
+void verbose_flush(void);
 
 /* Memory allocation with error checking */
 void *xmalloc(size_t size);
@@ -24,6 +40,14 @@ void *xcalloc(size_t nmemb, size_t size);
 void *xrealloc(void *ptr, size_t size);
 char *xstrdup(const char *s);
 
+/* Arena allocation (zero-initialized arena_t is empty) */
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_shrink(arena_t *arena, void *ptr, size_t size);
+void arena_free(arena_t *arena);
+
+/* Free CD-Text structure (every string lives in its arena) */
+void cdtext_free(cdtext_t *cdtext);
+
 /* String utilities */
 char *trim(char *str);
 bool is_all_digits(const char *str);
@@ -37,4 +61,7 @@ int32_t frames_to_seconds(int32_t frames);
 /* MSF formatting */
 void lba_to_msf(int32_t lba, int *m, int *s, int *f);
 
+/* Monotonic clock in seconds, for timing and timeouts */
+double monotonic_seconds(void);
+
 #endif /* MBDISCID_UTIL_H */